@@ -123,6 +123,10 @@ int LoadConfig()
 	GetValueld("RCntFix", Config.RCntFix);
 	GetValueld("UseNet", Config.UseNet);
 	GetValueld("VSyncWA", Config.VSyncWA);
+	GetValueld("FastBoot", Config.FastBoot);
+	GetValueld("CdTurbo", Config.CdTurbo);
+	GetValueld("CdTiming", Config.CdTiming);
+	GetValueld("XaResample", Config.XaResample);
 	
 	GetValuel("LastDevice", Settings.device);
 
@@ -180,6 +184,10 @@ void SaveConfig() {
 	SetValueld("RCntFix", Config.RCntFix);
 	SetValueld("UseNet", Config.UseNet);
 	SetValueld("VSyncWA", Config.VSyncWA);
+	SetValueld("FastBoot", Config.FastBoot);
+	SetValueld("CdTurbo", Config.CdTurbo);
+	SetValueld("CdTiming", Config.CdTiming);
+	SetValueld("XaResample", Config.XaResample);
 
 	SetValuel("LastDevice", Settings.device);
 
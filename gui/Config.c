@@ -123,6 +123,10 @@ int LoadConfig(PcsxConfig *Conf) {
 	GetValuel(data, "SpuIrq",  &Config.SpuIrq);
 	GetValuel(data, "RCntFix", &Config.RCntFix);
 	GetValuel(data, "VSyncWA", &Config.VSyncWA);
+	GetValuel(data, "FastBoot", &Config.FastBoot);
+	GetValuel(data, "CdTurbo", &Config.CdTurbo);
+	GetValuel(data, "CdTiming", &Config.CdTiming);
+	GetValuel(data, "XaResample", &Config.XaResample);
 
 	free(data);
 
@@ -161,6 +165,10 @@ void SaveConfig() {
 	SetValuel("SpuIrq",  Config.SpuIrq);
 	SetValuel("RCntFix", Config.RCntFix);
 	SetValuel("VSyncWA", Config.VSyncWA);
+	SetValuel("FastBoot", Config.FastBoot);
+	SetValuel("CdTurbo", Config.CdTurbo);
+	SetValuel("CdTiming", Config.CdTiming);
+	SetValuel("XaResample", Config.XaResample);
 
 	fclose(f);
 }
@@ -35,6 +35,7 @@
 #include "../libpcsxcore/plugins.h"
 #include "../libpcsxcore/r3000a.h"
 #include "../libpcsxcore/debug.h"
+#include "../libpcsxcore/cdrtrace.h"
 
 #include "Linux.h"
 #include "ConfDlg.h"
@@ -274,6 +275,7 @@ void set_default_plugin (char *plugin_name, char *conf_plugin_name) {
 
 int main(int argc, char *argv[]) {
 	char file[MAXPATHLEN] = "";
+	char cdtracefile[MAXPATHLEN] = "";
 	char path[MAXPATHLEN];
 	int runcd = RUN;
 	int loadst = 0;
@@ -315,6 +317,10 @@ int main(int argc, char *argv[]) {
 			}
 			runcd = RUN_CD;
 		}
+		else if (!strcmp(argv[i], "-cdtrace")) {
+			if (i+1 >= argc) break;
+			strncpy(cdtracefile, argv[++i], MAXPATHLEN);
+		}
 		else if (!strcmp(argv[i], "-h") ||
 			 !strcmp(argv[i], "-help") ||
 			 !strcmp(argv[i], "--help")) {
@@ -328,6 +334,7 @@ int main(int argc, char *argv[]) {
 							"\t-cfg FILE\tLoads desired configuration file (default: ~/.pcsx/pcsx.cfg)\n"
 							"\t-psxout\t\tEnable PSX output\n"
 							"\t-load STATENUM\tLoads savestate STATENUM (1-5)\n"
+							"\t-cdtrace FILE\tLogs CD-ROM commands and reads to FILE\n"
 							"\t-h -help\tDisplay this message\n"
 							"\tfile\t\tLoads file\n"));
 			 return 0;
@@ -404,6 +411,8 @@ int main(int argc, char *argv[]) {
 
 	if (SysInit() == -1) return 1;
 
+	if (cdtracefile[0] != '\0') cdrTraceOpen(cdtracefile);
+
 	if (UseGui) {
 		StartGui();
 	} else {
@@ -487,6 +496,7 @@ void SysClose() {
 	ReleasePlugins();
 
 	StopDebugger();
+	cdrTraceClose();
 
 	if (emuLog != NULL) fclose(emuLog);
 }
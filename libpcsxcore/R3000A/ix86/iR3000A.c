@@ -24,6 +24,7 @@
 
 #include "ix86.h"
 #include "../psxhw.h"
+#include "../spu.h"
 #include <sys/mman.h>
 
 #ifndef MAP_ANONYMOUS
@@ -1343,7 +1344,7 @@ static void recLHU() {
 				iRegs[_Rt_].state = ST_UNK;
 
 				PUSH32I  (addr);
-				CALL32M  ((u32)&SPU_readRegister);
+				CALLFunc ((u32)spuReadRegister);
 				MOVZX32R16toR(EAX, EAX);
 				MOV32RtoM((u32)&psxRegs.GPR.r[_Rt_], EAX);
 #ifndef __WIN32__
@@ -1780,7 +1781,7 @@ static void recSH() {
 					PUSH32M((u32)&psxRegs.GPR.r[_Rt_]);
 				}
 				PUSH32I  (addr);
-				CALL32M  ((u32)&SPU_writeRegister);
+				CALLFunc ((u32)spuWriteRegister);
 #ifndef __WIN32__
 				resp+= 8;
 #endif
@@ -27,6 +27,7 @@
 #include "psxhle.h"
 #include "psxhw.h"
 #include "psxcounters.h"
+#include "spu.h"
 #include "plugins.h"
 #include "psxcommon.h"
 #include <sys/mman.h>
@@ -1239,8 +1240,8 @@ static void recLHU() {
 
 				//PUSHI  (addr);
 				MOV64ItoR(X86ARG1, addr);
-				//CALLFunc  ((uptr)SPU_readRegister);
-				MOV64ItoR(RAX, (uptr)SPU_readRegister);
+				//CALLFunc  ((uptr)spuReadRegister);
+				MOV64ItoR(RAX, (uptr)spuReadRegister);
 				CALL64R(RAX);
 				MOVZX32R16toR(EAX, EAX);
 				MOV32RtoM((uptr)&psxRegs.GPR.r[_Rt_], EAX);
@@ -1684,7 +1685,7 @@ static void recSH() {
 					MOV32MtoR(X86ARG2, (uptr)&psxRegs.GPR.r[_Rt_]);
 				}
 				MOV64ItoR(X86ARG1, addr);
-				CALLFunc  ((uptr)SPU_writeRegister);
+				CALLFunc  ((uptr)spuWriteRegister);
 
 				//resp+= 8;
 
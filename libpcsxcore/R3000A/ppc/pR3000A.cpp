@@ -32,6 +32,7 @@
 #include "../r3000a.h"
 #include "psxhle.h"
 #include "mdec.h"
+#include "spu.h"
 #include "plugins.h"
 
 using namespace R3000A;
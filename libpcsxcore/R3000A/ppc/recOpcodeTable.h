@@ -1669,7 +1669,7 @@ static void recLHU() {
 					if (!_Rt_) return;
 
 					LIW(PPCARG1, addr);
-					CALLFunc((uptr)SPU_readRegister);
+					CALLFunc((uptr)spuReadRegister);
 					RLWINM(HWRegs.Put(_Rt_), r3, 0, 16, 31);
 					return;
 			}
@@ -1859,7 +1859,7 @@ static void recSH() {
 					LWPRtoR(PPCARG2, &_rRtU_);
 					RLWINM(PPCARG2, PPCARG2, 0, 16, 31);
 				}
-				CALLFunc((uptr)&SPU_writeRegister);
+				CALLFunc((uptr)spuWriteRegister);
 				return;
 			}*/
 			switch (addr) {
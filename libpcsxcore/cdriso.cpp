@@ -78,6 +78,7 @@ static unsigned int initial_offset = 0;
 static volatile char playing = 0;
 static char cddaBigEndian = 0;
 static volatile unsigned int cddaCurOffset = 0;
+static unsigned int cddaBase = 0;
 
 char* CALLBACK CDR__getDriveLetter(void);
 long CALLBACK CDR__configure(void);
@@ -97,13 +98,22 @@ struct trackinfo {
 	cd_type type;
 	char start[3];		// MSF-format
 	char length[3];		// MSF-format
+	unsigned int lba;	// start sector, without the 2 second lead-in
+	unsigned int base;	// sector at which this track's file begins
+	FILE *handle;		// data reads
+	FILE *cddaHandle;	// audio reads, used by the play thread only
 };
 
 #define MAXTRACKS 100 /* How many tracks can a CD hold? */
+#define MAXSECONDS (100 * 60)
 
 static int numtracks = 0;
 static struct trackinfo ti[MAXTRACKS];
 
+// first track touching each second of the disc, so a sector lookup
+// never has to walk more than a couple of entries
+static unsigned char trackindex[MAXSECONDS];
+
 // get a sector from a msf-array
 static unsigned int msf2sec(char *msf) {
 	return ((msf[0] * 60 + msf[1]) * 75) + msf[2];
@@ -207,7 +217,6 @@ static void *playthread(void *param)
 
 		if (s == 0) {
 			playing = 0;
-			fclose(cddaHandle);
 			cddaHandle = NULL;
 			initial_offset = 0;
 			break;
@@ -254,28 +263,61 @@ static void stopCDDA() {
 	pthread_join(threadid, NULL);
 #endif
 
-	if (cddaHandle != NULL) {
-		fclose(cddaHandle);
-		cddaHandle = NULL;
+	// the handle belongs to the track table, it stays open until ISOclose
+	cddaHandle = NULL;
+	initial_offset = 0;
+}
+
+// find the track holding a sector
+static struct trackinfo *findtrack(unsigned int sector) {
+	int t;
+
+	if (numtracks == 0 || sector / 75 >= MAXSECONDS) {
+		return &ti[0];
 	}
 
-	initial_offset = 0;
+	t = trackindex[sector / 75];
+	while (t < numtracks && sector >= ti[t + 1].lba) {
+		t++;
+	}
+
+	// the pregap of a track stored in its own file belongs to that file
+	if (t < numtracks && ti[t + 1].handle != ti[t].handle && sector >= ti[t + 1].base) {
+		t++;
+	}
+
+	return &ti[t];
+}
+
+// byte offset of a sector inside the file of its track
+static unsigned int sectoroffset(struct trackinfo *track, unsigned int sector) {
+	unsigned int framesize = CD_FRAMESIZE_RAW;
+
+	if (subChanInterleaved) {
+		framesize += SUB_FRAMESIZE;
+	}
+
+	return (sector - track->base) * framesize;
 }
 
 // start the CDDA playback
-static void startCDDA(unsigned int offset) {
+static void startCDDA(unsigned int sector) {
+	struct trackinfo	*track = findtrack(sector);
+	unsigned int		offset = sectoroffset(track, sector);
+
 	if (playing) {
-		if (initial_offset == offset) {
+		if (initial_offset == offset && cddaHandle == track->cddaHandle) {
 			return;
 		}
 		stopCDDA();
 	}
 
-	cddaHandle = fopen(cdrfilename, "rb");
-	if (cddaHandle == NULL) {
+	if (track->cddaHandle == NULL) {
 		return;
 	}
 
+	cddaHandle = track->cddaHandle;
+	cddaBase = track->base;
 	initial_offset = offset;
 	cddaCurOffset = initial_offset;
 	fseek(cddaHandle, initial_offset, SEEK_SET);
@@ -376,16 +418,51 @@ static int parsetoc(const char *isofile) {
 	return 0;
 }
 
+// close the per-track handles, several tracks may share one file
+static void closetracks(void) {
+	int		i, j;
+	FILE	*f;
+
+	for (i = 0; i <= numtracks; i++) {
+		if ((f = ti[i].handle) != NULL && f != cdHandle) {
+			fclose(f);
+			for (j = i; j <= numtracks; j++) {
+				if (ti[j].handle == f) ti[j].handle = NULL;
+			}
+		}
+		if ((f = ti[i].cddaHandle) != NULL) {
+			fclose(f);
+			for (j = i; j <= numtracks; j++) {
+				if (ti[j].cddaHandle == f) ti[j].cddaHandle = NULL;
+			}
+		}
+	}
+
+	memset(&ti, 0, sizeof(ti));
+	numtracks = 0;
+}
+
+// size of an image file in sectors
+static unsigned int filesectors(FILE *f) {
+	fseek(f, 0, SEEK_END);
+	return ftell(f) / CD_FRAMESIZE_RAW;
+}
+
 // this function tries to get the .cue file of the given .bin
 // the necessary data is put into the ti (trackinformation)-array
+// every FILE entry gets its own handle, so images with one .bin per
+// track are laid out one after another on the disc
 static int parsecue(const char *isofile) {
 	char			cuename[MAXPATHLEN];
+	char			filepath[MAXPATHLEN], name[256];
 	FILE			*fi;
+	FILE			*file = NULL, *cddafile = NULL;
+	int				firstfile = 1;
 	char			*token;
 	char			time[20];
 	char			*tmp;
 	char			linebuf[256], dummy[256];
-	unsigned int	t;
+	unsigned int	t, base = 0, dirlen;
 
 	numtracks = 0;
 
@@ -403,6 +480,10 @@ static int parsecue(const char *isofile) {
 		return -1;
 	}
 
+	// file names in the cue are relative to the cue itself
+	tmp = strrchr(cuename, '/');
+	dirlen = (tmp != NULL) ? (tmp - cuename + 1) : 0;
+
 	memset(&ti, 0, sizeof(ti));
 
 	while (fgets(linebuf, sizeof(linebuf), fi) != NULL) {
@@ -413,11 +494,61 @@ static int parsecue(const char *isofile) {
 			continue;
 		}
 
-		if (!strcmp(token, "TRACK")){
+		if (!strcmp(token, "FILE")) {
+			if (sscanf(linebuf, " FILE \"%255[^\"]\"", name) != 1) {
+				sscanf(linebuf, " FILE %255s", name);
+			}
+
+			if (file != NULL) {
+				// the next file starts right after the previous one
+				base += filesectors(file);
+			}
+
+			if (firstfile && cdHandle != NULL) {
+				// the image the user picked is the first file
+				file = cdHandle;
+				strcpy(filepath, isofile);
+			}
+			else {
+				// a file without tracks isn't in ti, close it here
+				if (file != NULL && file != cdHandle && (numtracks == 0 || ti[numtracks].handle != file)) {
+					fclose(file);
+				}
+				memcpy(filepath, cuename, dirlen);
+				strncpy(filepath + dirlen, name, MAXPATHLEN - dirlen);
+				filepath[MAXPATHLEN - 1] = '\0';
+				file = fopen(filepath, "rb");
+				if (file == NULL) {
+					// every track after a missing file would be misplaced
+					SysPrintf(_("Could not open %s.\n"), filepath);
+					fclose(fi);
+					closetracks();
+					return -1;
+				}
+			}
+			firstfile = 0;
+			cddafile = NULL;
+		}
+		else if (!strcmp(token, "TRACK")){
+			if (file == NULL) {
+				// a track before any FILE line
+				fclose(fi);
+				closetracks();
+				return -1;
+			}
 			numtracks++;
 
+			ti[numtracks].base = base;
+			ti[numtracks].handle = file;
+
 			if (strstr(linebuf, "AUDIO") != NULL) {
 				ti[numtracks].type = CDDA;
+
+				// the play thread seeks on its own, give it a separate handle
+				if (cddafile == NULL && file != NULL) {
+					cddafile = fopen(filepath, "rb");
+				}
+				ti[numtracks].cddaHandle = cddafile;
 			}
 			else if (strstr(linebuf, "MODE1/2352") != NULL || strstr(linebuf, "MODE2/2352") != NULL) {
 				ti[numtracks].type = DATA;
@@ -433,7 +564,7 @@ static int parsecue(const char *isofile) {
 
 			tok2msf((char *)&time, (char *)&ti[numtracks].start);
 
-			t = msf2sec(ti[numtracks].start) + 2 * 75;
+			t = msf2sec(ti[numtracks].start) + base + 2 * 75;
 			sec2msf(t, ti[numtracks].start);
 
 			// If we've already seen another track, this is its end
@@ -447,9 +578,8 @@ static int parsecue(const char *isofile) {
 	fclose(fi);
 
 	// Fill out the last track's end based on size
-	if (numtracks >= 1) {
-		fseek(cdHandle, 0, SEEK_END);
-		t = ftell(cdHandle) / 2352 - msf2sec(ti[numtracks].start) + 2 * 75;
+	if (numtracks >= 1 && ti[numtracks].handle != NULL) {
+		t = filesectors(ti[numtracks].handle) + ti[numtracks].base - msf2sec(ti[numtracks].start) + 2 * 75;
 		sec2msf(t, ti[numtracks].length);
 	}
 
@@ -635,6 +765,44 @@ static int opensubfile(const char *isoname) {
 	return 0;
 }
 
+// fill in what the parsers leave out and build the sector lookup table
+static void buildtrackindex(void) {
+	int				i, t;
+	unsigned int	sec;
+
+	ti[0].handle = cdHandle;
+	ti[0].cddaHandle = NULL;
+	ti[0].base = 0;
+	ti[0].lba = 0;
+
+	for (i = 1; i <= numtracks; i++) {
+		ti[i].lba = msf2sec(ti[i].start) - 2 * 75;
+
+		// toc, ccd and mds describe a single image, a cue sets every handle
+		if (ti[i].handle == NULL) {
+			ti[i].handle = cdHandle;
+		}
+	}
+
+	// single file images share one extra handle for audio
+	for (i = 1; i <= numtracks; i++) {
+		if (ti[i].type == CDDA && ti[i].cddaHandle == NULL && ti[i].handle == cdHandle) {
+			if (ti[0].cddaHandle == NULL) {
+				ti[0].cddaHandle = fopen(cdrfilename, "rb");
+			}
+			ti[i].cddaHandle = ti[0].cddaHandle;
+		}
+	}
+
+	t = 0;
+	for (sec = 0; sec < MAXSECONDS; sec++) {
+		while (t < numtracks && sec * 75 >= ti[t + 1].lba) {
+			t++;
+		}
+		trackindex[sec] = t;
+	}
+}
+
 STATIC long CALLBACK ISOinit(void) {
 #ifdef GEKKO
 	SysPrintf("start CDR_init()\r\n");
@@ -648,6 +816,8 @@ STATIC long CALLBACK ISOinit(void) {
 }
 
 STATIC long CALLBACK ISOshutdown(void) {
+	stopCDDA();
+	closetracks();
 	if (cdHandle != NULL) {
 		fclose(cdHandle);
 		cdHandle = NULL;
@@ -656,7 +826,6 @@ STATIC long CALLBACK ISOshutdown(void) {
 		fclose(subHandle);
 		subHandle = NULL;
 	}
-	stopCDDA();
 	return 0;
 }
 
@@ -667,10 +836,31 @@ STATIC long CALLBACK ISOopen(void) {
 	//cdrfilename = Settings.filename;
 	strcpy(cdrfilename, Settings.filename);
 #endif
+	int len;
+
 	if (cdHandle != NULL) {
 		return 0; // it's already open
 	}
 
+	cddaBigEndian = 0;
+	subChanInterleaved = 0;
+
+	// a .cue names its own data files
+	len = strlen(cdrfilename);
+	if (len >= 4 && strnicmp(cdrfilename + len - 4, ".cue", 4) == 0) {
+		if (parsecue(cdrfilename) != 0 || numtracks == 0 || ti[1].handle == NULL) {
+			closetracks();
+			return -1;
+		}
+
+		cdHandle = ti[1].handle;
+		buildtrackindex();
+
+		SysPrintf(_("Loaded CD Image: %s"), cdrfilename);
+		SysPrintf("[+cue].\n");
+		return 0;
+	}
+
 	cdHandle = fopen(cdrfilename, "rb");
 	if (cdHandle == NULL) {
 		return -1;
@@ -678,9 +868,6 @@ STATIC long CALLBACK ISOopen(void) {
 
 	SysPrintf(_("Loaded CD Image: %s"), cdrfilename);
 
-	cddaBigEndian = 0;
-	subChanInterleaved = 0;
-
 	if (parsetoc(cdrfilename) == 0) {
 		cddaBigEndian = 1; // cdrdao uses big-endian for CD Audio
 		SysPrintf("[+toc]");
@@ -695,6 +882,8 @@ STATIC long CALLBACK ISOopen(void) {
 		SysPrintf("[+mds]");
 	}
 
+	buildtrackindex();
+
 	if (!subChanInterleaved && opensubfile(cdrfilename) == 0) {
 		SysPrintf("[+sub]");
 	}
@@ -705,6 +894,8 @@ STATIC long CALLBACK ISOopen(void) {
 }
 
 STATIC long CALLBACK ISOclose(void) {
+	stopCDDA();
+	closetracks();
 	if (cdHandle != NULL) {
 		fclose(cdHandle);
 		cdHandle = NULL;
@@ -713,7 +904,6 @@ STATIC long CALLBACK ISOclose(void) {
 		fclose(subHandle);
 		subHandle = NULL;
 	}
-	stopCDDA();
 	return 0;
 }
 
@@ -758,23 +948,25 @@ STATIC long CALLBACK ISOgetTD(unsigned char track, unsigned char *buffer) {
 // time: byte 0 - minute; byte 1 - second; byte 2 - frame
 // uses bcd format
 STATIC long CALLBACK ISOreadTrack(unsigned char *time) {
+	unsigned int		sector;
+	struct trackinfo	*track;
+
 	if (cdHandle == NULL) {
 		return -1;
 	}
 
+	sector = MSF2SECT(btoi(time[0]), btoi(time[1]), btoi(time[2]));
+	track = findtrack(sector);
+
+	fseek(track->handle, sectoroffset(track, sector) + 12, SEEK_SET);
+	fread(cdbuffer, 1, DATA_SIZE, track->handle);
+
 	if (subChanInterleaved) {
-		fseek(cdHandle, MSF2SECT(btoi(time[0]), btoi(time[1]), btoi(time[2])) * (CD_FRAMESIZE_RAW + SUB_FRAMESIZE) + 12, SEEK_SET);
-		fread(cdbuffer, 1, DATA_SIZE, cdHandle);
-		fread(subbuffer, 1, SUB_FRAMESIZE, cdHandle);
+		fread(subbuffer, 1, SUB_FRAMESIZE, track->handle);
 	}
-	else {
-		fseek(cdHandle, MSF2SECT(btoi(time[0]), btoi(time[1]), btoi(time[2])) * CD_FRAMESIZE_RAW + 12, SEEK_SET);
-		fread(cdbuffer, 1, DATA_SIZE, cdHandle);
-
-		if (subHandle != NULL) {
-			fseek(subHandle, MSF2SECT(btoi(time[0]), btoi(time[1]), btoi(time[2])) * SUB_FRAMESIZE, SEEK_SET);
-			fread(subbuffer, 1, SUB_FRAMESIZE, subHandle);
-		}
+	else if (subHandle != NULL) {
+		fseek(subHandle, sector * SUB_FRAMESIZE, SEEK_SET);
+		fread(subbuffer, 1, SUB_FRAMESIZE, subHandle);
 	}
 
 	return 0;
@@ -790,12 +982,7 @@ STATIC unsigned char * CALLBACK ISOgetBuffer(void) {
 // does NOT uses bcd format
 STATIC long CALLBACK ISOplay(unsigned char *time) {
 	if (SPU_playCDDAchannel != NULL) {
-		if (subChanInterleaved) {
-			startCDDA(MSF2SECT(time[0], time[1], time[2]) * (CD_FRAMESIZE_RAW + SUB_FRAMESIZE));
-		}
-		else {
-			startCDDA(MSF2SECT(time[0], time[1], time[2]) * CD_FRAMESIZE_RAW);
-		}
+		startCDDA(MSF2SECT(time[0], time[1], time[2]));
 	}
 	return 0;
 }
@@ -823,7 +1010,7 @@ STATIC long CALLBACK ISOgetStatus(struct CdrStat *stat) {
 	if (playing) {
 		stat->Type = 0x02;
 		stat->Status |= 0x80;
-		sec = cddaCurOffset / CD_FRAMESIZE_RAW;
+		sec = cddaBase + cddaCurOffset / CD_FRAMESIZE_RAW;
 		sec2msf(sec, (char *)stat->Time);
 	}
 	else {
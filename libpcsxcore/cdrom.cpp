@@ -30,6 +30,7 @@
 #include "cdrom.h"
 #include "misc.h"
 #include "decode_xa.h"
+#include "cdrtrace.h"
 
 using namespace R3000A;
 
@@ -97,6 +98,35 @@ static unsigned char Test23[] = { 0x43, 0x58, 0x44, 0x32, 0x39 ,0x34, 0x30, 0x51
 // so (PSXCLK / 75) / BIAS = cdr read time (linuzappz)
 static const u32 cdReadTime = ((PSXCLK / 75) / BIAS);	// 0x37200
 
+// drive timing, all values in psx cycles (BIAS included like cdReadTime)
+typedef struct {
+	u32 ack;			// command response latency
+	u32 seekMin;		// settle time of any seek
+	u32 seekPerK;		// seek cost per sector of distance, in 1/1024 cycles
+	u32 seekMax;		// full stroke
+	u32 read1x;			// time per sector at single speed
+	u32 read2x;			// time per sector at double speed
+	u32 pause;			// CdlPause completion
+	u32 readSeek;		// CdlReadN/ReadS pay for the seek if none was issued
+} CdrTiming;
+
+static const CdrTiming cdTimings[CDR_TIMING_COUNT] = {
+	// baseline: the classic fixed 0x800 seeks
+	{ 0x800, 0x800, 0, 0x800, cdReadTime, cdReadTime / 2, 0x40000, 0 },
+	// accurate: seeks cost about 1/3 s across the whole disc
+	{ 0x800, 0x800, 17800, (PSXCLK / BIAS) / 3, cdReadTime, cdReadTime / 2, 0x40000, 1 },
+	// fast-load: no seek travel, sectors arrive 8 times faster
+	{ 0x800, 0x800, 0, 0x800, cdReadTime / 8, cdReadTime / 16, 0x40000 / 8, 0 },
+};
+
+static const CdrTiming *cdTiming = &cdTimings[CDR_TIMING_BASELINE];
+static int cdTurbo = 0;
+
+// when the current command was written, for the access trace
+static u32 cdCmdCycle = 0;
+
+#define SetSectorLBA()	((cdr.SetSector[0] * 60 + cdr.SetSector[1]) * 75 + cdr.SetSector[2] - 150)
+
 #define btoi(b)     ((b)/16*10 + (b)%16)    /* BCD to u_char */
 #define itob(i)     ((i)/10*16 + (i)%10)    /* u_char to BCD */
 
@@ -115,11 +145,43 @@ static void AddIrqQueue(unsigned char irq, unsigned long ecycle) {
 	}
 }
 
+static void SelectTiming() {
+	int profile = cdTurbo ? CDR_TIMING_FASTLOAD : Config.CdTiming;
+
+	if (profile < 0 || profile >= CDR_TIMING_COUNT)
+		profile = CDR_TIMING_BASELINE;
+
+	cdTiming = &cdTimings[profile];
+}
+
+static u32 ReadTime() {
+	// streamed XA has to arrive in real time whatever the profile
+	const CdrTiming *timing = (cdr.Mode & 0x40) ? &cdTimings[CDR_TIMING_BASELINE] : cdTiming;
+
+	return (cdr.Mode & 0x80) ? timing->read2x : timing->read1x;
+}
+
+// time to move the head from the last sector read to cdr.SetSector
+static u32 SeekTime() {
+	s32 from, to, dist;
+	u32 time;
+
+	from = (btoi(cdr.Prev[0]) * 60 + btoi(cdr.Prev[1])) * 75 + btoi(cdr.Prev[2]);
+	to = (cdr.SetSector[0] * 60 + cdr.SetSector[1]) * 75 + cdr.SetSector[2];
+	dist = (to > from) ? (to - from) : (from - to);
+
+	time = cdTiming->seekMin + (u32)(((u64)dist * cdTiming->seekPerK) >> 10);
+	if (time > cdTiming->seekMax)
+		time = cdTiming->seekMax;
+
+	return time;
+}
+
 static void StartReading(u32 type) {
    	cdr.Reading = type;
   	cdr.FirstSector = 1;
   	cdr.Readed = 0xff;
-	AddIrqQueue(READ_ACK, 0x800);
+	AddIrqQueue(READ_ACK, cdTiming->ack);
 }
 
 static void StopReading() {
@@ -171,6 +233,14 @@ static void ReadTrack() {
 #ifdef CDR_LOG
 	CDR_LOG("ReadTrack() Log: KEY *** %x:%x:%x\n", cdr.Prev[0], cdr.Prev[1], cdr.Prev[2]);
 #endif
+	if (cdrTraceEnabled) {
+		u32 start = cdrTraceTime();
+
+		cdr.RErr = CDR_readTrack(cdr.Prev);
+		cdrTraceRecord(CDRTRACE_READ, cdr.Reading, cdr.Mode, SetSectorLBA(), cdrTraceTime() - start);
+		return;
+	}
+
 	cdr.RErr = CDR_readTrack(cdr.Prev);
 }
 
@@ -194,6 +264,9 @@ void cdrInterrupt() {
 	cdr.Irq = 0xff;
 	cdr.Ctrl &= ~0x80;
 
+	if (cdrTraceEnabled)
+		cdrTraceRecord(CDRTRACE_CMD, Irq, cdr.Mode, SetSectorLBA(), psxRegs.cycle - cdCmdCycle);
+
 	switch (Irq) {
     	case CdlSync:
 			SetResultSize(1);
@@ -277,7 +350,7 @@ void cdrInterrupt() {
 			SetResultSize(1);
 			cdr.Result[0] = cdr.StatP;
         	cdr.Stat = Acknowledge;
-			AddIrqQueue(CdlPause + 0x20, 0x800);
+			AddIrqQueue(CdlPause + 0x20, cdTiming->ack);
 			cdr.Ctrl |= 0x80;
 			break;
 
@@ -295,7 +368,7 @@ void cdrInterrupt() {
 			cdr.Result[0] = cdr.StatP;
         	cdr.Stat = Acknowledge;
 //			if (!cdr.Init) {
-				AddIrqQueue(CdlInit + 0x20, 0x800);
+				AddIrqQueue(CdlInit + 0x20, cdTiming->ack);
 //			}
         	break;
 
@@ -427,7 +500,7 @@ void cdrInterrupt() {
 			cdr.StatP |= 0x40;
         	cdr.Stat = Acknowledge;
 			cdr.Seeked = 1;
-			AddIrqQueue(CdlSeekL + 0x20, 0x800);
+			AddIrqQueue(CdlSeekL + 0x20, SeekTime());
 			break;
 
     	case CdlSeekL + 0x20:
@@ -444,7 +517,7 @@ void cdrInterrupt() {
         	cdr.Result[0] = cdr.StatP;
 			cdr.StatP |= 0x40;
         	cdr.Stat = Acknowledge;
-			AddIrqQueue(CdlSeekP + 0x20, 0x800);
+			AddIrqQueue(CdlSeekP + 0x20, SeekTime());
 			break;
 
     	case CdlSeekP + 0x20:
@@ -478,7 +551,7 @@ void cdrInterrupt() {
 			cdr.StatP |= 0x2;
         	cdr.Result[0] = cdr.StatP;
         	cdr.Stat = Acknowledge;
-			AddIrqQueue(CdlID + 0x20, 0x800);
+			AddIrqQueue(CdlID + 0x20, cdTiming->ack);
 			break;
 
 		case CdlID + 0x20:
@@ -516,7 +589,7 @@ void cdrInterrupt() {
 			cdr.StatP |= 0x2;
         	cdr.Result[0] = cdr.StatP;
         	cdr.Stat = Acknowledge;
-			AddIrqQueue(CdlReadToc + 0x20, 0x800);
+			AddIrqQueue(CdlReadToc + 0x20, cdTiming->ack);
 			break;
 
     	case CdlReadToc + 0x20:
@@ -545,16 +618,19 @@ void cdrInterrupt() {
 			SetResultSize(1);
 			cdr.StatP |= 0x2;
         	cdr.Result[0] = cdr.StatP;
+			i = ReadTime();
 			if (cdr.Seeked == 0) {
 				cdr.Seeked = 1;
 				cdr.StatP|= 0x40;
+				if (cdTiming->readSeek)
+					i += SeekTime();
 			}
 			cdr.StatP |= 0x20;
         	cdr.Stat = Acknowledge;
 
 			//ReadTrack();
 
-			CDREAD_INT((cdr.Mode & 0x80) ? (cdReadTime / 2) : cdReadTime);
+			CDREAD_INT(i);
 			//CDREAD_INT(0x40000);
 			break;
 
@@ -633,7 +709,7 @@ void cdrReadInterrupt() {
 		cdr.Stat = DiskError;
 		cdr.Result[0] |= 0x01;
 		//ReadTrack();
-		CDREAD_INT((cdr.Mode & 0x80) ? (cdReadTime / 2) : cdReadTime);
+		CDREAD_INT(ReadTime());
 		return;
 	}
 
@@ -675,11 +751,11 @@ void cdrReadInterrupt() {
 		CDR_LOG("cdrReadInterrupt() Log: Autopausing read\n");
 #endif
 //		AddIrqQueue(AUTOPAUSE, 0x800);
-		AddIrqQueue(CdlPause, 0x800);
+		AddIrqQueue(CdlPause, cdTiming->ack);
 	}
 	else {
 		//ReadTrack();
-		CDREAD_INT((cdr.Mode & 0x80) ? (cdReadTime / 2) : cdReadTime);
+		CDREAD_INT(ReadTime());
 	}
 	psxRaiseExtInt( PsxInt_CDROM );
 }
@@ -758,6 +834,7 @@ void cdrWrite1(unsigned char rt) {
 //	psxHu8(0x1801) = rt;
     cdr.Cmd = rt;
 	cdr.OCUP = 0;
+	cdCmdCycle = psxRegs.cycle;
 
 #ifdef CDRCMD_DEBUG
 	SysPrintf("cdrWrite1() Log: CD1 write: %x (%s)", rt, CmdName[rt]);
@@ -777,13 +854,13 @@ void cdrWrite1(unsigned char rt) {
     	case CdlSync:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlNop:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlSetloc:
@@ -797,7 +874,7 @@ void cdrWrite1(unsigned char rt) {
 			}*/
 			cdr.Ctrl |= 0x80;
         	cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlPlay:
@@ -818,7 +895,7 @@ void cdrWrite1(unsigned char rt) {
     		cdr.Play = 1;
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
     		break;
 
     	case CdlForward:
@@ -826,7 +903,7 @@ void cdrWrite1(unsigned char rt) {
 				cdr.CurTrack++;
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlBackward:
@@ -834,7 +911,7 @@ void cdrWrite1(unsigned char rt) {
 				cdr.CurTrack--;
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlReadN:
@@ -850,7 +927,7 @@ void cdrWrite1(unsigned char rt) {
 			StopReading();
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlStop:
@@ -858,7 +935,7 @@ void cdrWrite1(unsigned char rt) {
 			StopReading();
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlPause:
@@ -866,7 +943,7 @@ void cdrWrite1(unsigned char rt) {
 			StopReading();
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x40000);
+    		AddIrqQueue(cdr.Cmd, cdTiming->pause);
         	break;
 
 		case CdlReset:
@@ -875,21 +952,21 @@ void cdrWrite1(unsigned char rt) {
 			StopReading();
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlMute:
         	cdr.Muted = 1;
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlDemute:
         	cdr.Muted = 0;
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlSetfilter:
@@ -897,7 +974,7 @@ void cdrWrite1(unsigned char rt) {
         	cdr.Channel = cdr.Param[1];
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlSetmode:
@@ -907,63 +984,63 @@ void cdrWrite1(unsigned char rt) {
         	cdr.Mode = cdr.Param[0];
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlGetmode:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlGetlocL:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlGetlocP:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-			AddIrqQueue(cdr.Cmd, 0x800);
+			AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlGetTN:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlGetTD:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlSeekL:
 //			((u32 *)cdr.SetSectorSeek)[0] = ((u32 *)cdr.SetSector)[0];
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlSeekP:
 //        	((u32 *)cdr.SetSectorSeek)[0] = ((u32 *)cdr.SetSector)[0];
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlTest:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlID:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	case CdlReadS:
@@ -977,7 +1054,7 @@ void cdrWrite1(unsigned char rt) {
     	case CdlReadToc:
 			cdr.Ctrl |= 0x80;
     		cdr.Stat = NoIntr;
-    		AddIrqQueue(cdr.Cmd, 0x800);
+    		AddIrqQueue(cdr.Cmd, cdTiming->ack);
         	break;
 
     	default:
@@ -1059,7 +1136,7 @@ void cdrWrite3(unsigned char rt) {
         if (cdr.Irq)
 			CDR_INT(cdr.eCycle);
 //         if (cdr.Reading && !cdr.ResultReady)
-//             CDREAD_INT((cdr.Mode & 0x80) ? (cdReadTime / 2) : cdReadTime);
+//             CDREAD_INT(ReadTime());
 
 		return;
 	}
@@ -1125,6 +1202,20 @@ void cdrReset() {
 	cdr.CurTrack = 1;
 	cdr.File = 1;
 	cdr.Channel = 1;
+	cdTurbo = 0;
+	SelectTiming();
+}
+
+// set by LoadCdrom for fast boot, cleared again by the first pad input;
+// switches to the fast-load profile meanwhile
+void cdrSetTurbo(int enable) {
+	cdTurbo = enable;
+	SelectTiming();
+}
+
+void cdrSetTiming(int profile) {
+	Config.CdTiming = profile;
+	SelectTiming();
 }
 
 int cdrFreeze(gzFile f, int Mode) {
@@ -1137,8 +1228,13 @@ int cdrFreeze(gzFile f, int Mode) {
 
 	gzfreezel(&tmp);
 
-	if (Mode == 0)
+	if (Mode == 0) {
 		cdr.pTransfer = cdr.Transfer + tmp;
 
+		// the boot turbo is not in the state: a loaded game reads at the configured speed
+		cdTurbo = 0;
+		SelectTiming();
+	}
+
 	return 0;
 }
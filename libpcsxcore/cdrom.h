@@ -85,6 +85,16 @@ void cdrWrite1(unsigned char rt);
 void cdrWrite2(unsigned char rt);
 void cdrWrite3(unsigned char rt);
 
+enum {
+	CDR_TIMING_BASELINE,
+	CDR_TIMING_ACCURATE,
+	CDR_TIMING_FASTLOAD,
+	CDR_TIMING_COUNT
+};	/* CD-ROM timing profiles */
+
+void cdrSetTurbo(int enable);
+void cdrSetTiming(int profile);
+
 int cdrFreeze(gzFile f, int Mode);
 
 #endif /* __CDROM_H__ */
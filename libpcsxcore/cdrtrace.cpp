@@ -0,0 +1,113 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public 
+ *  License as published by the Free Software Foundation, either 
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License 
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+* CD-ROM access trace (see cdrtrace.h for the format).
+*/
+
+#include "psxcommon.h"
+#include "R3000A/r3000a.h"
+#include "cdrtrace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+using namespace R3000A;
+
+#define TRACE_BUFRECS	1024
+
+int cdrTraceEnabled = 0;
+
+static FILE *traceFile = NULL;
+static u8 traceBuf[TRACE_BUFRECS * CDRTRACE_RECSIZE];
+static int traceCount = 0;
+
+static void put32(u8 *p, u32 v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static void traceFlush() {
+	if (traceCount) {
+		fwrite(traceBuf, CDRTRACE_RECSIZE, traceCount, traceFile);
+		traceCount = 0;
+	}
+}
+
+int cdrTraceOpen(const char *filename) {
+	u8 ver[4];
+
+	cdrTraceClose();
+
+	traceFile = fopen(filename, "wb");
+	if (traceFile == NULL) {
+		SysPrintf(_("Could not open CD-ROM trace file %s.\n"), filename);
+		return -1;
+	}
+
+	put32(ver, CDRTRACE_VERSION);
+	fwrite(CDRTRACE_MAGIC, 1, 8, traceFile);
+	fwrite(ver, 1, 4, traceFile);
+
+	cdrTraceEnabled = 1;
+	return 0;
+}
+
+void cdrTraceClose() {
+	if (traceFile == NULL) return;
+
+	traceFlush();
+	fclose(traceFile);
+	traceFile = NULL;
+	cdrTraceEnabled = 0;
+}
+
+void cdrTraceRecord(int type, int cmd, int mode, unsigned int lba, unsigned int latency) {
+	u8 *p;
+
+	if (traceFile == NULL) return;
+
+	p = &traceBuf[traceCount * CDRTRACE_RECSIZE];
+	put32(p + 0, psxRegs.cycle);
+	put32(p + 4, lba);
+	put32(p + 8, latency);
+	p[12] = type;
+	p[13] = cmd;
+	p[14] = mode;
+	p[15] = 0;
+
+	if (++traceCount == TRACE_BUFRECS)
+		traceFlush();
+}
+
+unsigned int cdrTraceTime() {
+#ifdef _WIN32
+	return GetTickCount() * 1000;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
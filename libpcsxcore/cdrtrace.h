@@ -0,0 +1,64 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public 
+ *  License as published by the Free Software Foundation, either 
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of 
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License 
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+* CD-ROM access trace: a compact binary log of drive commands and sector
+* reads, replayed offline by tools/cdrreplay.
+*
+* File layout (all values little-endian):
+*   header   "CDRTRACE", u32 version
+*   records  CDRTRACE_RECSIZE bytes each: u32 cycle, u32 lba, u32 latency,
+*            u8 type, u8 cmd, u8 mode, u8 reserved
+*
+* For CDRTRACE_CMD records, cmd is the command or irq handled by
+* cdrInterrupt and latency is psx cycles since the command was written.
+* For CDRTRACE_READ records, cmd is the read type (1 ReadN, 2 ReadS) and
+* latency is the host time of CDR_readTrack in microseconds.
+*/
+
+#ifndef __CDRTRACE_H__
+#define __CDRTRACE_H__
+
+#define CDRTRACE_MAGIC		"CDRTRACE"
+#define CDRTRACE_VERSION	1
+#define CDRTRACE_RECSIZE	16
+
+enum {
+	CDRTRACE_CMD,
+	CDRTRACE_READ
+};	/* Record types */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int cdrTraceOpen(const char *filename);
+void cdrTraceClose();
+void cdrTraceRecord(int type, int cmd, int mode, unsigned int lba, unsigned int latency);
+
+extern int cdrTraceEnabled;
+
+// host clock for read latencies
+unsigned int cdrTraceTime();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* __CDRTRACE_H__ */
@@ -22,6 +22,10 @@
 
 #include "decode_xa.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define FIXED
 
 #define NOT(_X_)				(!(_X_))
@@ -118,14 +122,99 @@ static __inline void ADPCM_DecodeBlock16( ADPCM_Decode_t *decp, u8 filter_range,
 	decp->y1 = fy1;
 }
 
+// same filter as ADPCM_DecodeBlock16, on one sound unit of an already
+// unpacked group (samples are 4 apart, see xa_unpack_group)
+static __inline void ADPCM_DecodeUnit( ADPCM_Decode_t *decp, u8 filter_range, const s16 *srcp, short *destp, int inc ) {
+	int i;
+	int filterid;
+	s32 fy0, fy1;
+
+	filterid = (filter_range >>  4) & 0x0f;
+
+	fy0 = decp->y0;
+	fy1 = decp->y1;
+
+	for (i = BLKSIZ; i; --i) {
+		s32 x;
+
+		x = (s32)*srcp << SH; srcp += 4;
+		x -= (IK0(filterid) * fy0 + (IK1(filterid) * fy1)) >> SHC; fy1 = fy0; fy0 = x;
+
+		XACLAMP( x, -32768<<SH, 32767<<SH ); *destp = x >> SH; destp += inc;
+	}
+	decp->y0 = fy0;
+	decp->y1 = fy1;
+}
+
 static int headtable[4] = {0,2,8,10};
 
+//===========================================
+// unpack the 4 bit nibbles of all 8 sound units of a group and apply
+// their range shift; lo gets units 0,2,4,6 and hi units 1,3,5,7, both
+// as [sample][unit / 2]
+static void xa_unpack_group_c( const u8 *groupp, s16 *lo, s16 *hi ) {
+	const u8	*datap = groupp + 16;
+	int			range[8];
+	int			i, n;
+
+	for (i = 0; i < 4; i++) {
+		range[i * 2 + 0] = groupp[headtable[i] + 0] & 0x0f;
+		range[i * 2 + 1] = groupp[headtable[i] + 1] & 0x0f;
+	}
+
+	for (n = 0; n < BLKSIZ * 4; n++) {
+		i = n & 3;
+		lo[n] = (short)((datap[n] & 0x0f) << 12) >> range[i * 2 + 0];
+		hi[n] = (short)((datap[n] & 0xf0) <<  8) >> range[i * 2 + 1];
+	}
+}
+
+#ifdef __SSE2__
+static void xa_unpack_group( const u8 *groupp, s16 *lo, s16 *hi ) {
+	const u8	*datap = groupp + 16;
+	s16			mul[8];
+	int			i, n, range;
+	__m128i		mlo, mhi, v, l, h;
+	const __m128i	zero = _mm_setzero_si128();
+	const __m128i	mask = _mm_set1_epi8(0x0f);
+
+	// x >> range on a nibble in the top bits is nibble << (12 - range);
+	// ranges above 12 are invalid and rare, leave them to the C code
+	for (i = 0; i < 8; i++) {
+		range = groupp[headtable[i >> 1] + (i & 1)] & 0x0f;
+		if (range > 12) {
+			xa_unpack_group_c(groupp, lo, hi);
+			return;
+		}
+		mul[i] = 1 << (12 - range);
+	}
+
+	mlo = _mm_setr_epi16(mul[0], mul[2], mul[4], mul[6], mul[0], mul[2], mul[4], mul[6]);
+	mhi = _mm_setr_epi16(mul[1], mul[3], mul[5], mul[7], mul[1], mul[3], mul[5], mul[7]);
+
+	// 16 bytes hold 4 samples of all 8 units
+	for (n = 0; n < BLKSIZ * 4; n += 16) {
+		v = _mm_loadu_si128((const __m128i *)(datap + n));
+		l = _mm_slli_epi16(_mm_and_si128(v, mask), 4);
+		h = _mm_andnot_si128(mask, v);
+
+		_mm_storeu_si128((__m128i *)(lo + n + 0), _mm_mullo_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(zero, l), 12), mlo));
+		_mm_storeu_si128((__m128i *)(lo + n + 8), _mm_mullo_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(zero, l), 12), mlo));
+		_mm_storeu_si128((__m128i *)(hi + n + 0), _mm_mullo_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(zero, h), 12), mhi));
+		_mm_storeu_si128((__m128i *)(hi + n + 8), _mm_mullo_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(zero, h), 12), mhi));
+	}
+}
+#else
+#define xa_unpack_group xa_unpack_group_c
+#endif
+
 //===========================================
 static void xa_decode_data( xa_decode_t *xdp, unsigned char *srcp ) {
 	const u8    *sound_groupsp;
 	const u8    *sound_datap, *sound_datap2;
 	int         i, j, k, nbits;
 	u16			data[4096], *datap;
+	s16			lo[BLKSIZ * 4], hi[BLKSIZ * 4];
 	short		*destp;
 
 	destp = xdp->pcm;
@@ -164,30 +253,13 @@ static void xa_decode_data( xa_decode_t *xdp, unsigned char *srcp ) {
 		} else { // level B/C
 			for (j=0; j < 18; j++) {
 				sound_groupsp = srcp + j * 128;		// sound groups header
-				sound_datap = sound_groupsp + 16;	// sound data just after the header
+
+				xa_unpack_group( sound_groupsp, lo, hi );
 
 				for (i=0; i < nbits; i++) {
-	    			datap = data;
-	    			sound_datap2 = sound_datap + i;
-
-        			for (k=0; k < 7; k++, sound_datap2 += 16) {
-           					*(datap++) = (u16)(sound_datap2[ 0] & 0x0f) |
-                       				    ((u16)(sound_datap2[ 4] & 0x0f) <<  4) |
-                       				    ((u16)(sound_datap2[ 8] & 0x0f) <<  8) |
-                       				    ((u16)(sound_datap2[12] & 0x0f) << 12);
-					}
-	    			ADPCM_DecodeBlock16( &xdp->left,  sound_groupsp[headtable[i]+0], data,
+					ADPCM_DecodeUnit( &xdp->left,  sound_groupsp[headtable[i]+0], lo + i,
                    				    destp+0, 2 );
-
-	        		datap = data;
-	        		sound_datap2 = sound_datap + i;
-        			for (k=0; k < 7; k++, sound_datap2 += 16) {
-           					*(datap++) = (u16)(sound_datap2[ 0] >> 4) |
-                       	    			((u16)(sound_datap2[ 4] >> 4) <<  4) |
-                       				    ((u16)(sound_datap2[ 8] >> 4) <<  8) |
-                       				    ((u16)(sound_datap2[12] >> 4) << 12);
-					}
-					ADPCM_DecodeBlock16( &xdp->right,  sound_groupsp[headtable[i]+1], data,
+					ADPCM_DecodeUnit( &xdp->right, sound_groupsp[headtable[i]+1], hi + i,
                            			    destp+1, 2 );
 
 	        		destp += 28*2;
@@ -227,33 +299,16 @@ static void xa_decode_data( xa_decode_t *xdp, unsigned char *srcp ) {
 		} else { // level B/C
 			for (j=0; j < 18; j++) {
 	    		sound_groupsp = srcp + j * 128;		// sound groups header
-	    		sound_datap = sound_groupsp + 16;	// sound data just after the header
+
+				xa_unpack_group( sound_groupsp, lo, hi );
 
 	    		for (i=0; i < nbits; i++) {
-	        		datap = data;
-	        		sound_datap2 = sound_datap + i;
-        			for (k=0; k < 7; k++, sound_datap2 += 16) {
-           					*(datap++) = (u16)(sound_datap2[ 0] & 0x0f) |
-                       				    ((u16)(sound_datap2[ 4] & 0x0f) <<  4) |
-                       				    ((u16)(sound_datap2[ 8] & 0x0f) <<  8) |
-                       				    ((u16)(sound_datap2[12] & 0x0f) << 12);
-					}
-	        		ADPCM_DecodeBlock16( &xdp->left,  sound_groupsp[headtable[i]+0], data,
+					ADPCM_DecodeUnit( &xdp->left, sound_groupsp[headtable[i]+0], lo + i,
                            			    destp, 1 );
+					destp += 28;
 
-	        		destp += 28;
-
-	        		datap = data;
-	        		sound_datap2 = sound_datap + i;
-        			for (k=0; k < 7; k++, sound_datap2 += 16) {
-            				*(datap++) = (u16)(sound_datap2[ 0] >> 4) |
-                       	    		    ((u16)(sound_datap2[ 4] >> 4) <<  4) |
-                        				((u16)(sound_datap2[ 8] >> 4) <<  8) |
-                        				((u16)(sound_datap2[12] >> 4) << 12);
-        			}
-	       			ADPCM_DecodeBlock16( &xdp->left,  sound_groupsp[headtable[i]+1], data,
+					ADPCM_DecodeUnit( &xdp->left, sound_groupsp[headtable[i]+1], hi + i,
                            			    destp, 1 );
-
 					destp += 28;
 				}
     		}
@@ -294,12 +349,55 @@ u8  coding2;
 #define SUB_VIDEO   1
 #define SUB_AUDIO   2
 
+//============================================
+// linear resampling of a decoded sector to 44.1 kHz (Config.XaResample),
+// the position and the last frame carry over to the next sector
+#define XA_OUT_FREQ		44100
+
+static s32		xa_rpos;
+static short	xa_rlast[2];
+static short	xa_rbuf[16384];
+
+static void xa_resample( xa_decode_t *xdp, int freq, int is_first_sector ) {
+	int		n, ch, nch, out;
+	s32		step, idx, frac, a, b;
+	short	*in = xdp->pcm;
+
+	nch = xdp->stereo ? 2 : 1;
+	n = xdp->nsamples;
+	step = (freq << 16) / XA_OUT_FREQ;
+
+	if (is_first_sector) {
+		xa_rpos = 0;
+		xa_rlast[0] = xa_rlast[1] = 0;
+	}
+
+	// position -1 is the last frame of the previous sector
+	for (out = 0; (idx = xa_rpos >> 16) < n - 1; out++, xa_rpos += step) {
+		frac = xa_rpos & 0xffff;
+		for (ch = 0; ch < nch; ch++) {
+			a = (idx < 0) ? xa_rlast[ch] : in[idx * nch + ch];
+			b = in[(idx + 1) * nch + ch];
+			xa_rbuf[out * nch + ch] = a + (((b - a) * frac) >> 16);
+		}
+	}
+	xa_rpos -= n << 16;
+
+	for (ch = 0; ch < nch; ch++)
+		xa_rlast[ch] = in[(n - 1) * nch + ch];
+
+	memcpy(xdp->pcm, xa_rbuf, out * nch * sizeof(short));
+	xdp->nsamples = out;
+	xdp->freq = XA_OUT_FREQ;
+}
+
 //============================================
 static int parse_xa_audio_sector( xa_decode_t *xdp, 
 								  xa_subheader_t *subheadp,
 								  unsigned char *sectorp,
 								  int is_first_sector ) {
-    if ( is_first_sector ) {
+	// resampled sectors leave 44.1 kHz behind, restore the stream format
+    if ( is_first_sector || Config.XaResample ) {
 		switch ( AUDIO_CODING_GET_FREQ(subheadp->coding) ) {
 			case 0: xdp->freq = 37800;   break;
 			case 1: xdp->freq = 18900;   break;
@@ -319,14 +417,19 @@ static int parse_xa_audio_sector( xa_decode_t *xdp,
 		if ( xdp->freq == 0 )
 			return -1;
 
-		ADPCM_InitDecode( &xdp->left );
-		ADPCM_InitDecode( &xdp->right );
+		if ( is_first_sector ) {
+			ADPCM_InitDecode( &xdp->left );
+			ADPCM_InitDecode( &xdp->right );
+		}
 
 		xdp->nsamples = 18 * 28 * 8;
 		if (xdp->stereo == 1) xdp->nsamples /= 2;
     }
 	xa_decode_data( xdp, sectorp );
 
+	if ( Config.XaResample )
+		xa_resample( xdp, xdp->freq, is_first_sector );
+
 	return 0;
 }
 
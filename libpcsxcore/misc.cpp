@@ -31,6 +31,7 @@
 #include "psxbios.h"
 #include "psxcounters.h"
 #include "psxcounters.h"
+#include "spu.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -163,7 +164,11 @@ int LoadCdrom() {
 	unsigned char mdir[4096];
 	char exename[256];
 
-	if (!Config.HLE) {
+	cdrSetTurbo(Config.CdTurbo);
+
+	// the real BIOS is parked at shell entry (psxExecuteBios), let it
+	// play the intro and load the EXE itself unless fast boot is on
+	if (!Config.HLE && !Config.FastBoot) {
 		psxRegs.pc = psxRegs.GPR.n.ra;
 		return 0;
 	}
@@ -507,10 +512,15 @@ int SaveState(char *file) {
 	// spu
 	spufP = (SPUFreeze_t *) malloc(16);
 	SPU_freeze(2, spufP);
-	Size = spufP->Size; gzwrite(f, &Size, 4);
+	Size = spufP->Size;
 	free(spufP);
 	spufP = (SPUFreeze_t *) malloc(Size);
+	spufP->Size = Size;
+	spuFlush();				// the batched writes belong to the state
 	SPU_freeze(1, spufP);
+	if (spufP->Size > 0 && spufP->Size < (uint32_t)Size)	// the info size is the most it can take
+		Size = spufP->Size;
+	gzwrite(f, &Size, 4);
 	gzwrite(f, spufP, Size);
 	free(spufP);
 
@@ -548,6 +558,7 @@ int LoadState(char *file) {
 	gzread(f, psxH, 0x00010000);
 	gzread(f, (void*)&psxRegs, sizeof(psxRegs));
 // 	gzread(f, (void*)&Events, sizeof(Events));
+	spuReset();		// queued writes belong to the old state, cycles start from the loaded ones
 
 	if (Config.HLE)
 		psxBiosFreeze(0);
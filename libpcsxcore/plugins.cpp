@@ -324,6 +324,7 @@ SPUfreeze           SPU_freeze;
 SPUregisterCallback SPU_registerCallback;
 SPUasync            SPU_async;
 SPUplayCDDAchannel  SPU_playCDDAchannel;
+SPUwriteRegisters   SPU_writeRegisters;
 
 void *hSPUDriver = NULL;
 
@@ -572,6 +573,7 @@ int LoadSPUplugin(const char *SPUdll) {
 	LoadSpuSym0(registerCallback, "SPUregisterCallback");
 	LoadSpuSymN(async, "SPUasync");
 	LoadSpuSymN(playCDDAchannel, "SPUplayCDDAchannel");
+	LoadSpuSymN(writeRegisters, "SPUwriteRegisters");
 
 	return 0;
 }
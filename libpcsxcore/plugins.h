@@ -205,6 +205,12 @@ typedef struct {
 typedef long (CALLBACK* SPUfreeze)(uint32_t, SPUFreeze_t *);
 typedef void (CALLBACK* SPUasync)(uint32_t);
 typedef void (CALLBACK* SPUplayCDDAchannel)(short *, int);
+typedef struct {
+	uint32_t cycle;		// psx cycles since the last SPUasync call
+	uint16_t reg;		// address & 0xffff
+	uint16_t val;
+} SPUWrite_t;
+typedef void (CALLBACK* SPUwriteRegisters)(SPUWrite_t *, int);
 
 //SPU POINTERS
 extern SPUconfigure        SPU_configure;
@@ -236,6 +242,7 @@ extern SPUfreeze           SPU_freeze;
 extern SPUregisterCallback SPU_registerCallback;
 extern SPUasync            SPU_async;
 extern SPUplayCDDAchannel  SPU_playCDDAchannel;
+extern SPUwriteRegisters   SPU_writeRegisters;
 
 // PAD Functions
 
@@ -122,6 +122,10 @@ typedef struct {
 	long RCntFix;
 	long UseNet;
 	long VSyncWA;
+	long FastBoot;		/* skip the BIOS intro, boot the EXE at shell entry */
+	long CdTurbo;		/* faster CD reads until the first pad input */
+	long CdTiming;		/* CD-ROM timing profile, see cdrom.h */
+	long XaResample;	/* hand XA to the SPU already at 44.1 kHz */
 } PcsxConfig;
 
 extern PcsxConfig Config;
@@ -27,6 +27,7 @@
 #include "plugins.h"
 #include "psxhw.h"
 #include "psxevents.h"
+#include "spu.h"
 
 using namespace R3000A;
 
@@ -93,6 +94,7 @@ void psxDma4(u32 madr, u32 bcr, u32 chcr) { // SPU
 #endif
 				break;
 			}
+			spuFlush();
 			SPU_writeDMAMem(ptr, size);
 			break;
 
@@ -108,6 +110,7 @@ void psxDma4(u32 madr, u32 bcr, u32 chcr) { // SPU
 				break;
 			}
 
+    		spuFlush();
     		SPU_readDMAMem(ptr, size);
 			psxCpu->Clear(madr, size);
 			break;
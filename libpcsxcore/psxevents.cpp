@@ -22,6 +22,7 @@
 #include "psxdma.h"
 #include "cdrom.h"
 #include "sio.h"
+#include "spu.h"
 #include "plugins.h"
 
 namespace R3000A {
@@ -42,15 +43,6 @@ static void _evthandler_Exception()
 	}
 }
 
-static const u32 SpuRate = (768 * 32);
-
-static void _evthandler_SPU() {
-	if (SPU_async) {
-		SPU_async(SpuRate);		// Peops SPU doesn't really matter what we send.
-		Interrupt.Schedule(PsxEvt_SPU, SpuRate);
-	}
-}
-
 static void _evthandler_Idle()
 {
 	// Note: the idle event handler should only be invoked at times when the full List of
@@ -63,6 +55,7 @@ void ResetEvents()
 // 	if(Events) delete Events;
 // 	Events = new PsxEvents;
 	memset(&Interrupt, 0, sizeof(Interrupt));
+	spuReset();
 
 	Interrupt.Reset();
 }
@@ -74,7 +67,7 @@ void PsxEvents::Reset() {
 	this->List[PsxEvt_CdromRead].Execute	= cdrReadInterrupt;
 	this->List[PsxEvt_GPU].Execute 		= gpuInterrupt;
 	this->List[PsxEvt_OTC].Execute 		= otcInterrupt;
-	this->List[PsxEvt_SPU].Execute 		= _evthandler_SPU;
+	this->List[PsxEvt_SPU].Execute 		= spuInterrupt;
 	this->List[PsxEvt_Counter0].Execute	= psxRcntUpdate0;
 	this->List[PsxEvt_Counter1].Execute	= psxRcntUpdate1;
 	this->List[PsxEvt_Counter2].Execute	= psxRcntUpdate2;
@@ -29,6 +29,7 @@
 #include "mdec.h"
 #include "cdrom.h"
 #include "psxdma.h"
+#include "spu.h"
 
 using namespace R3000A;
 
@@ -179,7 +180,7 @@ u16 psxHwRead16(u32 add) {
 
 		default:
 			if (add >= 0x1f801c00 && add < 0x1f801e00) {
-            	hard = SPU_readRegister(add);
+            	hard = spuReadRegister(add);
 			} else {
 				hard = psxHu16(add);
 #ifdef PSXHW_LOG
@@ -471,7 +472,7 @@ void psxHwWrite16(u32 add, u16 value) {
 
 		default:
 			if (add>=0x1f801c00 && add<0x1f801e00) {
-            	SPU_writeRegister(add, value);
+            	spuWriteRegister(add, value);
 				return;
 			}
 
@@ -26,6 +26,7 @@
 #include "plugins.h"
 #include "psxhw.h"
 #include "sio.h"
+#include "cdrom.h"
 #include "psxevents.h"
 
 using namespace R3000A;
@@ -155,6 +156,13 @@ void sioWrite8(unsigned char value) {
 				}
 			}
 
+			// bytes 3 and 4 of a poll reply are the (active low) buttons, the
+			// player took over. Only for the digital/analog/neGcon ids: the
+			// config mode replies (0xf3, 0x43) carry no buttons there
+			if ((sio.parp == 3 || sio.parp == 4) && sio.buf[sio.parp] != 0xff &&
+				(sio.buf[1] == 0x41 || sio.buf[1] == 0x73 || sio.buf[1] == 0x53 || sio.buf[1] == 0x23))
+				cdrSetTurbo(0);
+
 			if (sio.parp == sio.bufcount) { sio.padst = 0; return; }
 			SIO_INT();
 			return;
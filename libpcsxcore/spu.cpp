@@ -22,7 +22,70 @@
 
 #include "spu.h"
 #include "psxhw.h"
+#include "psxevents.h"
+#include "R3000A/r3000a.h"
+
+using namespace R3000A;
+
+static u32 SpuLastCycle;
+static SPUWrite_t SpuQueue[SPU_QUEUE];	// cycle: psxRegs cycle of the write, until the flush
+static int SpuQueued;
 
 void CALLBACK SPUirq(void) {
 	psxRaiseExtInt( PsxInt_SPU );
 }
+
+void spuInterrupt() {
+	if (SPU_async) {
+		// The cycles since the last call: a cycle mixing SPU mixes exactly
+		// that much, the others don't care. A jump (state load) isn't mixed.
+		spuFlush();
+		u32 elapsed = psxRegs.cycle - SpuLastCycle;
+		if (elapsed > SPU_RATE * 16) elapsed = SPU_RATE;
+		SpuLastCycle = psxRegs.cycle;
+
+		SPU_async(elapsed);
+		Interrupt.Schedule(PsxEvt_SPU, SPU_RATE);
+	}
+}
+
+void spuReset() {
+	SpuLastCycle = psxRegs.cycle;
+	SpuQueued = 0;
+}
+
+// Hands the batched writes to the plugin, each with its cycles since the
+// last SPU_async: a cycle mixing SPU mixes up to there first, so the write
+// lands on its sample instead of the next 32 sample step. Needed before
+// anything that sees the SPU state (reads, dma, freeze) and SPU_async.
+void spuFlush() {
+	int i;
+
+	if (!SpuQueued) return;
+
+	for (i = 0; i < SpuQueued; i++) {
+		u32 offset = SpuQueue[i].cycle - SpuLastCycle;
+		SpuQueue[i].cycle = (offset > SPU_RATE * 16) ? 0 : offset;
+	}
+	SPU_writeRegisters(SpuQueue, SpuQueued);
+	SpuQueued = 0;
+}
+
+// Plugins without SPUwriteRegisters (or SPUasync, no time base) get each
+// write right away, as before.
+void spuWriteRegister(u32 add, u16 value) {
+	if (!SPU_writeRegisters || !SPU_async) {
+		SPU_writeRegister(add, value);
+		return;
+	}
+
+	SpuQueue[SpuQueued].cycle = psxRegs.GetCycle();
+	SpuQueue[SpuQueued].reg = (u16)add;
+	SpuQueue[SpuQueued].val = value;
+	if (++SpuQueued == SPU_QUEUE) spuFlush();
+}
+
+u16 spuReadRegister(u32 add) {
+	spuFlush();
+	return SPU_readRegister(add);
+}
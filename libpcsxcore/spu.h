@@ -35,6 +35,15 @@
 #define H_SPUoff1        0x0d8c
 #define H_SPUoff2        0x0d8e
 
+#define SPU_RATE         (768 * 32)	// SPU_async every 32 samples at 44100 Hz
+#define SPU_QUEUE        256		// register writes batched between two flushes
+
 void CALLBACK SPUirq(void);
 
+void spuInterrupt();
+void spuReset();
+void spuFlush();
+void spuWriteRegister(u32 add, u16 value);
+u16 spuReadRegister(u32 add);
+
 #endif /* __SPU_H__ */
@@ -87,6 +87,7 @@ INLINE int MixADSR(int ch)                             // MIX ADSR
     {
      s_chan[ch].ADSRX.EnvelopeVol=0;
      s_chan[ch].bOn=0;
+     dwChannelOn&=~(1<<ch);
      //s_chan[ch].bReverb=0;
      //s_chan[ch].bNoise=0;
     }
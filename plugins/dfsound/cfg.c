@@ -146,6 +146,34 @@ void ReadConfigFile(void)
  if(iDisStereo<0) iDisStereo=0; 
  if(iDisStereo>1) iDisStereo=1; 
 
+ strcpy(t,"\nOutputFile");p=strstr(pB,t);if(p) {p=strstr(p,"=");len=1;} 
+ if(p)
+  {
+   for(p+=len;*p==' ' || *p=='\t';p++) ;
+   sscanf(p,"%255[^\r\n]",szOutputFile);
+   for(len=strlen(szOutputFile);len && szOutputFile[len-1]==' ';len--) szOutputFile[len-1]=0;
+  }
+
+ strcpy(t,"\nCycleMixing");p=strstr(pB,t);if(p) {p=strstr(p,"=");len=1;} 
+ if(p)  iCycleMixing=atoi(p+len); 
+ if(iCycleMixing<0) iCycleMixing=0; 
+ if(iCycleMixing>1) iCycleMixing=1; 
+ // a file gets written at the emu rate, nothing else makes sense there
+ if(szOutputFile[0]) iCycleMixing=1;
+ // cycle mixing is driven by SPUasync and follows the emu time,
+ // so no thread and no xa pitch by the pc clock
+ if(iCycleMixing) {iUseTimer=2;iXAPitch=0;}
+
+ strcpy(t,"\nOutputLatency");p=strstr(pB,t);if(p) {p=strstr(p,"=");len=1;} 
+ if(p)  iOutputLatency=atoi(p+len); 
+ if(iOutputLatency<20)  iOutputLatency=20; 
+ if(iOutputLatency>500) iOutputLatency=500; 
+
+ strcpy(t,"\nRateControl");p=strstr(pB,t);if(p) {p=strstr(p,"=");len=1;} 
+ if(p)  iRateControl=atoi(p+len); 
+ if(iRateControl<0) iRateControl=0; 
+ if(iRateControl>1) iRateControl=1; 
+
  free(pB);
 }
 
@@ -162,6 +190,10 @@ void ReadConfig(void)
  iUseReverb=2;
  iUseInterpolation=2;
  iDisStereo=0;
+ iCycleMixing=0;
+ iOutputLatency=60;
+ iRateControl=1;
+ szOutputFile[0]=0;
 
  ReadConfigFile();
 }
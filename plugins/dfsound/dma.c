@@ -20,6 +20,7 @@
 #define _IN_DMA
 
 #include "externals.h"
+#include "spu.h"
 
 ////////////////////////////////////////////////////////////////////////
 // READ DMA (one value)
@@ -69,6 +70,7 @@ void CALLBACK SPUreadDMAMem(unsigned short * pusPSXMem,int iSize)
 void CALLBACK SPUwriteDMA(unsigned short val)
 {
  spuMem[spuAddr>>1] = val;                             // spu addr got by writeregister
+ ADPCM_DROP(spuAddr);                                  // decoded sample blocks there are gone
 
  spuAddr+=2;                                           // inc spu addr
  if(spuAddr>0x7ffff) spuAddr=0;                        // wrap
@@ -84,6 +86,8 @@ void CALLBACK SPUwriteDMAMem(unsigned short * pusPSXMem,int iSize)
 {
  int i;
 
+ DropADPCMRange(spuAddr,iSize*2);                      // decoded sample blocks there are gone
+
  for(i=0;i<iSize;i++)
   {
    spuMem[spuAddr>>1] = *pusPSXMem++;                  // spu addr got by writeregister
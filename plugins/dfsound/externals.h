@@ -38,8 +38,6 @@
 // sound buffer sizes
 // 400 ms complete sound buffer
 #define SOUNDSIZE   70560
-// 137 ms test buffer... if less than that is buffered, a new upload will happen
-#define TESTSIZE    24192
 
 // num of channels
 #define MAXCHAN     24
@@ -47,6 +45,23 @@
 // ~ 1 ms of data
 #define NSSIZE 45
 
+// xa filter history: the taps of xafir_i.h - 1
+#define XAFIRHIST   15
+
+// 4 KB spu ram pages, for the freeze deltas (freeze.c)
+#define RAMPAGESHIFT 12
+#define RAMPAGES    (0x80000>>RAMPAGESHIFT)
+
+// adpcm block cache (spu.c): one valid bit per 8 byte spu ram address,
+// a write has to drop the blocks at its address and 8 bytes before
+// (and mark its page dirty)
+#define ADPCMKEYS   0x10000
+#define ADPCM_DROP(addr) \
+ {const unsigned long k_=((addr)>>3)&(ADPCMKEYS-1),j_=(k_-1)&(ADPCMKEYS-1), \
+                      p_=((addr)>>RAMPAGESHIFT)&(RAMPAGES-1); \
+  ADPCMValid[k_>>5]&=~(1u<<(k_&31));ADPCMValid[j_>>5]&=~(1u<<(j_&31)); \
+  RamDirty[p_>>5]|=1u<<(p_&31);}
+
 ///////////////////////////////////////////////////////////
 // struct defines
 ///////////////////////////////////////////////////////////
@@ -193,6 +208,15 @@ typedef struct
  int IN_COEF_R;      // (coef.)
 } REVERBInfo;
 
+///////////////////////////////////////////////////////////
+
+typedef struct                                         // one batched register write (SPUwriteRegisters)
+{
+ uint32_t cycle;     // psx cycles since the last SPUasync call
+ uint16_t reg;       // address & 0xffff (0x1c00...0x1fff)
+ uint16_t val;
+} SPUWrite_t;
+
 ///////////////////////////////////////////////////////////
 // SPU.C globals
 ///////////////////////////////////////////////////////////
@@ -218,9 +242,15 @@ extern int        iRecordMode;
 extern int        iUseReverb;
 extern int        iUseInterpolation;
 extern int        iDisStereo;
+extern int        iCycleMixing;
+extern int        iOutputLatency;
+extern int        iRateControl;
+extern char       szOutputFile[];
 // MISC
 
 extern int iSpuAsyncWait;
+extern uint32_t ADPCMValid[];
+extern uint32_t RamDirty[];
 
 extern SPUCHAN s_chan[];
 extern REVERBInfo rvb;
@@ -234,11 +264,21 @@ extern int      bEndThread;
 extern int      bThreadEnded;
 extern int      bSpuInit;
 extern unsigned long dwNewChannel;
+extern unsigned long dwChannelOn;
 
 extern int      SSumR[];
 extern int      SSumL[];
-extern int      iCycle;
+extern int      iFMod[];
 extern short *  pS;
+extern unsigned char * pMixIrq;
+
+extern int      lastch;
+extern int      lastns;
+extern int      iSecureStart;
+extern unsigned long ulSpuCycles;
+extern long     lSpuSamples;
+extern unsigned long ulSyncCycles;
+extern int      iSliceLen;
 
 extern void (CALLBACK *cddavCallback)(unsigned short,unsigned short);
 
@@ -268,6 +308,13 @@ extern uint32_t * CDDAEnd;
 extern int           iLeftXAVol;
 extern int           iRightXAVol;
 
+extern int           gauss_ptr;
+extern int           gauss_window[];
+extern short         sXAFirL[];
+extern short         sXAFirR[];
+extern int           iXAFirPos;
+extern int           iXAFirStereo;
+
 #endif
 
 ///////////////////////////////////////////////////////////
@@ -282,5 +329,6 @@ extern int *          sRVBStart;
 extern int            iReverbOff;
 extern int            iReverbRepeat;
 extern int            iReverbNum;    
+extern int            iRVBCnt;
 
 #endif
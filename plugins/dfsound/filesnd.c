@@ -0,0 +1,200 @@
+/***************************************************************************
+                          filesnd.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// file output instead of a sound device: the mixed samples go into a
+// .wav file (any other name: raw 16 bit, native byte order). Nothing
+// waits for a clock here, the file gets exactly what the emu time mixed
+// (cycle mixing), as fast as the emu runs - for golden files and
+// benchmarks without an audio device.
+//
+// The mixer fills blocks, an own thread writes the full ones, so the
+// mixer only waits for the disk when all blocks are still pending.
+// Nothing is ever dropped.
+////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+
+#define _IN_FILESND
+
+#include "externals.h"
+#include "filesnd.h"
+
+#define FILEBLOCK   65536                              // bytes per block, ~370 ms stereo
+#define FILEBLOCKS  8
+
+static FILE *           fpOut=NULL;
+static int              bWav=0;
+static int              iFileChans=2;
+static unsigned char    ucBlock[FILEBLOCKS][FILEBLOCK];
+static int              iBlockFill[FILEBLOCKS];
+static int              iCurFill=0;                    // bytes in the block the mixer fills
+static volatile unsigned int uiFull=0;                 // free running, blocks handed to the writer
+static volatile unsigned int uiDone=0;                 // free running, blocks written
+static pthread_t        thFile;
+static volatile int     bFileQuit=0;
+static int              bFileError=0;
+static unsigned long    ulFileBytes=0;                 // sample bytes written
+
+static void FilePut32(unsigned char * p,unsigned long v)
+{
+ p[0]=(unsigned char)v;p[1]=(unsigned char)(v>>8);
+ p[2]=(unsigned char)(v>>16);p[3]=(unsigned char)(v>>24);
+}
+
+static void FilePut16(unsigned char * p,unsigned int v)
+{
+ p[0]=(unsigned char)v;p[1]=(unsigned char)(v>>8);
+}
+
+// canonical 44 byte header: 44100 Hz, 16 bit pcm
+static void FileWavHeader(unsigned long ulData)
+{
+ unsigned char h[44];
+
+ memcpy(h,"RIFF",4);      FilePut32(h+4,36+ulData);
+ memcpy(h+8,"WAVEfmt ",8);FilePut32(h+16,16);
+ FilePut16(h+20,1);                                    // pcm
+ FilePut16(h+22,iFileChans);
+ FilePut32(h+24,44100);
+ FilePut32(h+28,44100*2*iFileChans);                   // bytes per second
+ FilePut16(h+32,2*iFileChans);                         // bytes per frame
+ FilePut16(h+34,16);
+ memcpy(h+36,"data",4);   FilePut32(h+40,ulData);
+
+ fwrite(h,1,44,fpOut);
+}
+
+static void *FileThread(void *arg)
+{
+ unsigned int b;
+
+ for(;;)
+  {
+   if(uiDone==uiFull)
+    {
+     if(bFileQuit) break;                              // all written, and no more coming
+     usleep(1000);
+     continue;
+    }
+   __sync_synchronize();                               // see the block before writing it
+
+   b=uiDone%FILEBLOCKS;
+   if(fwrite(ucBlock[b],1,iBlockFill[b],fpOut)!=(size_t)iBlockFill[b])
+    bFileError=1;
+
+   __sync_synchronize();
+   uiDone++;
+  }
+
+ return NULL;
+}
+
+// current block to the writer, wait for a free one if needed
+static void FileHandOver(void)
+{
+ iBlockFill[uiFull%FILEBLOCKS]=iCurFill;
+ __sync_synchronize();                                 // block first, then the count
+ uiFull++;
+ iCurFill=0;
+
+ while(uiFull-uiDone>=FILEBLOCKS) usleep(1000);        // disk too slow: wait, never drop
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// open the file, returns 0 if that didn't work
+int FileSndOpen(const char * pName)
+{
+ const char * pExt;
+
+ if(fpOut) return 1;
+
+ fpOut=fopen(pName,"wb");
+ if(!fpOut)
+  {
+   fprintf(stderr,"dfsound: can't open output file %s\n",pName);
+   return 0;
+  }
+
+ pExt=strrchr(pName,'.');
+ bWav=pExt && !strcasecmp(pExt,".wav");
+ iFileChans=iDisStereo?1:2;
+ if(bWav) FileWavHeader(0);                            // sizes get fixed at close
+
+ uiFull=uiDone=0;
+ iCurFill=0;
+ ulFileBytes=0;
+ bFileError=0;
+ bFileQuit=0;
+ if(pthread_create(&thFile,NULL,FileThread,NULL)!=0)
+  {
+   fclose(fpOut);fpOut=NULL;
+   return 0;
+  }
+
+ return 1;
+}
+
+void FileSndWrite(short * pSound,int iSamples)
+{
+ unsigned char * p=(unsigned char *)pSound;
+ int iBytes=iSamples*2,n;
+
+ if(!fpOut) return;
+ ulFileBytes+=iBytes;
+
+ while(iBytes)
+  {
+   n=FILEBLOCK-iCurFill;
+   if(n>iBytes) n=iBytes;
+#ifdef WORDS_BIGENDIAN
+   {
+    int i;                                             // .wav is little endian
+    for(i=0;i<n;i+=2)
+     {
+      ucBlock[uiFull%FILEBLOCKS][iCurFill+i]  =p[i+(bWav?1:0)];
+      ucBlock[uiFull%FILEBLOCKS][iCurFill+i+1]=p[i+(bWav?0:1)];
+     }
+   }
+#else
+   memcpy(ucBlock[uiFull%FILEBLOCKS]+iCurFill,p,n);
+#endif
+   iCurFill+=n;p+=n;iBytes-=n;
+
+   if(iCurFill==FILEBLOCK) FileHandOver();
+  }
+}
+
+void FileSndClose(void)
+{
+ if(!fpOut) return;
+
+ if(iCurFill) FileHandOver();                          // the rest
+ bFileQuit=1;
+ pthread_join(thFile,NULL);
+
+ if(bWav)
+  {
+   fseek(fpOut,0,SEEK_SET);
+   FileWavHeader(ulFileBytes);
+  }
+ if(fclose(fpOut)!=0) bFileError=1;
+ fpOut=NULL;
+
+ printf("dfsound: %.1f s (%lu samples) written%s\n",
+        ulFileBytes/(2.0*iFileChans*44100),ulFileBytes/2,
+        bFileError?", write error!":"");
+}
@@ -0,0 +1,18 @@
+/***************************************************************************
+                          filesnd.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+int  FileSndOpen(const char * pName);
+void FileSndWrite(short * pSound,int iSamples);
+void FileSndClose(void);
@@ -51,77 +51,157 @@ typedef struct
 
 } SPUOSSFreeze_t;
 
+////////////////////////////////////////////////////////////////////////
+// version 6: after name, version and size there is a row of sections
+// (up to ulFreezeSize), each an id and its size. Unknown ids get
+// skipped, and a section struct only ever grows at its end: the load
+// takes what is there and leaves the rest 0. So v6 states stay
+// readable both ways when a section grows later.
+//
+// The spu ram is either all there (SEC_RAM, every full save is the
+// base for the deltas after it), or from mode 3 only the 4 KB pages
+// written since that base (SEC_RAMDELTA). A delta can only be loaded
+// while its base is still the one in here: it's for snapshots kept in
+// memory (rewind and such), never for files.
+//
+// Unlike v5 all of the mixer state is in there (the stream rings, the
+// reverb and the xa filters, a slice cut by an irq...), so a load goes
+// on exactly where the save was. The output ring isn't: what is in
+// there is the sound device's past, it simply plays on.
 ////////////////////////////////////////////////////////////////////////
 
-void LoadStateV5(SPUFreeze_t * pF);                    // newest version
-void LoadStateUnknown(SPUFreeze_t * pF);               // unknown format
+#define SEC_REGS      1                                // regArea, 0x200 bytes
+#define SEC_RAM       2                                // id, spu ram
+#define SEC_RAMDELTA  3                                // SPURamDelta_t, then the dirty pages
+#define SEC_MIX       4                                // SPUMixFreeze_t
+#define SEC_CHAN      5                                // s_chan[MAXCHAN], pointers as offsets
+#define SEC_XA        6                                // SPUXAFreeze_t
+#define SEC_XARING    7                                // xa ring from the play pos on
+#define SEC_CDDARING  8                                // cdda ring from the play pos on
+#define SEC_REVERB    9                                // SPURvbFreeze_t
+#define SEC_RVBBUF    10                               // reverb buffer
+#define SEC_MAX       11
 
-////////////////////////////////////////////////////////////////////////
-// SPUFREEZE: called by main emu on savestate load/save
-////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+ uint32_t ulId;
+ uint32_t ulSize;                                      // data bytes after this
+} SPUSection_t;
 
-long CALLBACK SPUfreeze(uint32_t ulFreezeMode,SPUFreeze_t * pF)
+typedef struct
 {
- int i;SPUOSSFreeze_t * pFO;
+ uint32_t ulBase;                                      // id of the full save it is against
+ uint32_t dwPages[RAMPAGES/32];                        // the pages that follow
+} SPURamDelta_t;
 
- if(!pF) return 0;                                     // first check
+typedef struct
+{
+ uint16_t spuCtrl;
+ uint16_t spuStat;
+ uint16_t spuIrq;
+ uint16_t dummy0;
+ uint32_t spuAddr;
+ uint32_t pSpuIrq;                                     // spu ram offset+1, 0: none
+ uint32_t pMixIrq;
+ uint32_t dwNewChannel;
+ uint32_t dwChannelOn;
+ uint32_t dwNoiseVal;
+ int32_t  iSpuAsyncWait;
+ int32_t  lastch;                                      // >=0: an irq cut the slice there
+ int32_t  lastns;
+ int32_t  iSecureStart;
+ uint32_t ulSpuCycles;
+ int32_t  lSpuSamples;
+ int32_t  SSumL[NSSIZE];                               // the slice so far
+ int32_t  SSumR[NSSIZE];
+ int32_t  iFMod[NSSIZE];
+ int32_t  iSliceLen;                                   // a short slice for a batched write
+ uint32_t ulSyncCycles;
+} SPUMixFreeze_t;
 
- if(ulFreezeMode)                                      // info or save?
-  {//--------------------------------------------------//
-   if(ulFreezeMode==1)                                 
-    memset(pF,0,sizeof(SPUFreeze_t)+sizeof(SPUOSSFreeze_t));
+typedef struct
+{
+ int32_t  iLeftXAVol;
+ int32_t  iRightXAVol;
+ uint32_t XARepeat;
+ uint32_t XALastVal;
+ uint32_t XAPlay;                                      // ring positions
+ uint32_t CDDAPlay;
+ int32_t  gauss_ptr;
+ int32_t  gauss_window[8];
+ int32_t  iXAFirPos;
+ int32_t  iXAFirStereo;
+ int16_t  sXAFirL[XAFIRHIST];
+ int16_t  sXAFirR[XAFIRHIST];
+} SPUXAFreeze_t;
 
-   strcpy(pF->szSPUName,"PBOSS");
-   pF->ulFreezeVersion=5;
-   pF->ulFreezeSize=sizeof(SPUFreeze_t)+sizeof(SPUOSSFreeze_t);
+typedef struct
+{
+ REVERBInfo rvb;
+ int32_t  iRVBCnt;
+ int32_t  iReverbOff;
+ int32_t  iReverbRepeat;
+ int32_t  iReverbNum;
+ uint32_t sRVBPlay;                                    // position in the buffer
+} SPURvbFreeze_t;
 
-   if(ulFreezeMode==2) return 1;                       // info mode? ok, bye
-                                                       // save mode:
-   RemoveTimer();                                      // stop timer
+////////////////////////////////////////////////////////////////////////
 
-   memcpy(pF->cSPURam,spuMem,0x80000);                 // copy common infos
-   memcpy(pF->cSPUPort,regArea,0x200);
+static unsigned short spuMemBase[256*1024];            // spu ram at the last full save/load
+static uint32_t      ulBaseId=0;                       // and its id, 0: none
 
-   if(xapGlobal && XAPlay!=XAFeed)                     // some xa
-    {
-     pF->xaS=*xapGlobal;     
-    }
-   else 
-   memset(&pF->xaS,0,sizeof(xa_decode_t));             // or clean xa
+static SPUSection_t * pSecOpen;                        // the section being written
+
+long SaveStateV6(SPUFreeze_t * pF,int bDelta);         // newest version
+long LoadStateV6(SPUFreeze_t * pF);
+void LoadStateV5(SPUFreeze_t * pF);
+void LoadStateUnknown(SPUFreeze_t * pF);               // unknown format
 
-   pFO=(SPUOSSFreeze_t *)(pF+1);                       // store special stuff
+////////////////////////////////////////////////////////////////////////
+// SPUFREEZE: called by main emu on savestate load/save
+//  0: load, 1: save, 2: info (the most a save can take)
+//  3: save, the spu ram as a delta if possible (see above)
+// a save puts its real size into ulFreezeSize
+////////////////////////////////////////////////////////////////////////
 
-   pFO->spuIrq=spuIrq;
-   if(pSpuIrq)  pFO->pSpuIrq  = (unsigned long)pSpuIrq-(unsigned long)spuMemC;
+static uint32_t FreezeMaxSize(void);
 
-   for(i=0;i<MAXCHAN;i++)
-    {
-     memcpy((void *)&pFO->s_chan[i],(void *)&s_chan[i],sizeof(SPUCHAN));
-     if(pFO->s_chan[i].pStart)
-      pFO->s_chan[i].pStart-=(unsigned long)spuMemC;
-     if(pFO->s_chan[i].pCurr)
-      pFO->s_chan[i].pCurr-=(unsigned long)spuMemC;
-     if(pFO->s_chan[i].pLoop)
-      pFO->s_chan[i].pLoop-=(unsigned long)spuMemC;
-    }
+long CALLBACK SPUfreeze(uint32_t ulFreezeMode,SPUFreeze_t * pF)
+{
+ int i;
 
-   SetupTimer();                                       // sound processing on again
+ if(!pF) return 0;                                     // first check
 
+ if(ulFreezeMode==2)                                   // info mode? ok, bye
+  {
+   memset(pF->szSPUName,0,8);
+   strcpy(pF->szSPUName,"PBOSS");
+   pF->ulFreezeVersion=6;
+   pF->ulFreezeSize=FreezeMaxSize();
    return 1;
-   //--------------------------------------------------//
   }
+
+ if(ulFreezeMode==1 || ulFreezeMode==3)                // save mode
+  return SaveStateV6(pF,ulFreezeMode==3);
                                                        
  if(ulFreezeMode!=0) return 0;                         // bad mode? bye
 
+ if(!strcmp(pF->szSPUName,"PBOSS") &&                  
+    pF->ulFreezeVersion==6)
+  return LoadStateV6(pF);
+
  RemoveTimer();                                        // we stop processing while doing the save!
 
  memcpy(spuMem,pF->cSPURam,0x80000);                   // get ram
+ DropADPCMAll();                                       // -> and nothing decoded of it yet
  memcpy(regArea,pF->cSPUPort,0x200);
 
  if(pF->xaS.nsamples<=4032)                            // start xa again
   SPUplayADPCMchannel(&pF->xaS);
 
  xapGlobal=0;
+ iSliceLen=NSSIZE;                                     // whole slices, nothing batched
+ ulSyncCycles=0;
 
  if(!strcmp(pF->szSPUName,"PBOSS") &&                  
     pF->ulFreezeVersion==5)
@@ -148,6 +228,398 @@ long CALLBACK SPUfreeze(uint32_t ulFreezeMode,SPUFreeze_t * pF)
  return 1;
 }
 
+////////////////////////////////////////////////////////////////////////
+// v6 helpers
+////////////////////////////////////////////////////////////////////////
+
+// only the thread mixes on its own, in the other modes nothing happens
+// until the emu calls again. Going on keeps the slice (and its restored
+// sums), SetupTimer would clear them
+
+static void FreezeStop(void)
+{
+ if(!iUseTimer) RemoveTimer();
+}
+
+static void FreezeGo(void)
+{
+ if(!iUseTimer) StartTimer();
+}
+
+static unsigned char * SecOpen(unsigned char * p,uint32_t ulId)
+{
+ pSecOpen=(SPUSection_t *)p;
+ pSecOpen->ulId=ulId;
+ return p+sizeof(SPUSection_t);
+}
+
+static unsigned char * SecClose(unsigned char * p)
+{
+ pSecOpen->ulSize=p-(unsigned char *)(pSecOpen+1);
+ return p;
+}
+
+static unsigned char * SecPut(unsigned char * p,uint32_t ulId,const void * pData,uint32_t ulSize)
+{
+ p=SecOpen(p,ulId);
+ memcpy(p,pData,ulSize);
+ return SecClose(p+ulSize);
+}
+
+// struct of a loaded section: what is there, the rest 0
+static int SecGet(void * pDst,uint32_t ulSize,unsigned char ** pSec,uint32_t * ulSec,int iId)
+{
+ memset(pDst,0,ulSize);
+ if(!pSec[iId]) return 0;
+ memcpy(pDst,pSec[iId],ulSec[iId]<ulSize?ulSec[iId]:ulSize);
+ return 1;
+}
+
+// voice pointers as spu ram offsets+2, 0: none, 1: the -1 end mark
+static unsigned char * PtrToOff(unsigned char * p)
+{
+ if(!p) return 0;
+ if(p==(unsigned char *)-1) return (unsigned char *)1;
+ return (unsigned char *)(unsigned long)(p-spuMemC+2);
+}
+
+static unsigned char * OffToPtr(unsigned char * p)
+{
+ unsigned long l=(unsigned long)p;
+ if(l<2) return l?(unsigned char *)-1:NULL;
+ return spuMemC+(l-2);
+}
+
+static unsigned char * RingSave(unsigned char * p,uint32_t * pPlay,uint32_t * pFeed,uint32_t * pStart,uint32_t * pEnd)
+{
+ if(!pStart) return p;
+ if(pFeed<pPlay)
+  {
+   memcpy(p,pPlay,(pEnd-pPlay)*4);p+=(pEnd-pPlay)*4;
+   pPlay=pStart;
+  }
+ memcpy(p,pPlay,(pFeed-pPlay)*4);
+ return p+(pFeed-pPlay)*4;
+}
+
+// n samples back in at the play pos, returns the feed pos
+static uint32_t * RingLoad(const unsigned char * p,uint32_t n,uint32_t * pPlay,uint32_t * pStart,uint32_t * pEnd)
+{
+ uint32_t k=pEnd-pPlay;
+
+ if(n>(uint32_t)(pEnd-pStart)-1) n=(pEnd-pStart)-1;    // (can't be, but it's a ring)
+ if(n<k) {memcpy(pPlay,p,n*4);return pPlay+n;}
+ memcpy(pPlay,p,k*4);
+ memcpy(pStart,p+k*4,(n-k)*4);
+ return pStart+(n-k);
+}
+
+static uint32_t FreezeMaxSize(void)
+{
+ uint32_t ulSize=16+SEC_MAX*sizeof(SPUSection_t);
+
+ ulSize+=0x200+4+0x80000;                              // a delta is smaller than that
+ ulSize+=sizeof(SPUMixFreeze_t)+MAXCHAN*sizeof(SPUCHAN);
+ ulSize+=sizeof(SPUXAFreeze_t)+sizeof(SPURvbFreeze_t);
+ if(XAStart)   ulSize+=(XAEnd-XAStart)*4;
+ if(CDDAStart) ulSize+=(CDDAEnd-CDDAStart)*4;
+ if(sRVBStart) ulSize+=(sRVBEnd-sRVBStart)*4;
+
+ return ulSize;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+long SaveStateV6(SPUFreeze_t * pF,int bDelta)
+{
+ unsigned char * p=pF->cSPUPort;                       // the sections start where v5 had the ports
+ SPUMixFreeze_t m;SPUXAFreeze_t x;SPURvbFreeze_t r;
+ SPURamDelta_t d;SPUCHAN c;
+ int i,iPages=0;
+
+ FreezeStop();
+
+ memset(pF->szSPUName,0,8);
+ strcpy(pF->szSPUName,"PBOSS");
+ pF->ulFreezeVersion=6;
+
+ p=SecPut(p,SEC_REGS,regArea,0x200);
+
+ //--------------------------------------------------// spu ram
+ for(i=0;i<RAMPAGES/32;i++)
+  {
+   uint32_t v=RamDirty[i];
+   while(v) {iPages++;v&=v-1;}
+  }
+
+ if(bDelta && ulBaseId && iPages<=RAMPAGES/2)          // delta: only the pages written since the base
+  {
+   d.ulBase=ulBaseId;
+   memcpy(d.dwPages,RamDirty,sizeof(d.dwPages));
+   p=SecOpen(p,SEC_RAMDELTA);
+   memcpy(p,&d,sizeof(d));p+=sizeof(d);
+   for(i=0;i<RAMPAGES;i++)
+    {
+     if(!(RamDirty[i>>5]&(1u<<(i&31)))) continue;
+     memcpy(p,spuMemC+(i<<RAMPAGESHIFT),1<<RAMPAGESHIFT);
+     p+=1<<RAMPAGESHIFT;
+    }
+   p=SecClose(p);
+  }
+ else                                                  // all, and that's the new base
+  {
+   if(ulBaseId) ulBaseId++;
+   else
+    {
+     struct timeval tv;                                // some id no other session had
+     gettimeofday(&tv,0);
+     ulBaseId=(uint32_t)(tv.tv_sec^(tv.tv_usec<<12))|1;
+    }
+   memcpy(spuMemBase,spuMem,0x80000);
+   memset(RamDirty,0,sizeof(d.dwPages));
+
+   p=SecOpen(p,SEC_RAM);
+   memcpy(p,&ulBaseId,4);
+   memcpy(p+4,spuMem,0x80000);
+   p=SecClose(p+4+0x80000);
+  }
+
+ //--------------------------------------------------// mixer
+ memset(&m,0,sizeof(m));
+ m.spuCtrl=spuCtrl;
+ m.spuStat=spuStat;
+ m.spuIrq=spuIrq;
+ m.spuAddr=spuAddr;
+ m.pSpuIrq=pSpuIrq?pSpuIrq-spuMemC+1:0;
+ m.pMixIrq=pMixIrq?pMixIrq-spuMemC+1:0;
+ m.dwNewChannel=dwNewChannel;
+ m.dwChannelOn=dwChannelOn;
+ m.dwNoiseVal=dwNoiseVal;
+ m.iSpuAsyncWait=iSpuAsyncWait;
+ m.lastch=lastch;
+ m.lastns=lastns;
+ m.iSecureStart=iSecureStart;
+ m.ulSpuCycles=ulSpuCycles;
+ m.lSpuSamples=lSpuSamples;
+ memcpy(m.SSumL,SSumL,sizeof(m.SSumL));
+ memcpy(m.SSumR,SSumR,sizeof(m.SSumR));
+ memcpy(m.iFMod,iFMod,sizeof(m.iFMod));
+ m.iSliceLen=iSliceLen;
+ m.ulSyncCycles=ulSyncCycles;
+ p=SecPut(p,SEC_MIX,&m,sizeof(m));
+
+ p=SecOpen(p,SEC_CHAN);
+ for(i=0;i<MAXCHAN;i++)
+  {
+   c=s_chan[i];
+   c.pStart=PtrToOff(c.pStart);
+   c.pCurr =PtrToOff(c.pCurr);
+   c.pLoop =PtrToOff(c.pLoop);
+   memcpy(p,&c,sizeof(SPUCHAN));p+=sizeof(SPUCHAN);
+  }
+ p=SecClose(p);
+
+ //--------------------------------------------------// xa and cdda
+ memset(&x,0,sizeof(x));
+ x.iLeftXAVol=iLeftXAVol;
+ x.iRightXAVol=iRightXAVol;
+ x.XARepeat=XARepeat;
+ x.XALastVal=XALastVal;
+ x.XAPlay=XAStart?XAPlay-XAStart:0;
+ x.CDDAPlay=CDDAStart?CDDAPlay-CDDAStart:0;
+ x.gauss_ptr=gauss_ptr;
+ memcpy(x.gauss_window,gauss_window,sizeof(x.gauss_window));
+ x.iXAFirPos=iXAFirPos;
+ x.iXAFirStereo=iXAFirStereo;
+ memcpy(x.sXAFirL,sXAFirL,sizeof(x.sXAFirL));
+ memcpy(x.sXAFirR,sXAFirR,sizeof(x.sXAFirR));
+ p=SecPut(p,SEC_XA,&x,sizeof(x));
+
+ p=SecClose(RingSave(SecOpen(p,SEC_XARING),XAPlay,XAFeed,XAStart,XAEnd));
+ p=SecClose(RingSave(SecOpen(p,SEC_CDDARING),CDDAPlay,CDDAFeed,CDDAStart,CDDAEnd));
+
+ //--------------------------------------------------// reverb
+ memset(&r,0,sizeof(r));
+ r.rvb=rvb;
+ r.iRVBCnt=iRVBCnt;
+ r.iReverbOff=iReverbOff;
+ r.iReverbRepeat=iReverbRepeat;
+ r.iReverbNum=iReverbNum;
+ r.sRVBPlay=sRVBStart?sRVBPlay-sRVBStart:0;
+ p=SecPut(p,SEC_REVERB,&r,sizeof(r));
+
+ if(sRVBStart)
+  p=SecPut(p,SEC_RVBBUF,sRVBStart,(sRVBEnd-sRVBStart)*4);
+
+ pF->ulFreezeSize=p-(unsigned char *)pF;
+
+ FreezeGo();
+
+ return 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+long LoadStateV6(SPUFreeze_t * pF)
+{
+ unsigned char * pSec[SEC_MAX];uint32_t ulSec[SEC_MAX];
+ unsigned char * p=pF->cSPUPort,* pEnd=(unsigned char *)pF+pF->ulFreezeSize;
+ SPUMixFreeze_t m;SPUXAFreeze_t x;SPURvbFreeze_t r;
+ SPURamDelta_t d;SPUSection_t s;
+ uint32_t ulBase=0,n;
+ int i,iPages=0;
+
+ memset(pSec,0,sizeof(pSec));
+ memset(ulSec,0,sizeof(ulSec));
+ while(pEnd-p>=(long)sizeof(SPUSection_t))             // where is what
+  {
+   memcpy(&s,p,sizeof(s));p+=sizeof(s);
+   if(s.ulSize>(uint32_t)(pEnd-p)) break;              // cut off
+   if(s.ulId<SEC_MAX) {pSec[s.ulId]=p;ulSec[s.ulId]=s.ulSize;}
+   p+=s.ulSize;
+  }
+
+ // all or nothing: the ram has to be there (a delta against our base),
+ // and the voices in our layout
+
+ if(!pSec[SEC_REGS] || !pSec[SEC_MIX] ||
+    ulSec[SEC_CHAN]!=MAXCHAN*sizeof(SPUCHAN)) return 0;
+
+ if(pSec[SEC_RAM])
+  {
+   if(ulSec[SEC_RAM]!=4+0x80000) return 0;
+   memcpy(&ulBase,pSec[SEC_RAM],4);
+  }
+ else
+  {
+   if(ulSec[SEC_RAMDELTA]<sizeof(d)) return 0;
+   memcpy(&d,pSec[SEC_RAMDELTA],sizeof(d));
+   if(!ulBaseId || d.ulBase!=ulBaseId) return 0;       // not our base (any more)
+   for(i=0;i<RAMPAGES;i++)
+    if(d.dwPages[i>>5]&(1u<<(i&31))) iPages++;
+   if(ulSec[SEC_RAMDELTA]!=sizeof(d)+(iPages<<RAMPAGESHIFT)) return 0;
+  }
+
+ FreezeStop();
+
+ memcpy(regArea,pSec[SEC_REGS],ulSec[SEC_REGS]<0x200?ulSec[SEC_REGS]:0x200);
+
+ //--------------------------------------------------// spu ram
+ if(pSec[SEC_RAM])                                     // all: that's the base now
+  {
+   memcpy(spuMem,pSec[SEC_RAM]+4,0x80000);
+   DropADPCMAll();
+   memcpy(spuMemBase,spuMem,0x80000);
+   ulBaseId=ulBase;
+   memset(RamDirty,0,sizeof(d.dwPages));
+  }
+ else                                                  // delta: the base, with its pages on top
+  {
+   p=pSec[SEC_RAMDELTA]+sizeof(d);
+   for(i=0;i<RAMPAGES;i++)
+    {
+     unsigned char * pPage=spuMemC+(i<<RAMPAGESHIFT);
+     if(d.dwPages[i>>5]&(1u<<(i&31)))
+      {memcpy(pPage,p,1<<RAMPAGESHIFT);p+=1<<RAMPAGESHIFT;}
+     else
+     if(RamDirty[i>>5]&(1u<<(i&31)))                   // the others differ only where we wrote since
+      memcpy(pPage,(unsigned char *)spuMemBase+(i<<RAMPAGESHIFT),1<<RAMPAGESHIFT);
+    }
+   DropADPCMAll();
+   memcpy(RamDirty,d.dwPages,sizeof(d.dwPages));
+  }
+
+ //--------------------------------------------------// mixer
+ SecGet(&m,sizeof(m),pSec,ulSec,SEC_MIX);
+ spuCtrl=m.spuCtrl;
+ spuStat=m.spuStat;
+ spuIrq=m.spuIrq;
+ spuAddr=m.spuAddr;
+ pSpuIrq=m.pSpuIrq?spuMemC+((m.pSpuIrq-1)&0x7ffff):0;
+ pMixIrq=m.pMixIrq?spuMemC+((m.pMixIrq-1)&0x3ff):0;
+ dwNewChannel=m.dwNewChannel;
+ dwChannelOn=m.dwChannelOn;
+ dwNoiseVal=m.dwNoiseVal;
+ iSpuAsyncWait=m.iSpuAsyncWait;
+ lastch=m.lastch<MAXCHAN?m.lastch:-1;
+ lastns=m.lastns;
+ iSecureStart=m.iSecureStart;
+ ulSpuCycles=m.ulSpuCycles;
+ lSpuSamples=m.lSpuSamples;
+ memcpy(SSumL,m.SSumL,sizeof(m.SSumL));
+ memcpy(SSumR,m.SSumR,sizeof(m.SSumR));
+ memcpy(iFMod,m.iFMod,sizeof(m.iFMod));
+ iSliceLen=(m.iSliceLen>0 && m.iSliceLen<=NSSIZE)?m.iSliceLen:NSSIZE; // (0: a state from before)
+ ulSyncCycles=m.ulSyncCycles;
+ if(lastns>=iSliceLen) lastch=-1;
+
+ p=pSec[SEC_CHAN];
+ for(i=0;i<MAXCHAN;i++)
+  {
+   memcpy((void *)&s_chan[i],p,sizeof(SPUCHAN));p+=sizeof(SPUCHAN);
+   s_chan[i].pStart=OffToPtr(s_chan[i].pStart);
+   s_chan[i].pCurr =OffToPtr(s_chan[i].pCurr);
+   s_chan[i].pLoop =OffToPtr(s_chan[i].pLoop);
+  }
+
+ //--------------------------------------------------// xa and cdda
+ xapGlobal=0;
+ if(SecGet(&x,sizeof(x),pSec,ulSec,SEC_XA))
+  {
+   iLeftXAVol=x.iLeftXAVol;
+   iRightXAVol=x.iRightXAVol;
+   XARepeat=x.XARepeat;
+   XALastVal=x.XALastVal;
+   gauss_ptr=x.gauss_ptr&3;
+   memcpy(gauss_window,x.gauss_window,sizeof(x.gauss_window));
+   iXAFirPos=x.iXAFirPos;
+   iXAFirStereo=x.iXAFirStereo;
+   memcpy(sXAFirL,x.sXAFirL,sizeof(x.sXAFirL));
+   memcpy(sXAFirR,x.sXAFirR,sizeof(x.sXAFirR));
+
+   if(XAStart)
+    {
+     XAPlay=XAStart+(x.XAPlay<(uint32_t)(XAEnd-XAStart)?x.XAPlay:0);
+     n=ulSec[SEC_XARING]/4;
+     XAFeed=RingLoad(pSec[SEC_XARING],n,XAPlay,XAStart,XAEnd);
+    }
+   if(CDDAStart)
+    {
+     CDDAPlay=CDDAStart+(x.CDDAPlay<(uint32_t)(CDDAEnd-CDDAStart)?x.CDDAPlay:0);
+     n=ulSec[SEC_CDDARING]/4;
+     CDDAFeed=RingLoad(pSec[SEC_CDDARING],n,CDDAPlay,CDDAStart,CDDAEnd);
+    }
+  }
+
+ //--------------------------------------------------// reverb
+ if(SecGet(&r,sizeof(r),pSec,ulSec,SEC_REVERB))
+  {
+   rvb=r.rvb;
+   iRVBCnt=r.iRVBCnt;
+   iReverbOff=r.iReverbOff;
+   iReverbRepeat=r.iReverbRepeat;
+   iReverbNum=r.iReverbNum;
+
+   if(sRVBStart)                                       // (its size depends on the reverb mode)
+    {
+     n=sRVBEnd-sRVBStart;
+     memset(sRVBStart,0,n*4);
+     memcpy(sRVBStart,pSec[SEC_RVBBUF],ulSec[SEC_RVBBUF]<n*4?ulSec[SEC_RVBBUF]:n*4);
+     sRVBPlay=sRVBStart+(r.sRVBPlay<n?r.sRVBPlay:0);
+    }
+  }
+
+ if(cddavCallback)                                     // the main emu wants the cd volume
+  {
+   cddavCallback(0,regArea[(H_CDLeft-0xc00)>>1]);
+   cddavCallback(1,regArea[(H_CDRight-0xc00)>>1]);
+  }
+
+ FreezeGo();
+
+ return 1;
+}
+
 ////////////////////////////////////////////////////////////////////////
 
 void LoadStateV5(SPUFreeze_t * pF)
@@ -169,6 +641,13 @@ void LoadStateV5(SPUFreeze_t * pF)
    s_chan[i].iMute=0;
    s_chan[i].iIrqDone=0;
   }
+
+ dwChannelOn=dwNewChannel=0;                           // the flags of the voices as they were saved
+ for(i=0;i<MAXCHAN;i++)
+  {
+   if(s_chan[i].bOn)  dwChannelOn |=(1<<i);
+   if(s_chan[i].bNew) dwNewChannel|=(1<<i);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -191,6 +670,7 @@ void LoadStateUnknown(SPUFreeze_t * pF)
   }
 
  dwNewChannel=0;
+ dwChannelOn=0;
  pSpuIrq=0;
 
  for(i=0;i<0xc0;i++)
@@ -46,6 +46,7 @@ void CALLBACK SPUputOne(unsigned long val,unsigned short data)
   }
  if(val>=512*1024) val=512*1024-1;
  spuMem[val>>1] = data;
+ ADPCM_DROP(val);
 }
 
 void CALLBACK SPUplaySample(unsigned char ch)
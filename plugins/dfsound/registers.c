@@ -23,6 +23,7 @@
 #include "registers.h"
 #include "regs.h"
 #include "reverb.h"
+#include "spu.h"
 
 /*
 // adsr time values (in ms) by James Higgs ... see the end of
@@ -181,6 +182,7 @@ void CALLBACK SPUwriteRegister(unsigned long reg, unsigned short val)
     //-------------------------------------------------//
     case H_SPUdata:
       spuMem[spuAddr>>1] = val;
+      ADPCM_DROP(spuAddr);
       spuAddr+=2;
       if(spuAddr>0x7ffff) spuAddr=0;
       break;
@@ -344,6 +346,24 @@ void CALLBACK SPUwriteRegister(unsigned long reg, unsigned short val)
  iSpuAsyncWait=0;
 }
 
+////////////////////////////////////////////////////////////////////////
+// WRITE REGISTERS: a batch of writes, called by main emu before SPUasync
+////////////////////////////////////////////////////////////////////////
+
+// each write comes with the psx cycles since the last SPUasync call:
+// with cycle mixing the samples up to there get mixed first, so a key
+// on lands on its sample and not on the next 1 ms slice. The emu flushes
+// its batch before reads, dma and the SPUasync call itself.
+
+void CALLBACK SPUwriteRegisters(SPUWrite_t * pW,int iCount)
+{
+ for(;iCount>0;iCount--,pW++)
+  {
+   if(iCycleMixing) MixToCycle(pW->cycle);             // the samples before the write
+   SPUwriteRegister(0x1f800000|pW->reg,pW->val);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////
 // READ REGISTER: called by main emu
 ////////////////////////////////////////////////////////////////////////
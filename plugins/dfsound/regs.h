@@ -24,4 +24,5 @@ void SetVolumeR(unsigned char ch,short vol);
 void SetPitch(int ch,unsigned short val);
 void ReverbOn(int start,int end,unsigned short val);
 void CALLBACK SPUwriteRegister(unsigned long reg, unsigned short val);
+void CALLBACK SPUwriteRegisters(SPUWrite_t * pW,int iCount);
 
@@ -129,115 +129,238 @@ INLINE void StoreREVERB(int ch,int ns)
 }
 
 ////////////////////////////////////////////////////////////////////////
+// NEILL'S REVERB
+////////////////////////////////////////////////////////////////////////
+// The reverb works at 22 khz, on every second sample of the slice, and
+// each step reads and writes the work area at 28 places (taps) around
+// the current addr. MixREVERBNeill does a whole slice at once: the
+// taps are wrapped at the area end once, and then just move on by one
+// sample per step until one of them gets to the end (once a slice at
+// most, with a sane work area). The four IIR lanes (A0,A1,B0,B1), the
+// eight ACC products and the four MIX outputs of a step are done as
+// vectors, with the same 32 bit products and rounding towards 0 as the
+// scalar math.
+////////////////////////////////////////////////////////////////////////
+
+#define RVB_IIR_SRC    0                               // A0,A1,B0,B1
+#define RVB_IIR_DEST   4                               // A0,A1,B0,B1 (read)
+#define RVB_IIR_DEST1  8                               // A0,A1,B0,B1, one sample later (written)
+#define RVB_ACC_SRC   12                               // A0,B0,C0,D0,A1,B1,C1,D1
+#define RVB_FB_SRC    20                               // MIX_DEST_A0/A1 - FB_SRC_A, MIX_DEST_B0/B1 - FB_SRC_B
+#define RVB_MIX_DEST  24                               // A0,A1,B0,B1
+#define RVB_TAPS      28
+
+int iRVBCnt=0;                                         // counts the 44.1 khz samples: the odd ones do a step
 
-INLINE int g_buffer(int iOff)                          // get_buffer content helper: takes care about wraps
+static INLINE int RVBWrap(int iOff)                    // work area wrap of a sample addr
 {
- short * p=(short *)spuMem;
- iOff=(iOff*4)+rvb.CurrAddr;
  while(iOff>0x3FFFF)       iOff=rvb.StartAddr+(iOff-0x40000);
  while(iOff<rvb.StartAddr) iOff=0x3ffff-(rvb.StartAddr-iOff);
- return (int)*(p+iOff);
+ return iOff;
 }
 
-////////////////////////////////////////////////////////////////////////
+static INLINE void RVBTaps(int * pTap)                 // tap offsets in samples, relative to the curr addr
+{
+ int i;
+
+ pTap[RVB_IIR_SRC+0]=rvb.IIR_SRC_A0;   pTap[RVB_IIR_SRC+1]=rvb.IIR_SRC_A1;
+ pTap[RVB_IIR_SRC+2]=rvb.IIR_SRC_B0;   pTap[RVB_IIR_SRC+3]=rvb.IIR_SRC_B1;
+ pTap[RVB_IIR_DEST+0]=rvb.IIR_DEST_A0; pTap[RVB_IIR_DEST+1]=rvb.IIR_DEST_A1;
+ pTap[RVB_IIR_DEST+2]=rvb.IIR_DEST_B0; pTap[RVB_IIR_DEST+3]=rvb.IIR_DEST_B1;
+ pTap[RVB_ACC_SRC+0]=rvb.ACC_SRC_A0;   pTap[RVB_ACC_SRC+1]=rvb.ACC_SRC_B0;
+ pTap[RVB_ACC_SRC+2]=rvb.ACC_SRC_C0;   pTap[RVB_ACC_SRC+3]=rvb.ACC_SRC_D0;
+ pTap[RVB_ACC_SRC+4]=rvb.ACC_SRC_A1;   pTap[RVB_ACC_SRC+5]=rvb.ACC_SRC_B1;
+ pTap[RVB_ACC_SRC+6]=rvb.ACC_SRC_C1;   pTap[RVB_ACC_SRC+7]=rvb.ACC_SRC_D1;
+ pTap[RVB_FB_SRC+0]=rvb.MIX_DEST_A0-rvb.FB_SRC_A;
+ pTap[RVB_FB_SRC+1]=rvb.MIX_DEST_A1-rvb.FB_SRC_A;
+ pTap[RVB_FB_SRC+2]=rvb.MIX_DEST_B0-rvb.FB_SRC_B;
+ pTap[RVB_FB_SRC+3]=rvb.MIX_DEST_B1-rvb.FB_SRC_B;
+ pTap[RVB_MIX_DEST+0]=rvb.MIX_DEST_A0; pTap[RVB_MIX_DEST+1]=rvb.MIX_DEST_A1;
+ pTap[RVB_MIX_DEST+2]=rvb.MIX_DEST_B0; pTap[RVB_MIX_DEST+3]=rvb.MIX_DEST_B1;
+
+ for(i=0;i<RVB_TAPS;i++) pTap[i]*=4;
+ for(i=0;i<4;i++)        pTap[RVB_IIR_DEST1+i]=pTap[RVB_IIR_DEST+i]+1;
+}
 
-INLINE void s_buffer(int iOff,int iVal)                // set_buffer content helper: takes care about wraps and clipping
+// the tap addrs for the curr addr, wrapped: returns for how many steps
+// they just move on by one sample (the curr addr or a tap reaches the
+// area end; coming from below the start, the wrap is a sample earlier)
+static INLINE int RVBAddrs(int * pAddr,const int * pTap)
 {
- short * p=(short *)spuMem;
- iOff=(iOff*4)+rvb.CurrAddr;
- while(iOff>0x3FFFF) iOff=rvb.StartAddr+(iOff-0x40000);
- while(iOff<rvb.StartAddr) iOff=0x3ffff-(rvb.StartAddr-iOff);
- if(iVal<-32768L) iVal=-32768L;if(iVal>32767L) iVal=32767L;
- *(p+iOff)=(short)iVal;
+ int i,iOff,iRun=0x40000-rvb.CurrAddr;
+
+ for(i=0;i<RVB_TAPS;i++)
+  {
+   iOff=rvb.CurrAddr+pTap[i];
+   pAddr[i]=RVBWrap(iOff);
+   iOff=(iOff<rvb.StartAddr?0x3ffff:0x40000)-pAddr[i];
+   if(iOff<iRun) iRun=iOff;
+  }
+ return iRun;
 }
 
-////////////////////////////////////////////////////////////////////////
+// iSteps steps were done with the tap addrs: drop the adpcm blocks of
+// what they wrote (a voice might play the reverb area)
+static INLINE void RVBDrop(const int * pAddr,int iSteps)
+{
+ int i;
 
-INLINE void s_buffer1(int iOff,int iVal)                // set_buffer (+1 sample) content helper: takes care about wraps and clipping
+ if(!iSteps) return;
+ for(i=0;i<4;i++)
+  {
+   DropADPCMRange(pAddr[RVB_IIR_DEST1+i]<<1,iSteps<<1);
+   DropADPCMRange(pAddr[RVB_MIX_DEST+i]<<1,iSteps<<1);
+  }
+}
+
+#ifdef __SSE2__
+// (a*b)/32768 in 4 lanes: from the low 32 bits of the products, like
+// the int math, and rounding towards 0, like /
+static __inline __m128i RVBMul(__m128i a,__m128i b)
+{
+ __m128i e=_mm_mul_epu32(a,b);                         // lanes 0,2 (64 bit)
+ __m128i o=_mm_mul_epu32(_mm_srli_epi64(a,32),_mm_srli_epi64(b,32)); // lanes 1,3
+ __m128i p=_mm_unpacklo_epi32(_mm_shuffle_epi32(e,_MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(o,_MM_SHUFFLE(0,0,2,0)));
+ p=_mm_add_epi32(p,_mm_and_si128(_mm_srai_epi32(p,31),_mm_set1_epi32(0x7fff)));
+ return _mm_srai_epi32(p,15);
+}
+
+static __inline __m128i RVBGet(short * p,const int * pA)  // 4 taps
+{
+ return _mm_setr_epi32(p[pA[0]],p[pA[1]],p[pA[2]],p[pA[3]]);
+}
+
+static __inline void RVBPut(short * p,const int * pA,__m128i v) // 4 taps, clipped
+{
+ short s[8];int i;
+
+ _mm_storeu_si128((__m128i *)s,_mm_packs_epi32(v,v));
+ for(i=0;i<4;i++) p[pA[i]]=s[i];
+}
+#else
+static INLINE void RVBSet(short * p,int iVal)          // clipped store
 {
- short * p=(short *)spuMem;
- iOff=(iOff*4)+rvb.CurrAddr+1;
- while(iOff>0x3FFFF) iOff=rvb.StartAddr+(iOff-0x40000);
- while(iOff<rvb.StartAddr) iOff=0x3ffff-(rvb.StartAddr-iOff);
  if(iVal<-32768L) iVal=-32768L;if(iVal>32767L) iVal=32767L;
- *(p+iOff)=(short)iVal;
+ *p=(short)iVal;
 }
+#endif
 
 ////////////////////////////////////////////////////////////////////////
 
-INLINE int MixREVERBLeft(int ns)
+// one 22 khz step, the taps are at p[pA[i]]
+static INLINE void REVERBStep(short * p,const int * pA,int INPUT_SAMPLE_L,int INPUT_SAMPLE_R)
 {
- if(iUseReverb==0) return 0;
- else
- if(iUseReverb==2)
-  {
-   static int iCnt=0;                                  // this func will be called with 44.1 khz
+#ifdef __SSE2__
+ __m128i iir,acc,a,b;
+
+ // IIR: A0,A1,B0,B1
+
+ a=_mm_add_epi32(RVBMul(RVBGet(p,pA+RVB_IIR_SRC),_mm_set1_epi32(rvb.IIR_COEF)),
+                 RVBMul(_mm_setr_epi32(INPUT_SAMPLE_L,INPUT_SAMPLE_R,INPUT_SAMPLE_L,INPUT_SAMPLE_R),
+                        _mm_setr_epi32(rvb.IN_COEF_L,rvb.IN_COEF_R,rvb.IN_COEF_L,rvb.IN_COEF_R)));
+ iir=_mm_add_epi32(RVBMul(a,_mm_set1_epi32(rvb.IIR_ALPHA)),
+                   RVBMul(RVBGet(p,pA+RVB_IIR_DEST),_mm_set1_epi32(32768-rvb.IIR_ALPHA)));
+ RVBPut(p,pA+RVB_IIR_DEST1,iir);
+
+ // ACC: A..D of 0 and of 1, summed up to ACC0,ACC1,ACC0,ACC1
+
+ b=_mm_setr_epi32(rvb.ACC_COEF_A,rvb.ACC_COEF_B,rvb.ACC_COEF_C,rvb.ACC_COEF_D);
+ a=RVBMul(RVBGet(p,pA+RVB_ACC_SRC),b);
+ b=RVBMul(RVBGet(p,pA+RVB_ACC_SRC+4),b);
+ acc=_mm_add_epi32(_mm_unpacklo_epi64(a,b),_mm_unpackhi_epi64(a,b));
+ acc=_mm_add_epi32(acc,_mm_shuffle_epi32(acc,_MM_SHUFFLE(2,3,0,1)));
+ acc=_mm_shuffle_epi32(acc,_MM_SHUFFLE(2,0,2,0));
+
+ // MIX: A0,A1 = ACC - FB_A*FB_ALPHA, B0,B1 = ACC*FB_ALPHA - FB_A*(FB_ALPHA^0x8000) - FB_B*FB_X
+
+ a=RVBGet(p,pA+RVB_FB_SRC);
+ b=_mm_unpackhi_epi64(_mm_setzero_si128(),a);          // 0,0,FB_B0,FB_B1
+ a=_mm_unpacklo_epi64(a,a);                            // FB_A0,FB_A1,FB_A0,FB_A1
+ acc=_mm_unpacklo_epi64(acc,RVBMul(acc,_mm_set1_epi32(rvb.FB_ALPHA)));
+ acc=_mm_sub_epi32(acc,RVBMul(a,_mm_setr_epi32(rvb.FB_ALPHA,rvb.FB_ALPHA,
+                                              (int)(rvb.FB_ALPHA^0xFFFF8000),(int)(rvb.FB_ALPHA^0xFFFF8000))));
+ acc=_mm_sub_epi32(acc,RVBMul(b,_mm_set1_epi32(rvb.FB_X)));
+ RVBPut(p,pA+RVB_MIX_DEST,acc);
+#else
+ int ACC0,ACC1,FB_A0,FB_A1,FB_B0,FB_B1;
+
+ const int IIR_INPUT_A0 = (p[pA[RVB_IIR_SRC+0]] * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_L * rvb.IN_COEF_L)/32768L;
+ const int IIR_INPUT_A1 = (p[pA[RVB_IIR_SRC+1]] * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_R * rvb.IN_COEF_R)/32768L;
+ const int IIR_INPUT_B0 = (p[pA[RVB_IIR_SRC+2]] * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_L * rvb.IN_COEF_L)/32768L;
+ const int IIR_INPUT_B1 = (p[pA[RVB_IIR_SRC+3]] * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_R * rvb.IN_COEF_R)/32768L;
+
+ const int IIR_A0 = (IIR_INPUT_A0 * rvb.IIR_ALPHA)/32768L + (p[pA[RVB_IIR_DEST+0]] * (32768L - rvb.IIR_ALPHA))/32768L;
+ const int IIR_A1 = (IIR_INPUT_A1 * rvb.IIR_ALPHA)/32768L + (p[pA[RVB_IIR_DEST+1]] * (32768L - rvb.IIR_ALPHA))/32768L;
+ const int IIR_B0 = (IIR_INPUT_B0 * rvb.IIR_ALPHA)/32768L + (p[pA[RVB_IIR_DEST+2]] * (32768L - rvb.IIR_ALPHA))/32768L;
+ const int IIR_B1 = (IIR_INPUT_B1 * rvb.IIR_ALPHA)/32768L + (p[pA[RVB_IIR_DEST+3]] * (32768L - rvb.IIR_ALPHA))/32768L;
+
+ RVBSet(p+pA[RVB_IIR_DEST1+0], IIR_A0);
+ RVBSet(p+pA[RVB_IIR_DEST1+1], IIR_A1);
+ RVBSet(p+pA[RVB_IIR_DEST1+2], IIR_B0);
+ RVBSet(p+pA[RVB_IIR_DEST1+3], IIR_B1);
+
+ ACC0 = (p[pA[RVB_ACC_SRC+0]] * rvb.ACC_COEF_A)/32768L +
+        (p[pA[RVB_ACC_SRC+1]] * rvb.ACC_COEF_B)/32768L +
+        (p[pA[RVB_ACC_SRC+2]] * rvb.ACC_COEF_C)/32768L +
+        (p[pA[RVB_ACC_SRC+3]] * rvb.ACC_COEF_D)/32768L;
+ ACC1 = (p[pA[RVB_ACC_SRC+4]] * rvb.ACC_COEF_A)/32768L +
+        (p[pA[RVB_ACC_SRC+5]] * rvb.ACC_COEF_B)/32768L +
+        (p[pA[RVB_ACC_SRC+6]] * rvb.ACC_COEF_C)/32768L +
+        (p[pA[RVB_ACC_SRC+7]] * rvb.ACC_COEF_D)/32768L;
+
+ FB_A0 = p[pA[RVB_FB_SRC+0]];
+ FB_A1 = p[pA[RVB_FB_SRC+1]];
+ FB_B0 = p[pA[RVB_FB_SRC+2]];
+ FB_B1 = p[pA[RVB_FB_SRC+3]];
+
+ RVBSet(p+pA[RVB_MIX_DEST+0], ACC0 - (FB_A0 * rvb.FB_ALPHA)/32768L);
+ RVBSet(p+pA[RVB_MIX_DEST+1], ACC1 - (FB_A1 * rvb.FB_ALPHA)/32768L);
+
+ RVBSet(p+pA[RVB_MIX_DEST+2], (rvb.FB_ALPHA * ACC0)/32768L - (FB_A0 * (int)(rvb.FB_ALPHA^0xFFFF8000))/32768L - (FB_B0 * rvb.FB_X)/32768L);
+ RVBSet(p+pA[RVB_MIX_DEST+3], (rvb.FB_ALPHA * ACC1)/32768L - (FB_A1 * (int)(rvb.FB_ALPHA^0xFFFF8000))/32768L - (FB_B1 * rvb.FB_X)/32768L);
+#endif
 
-   if(!rvb.StartAddr)                                  // reverb is off
-    {
-     rvb.iLastRVBLeft=rvb.iLastRVBRight=rvb.iRVBLeft=rvb.iRVBRight=0;
-     return 0;
-    }
+ rvb.iLastRVBLeft  = rvb.iRVBLeft;
+ rvb.iLastRVBRight = rvb.iRVBRight;
 
-   iCnt++;                                    
+ rvb.iRVBLeft  = (p[pA[RVB_MIX_DEST+0]]+p[pA[RVB_MIX_DEST+2]])/3;
+ rvb.iRVBRight = (p[pA[RVB_MIX_DEST+1]]+p[pA[RVB_MIX_DEST+3]])/3;
 
-   if(iCnt&1)                                          // we work on every second left value: downsample to 22 khz
-    {
-     if(spuCtrl&0x80)                                  // -> reverb on? oki
-      {
-       int ACC0,ACC1,FB_A0,FB_A1,FB_B0,FB_B1;
+ rvb.iRVBLeft  = (rvb.iRVBLeft  * rvb.VolLeft)  / 0x4000;
+ rvb.iRVBRight = (rvb.iRVBRight * rvb.VolRight) / 0x4000;
+}
 
-       const int INPUT_SAMPLE_L=*(sRVBStart+(ns<<1));                         
-       const int INPUT_SAMPLE_R=*(sRVBStart+(ns<<1)+1);                     
+////////////////////////////////////////////////////////////////////////
 
-       const int IIR_INPUT_A0 = (g_buffer(rvb.IIR_SRC_A0) * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_L * rvb.IN_COEF_L)/32768L;
-       const int IIR_INPUT_A1 = (g_buffer(rvb.IIR_SRC_A1) * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_R * rvb.IN_COEF_R)/32768L;
-       const int IIR_INPUT_B0 = (g_buffer(rvb.IIR_SRC_B0) * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_L * rvb.IN_COEF_L)/32768L;
-       const int IIR_INPUT_B1 = (g_buffer(rvb.IIR_SRC_B1) * rvb.IIR_COEF)/32768L + (INPUT_SAMPLE_R * rvb.IN_COEF_R)/32768L;
+static INLINE void MixREVERBNeill(void)
+{
+ int iTap[RVB_TAPS],iAddr[RVB_TAPS];
+ int ns,iRun=0,iStep=0;
 
-       const int IIR_A0 = (IIR_INPUT_A0 * rvb.IIR_ALPHA)/32768L + (g_buffer(rvb.IIR_DEST_A0) * (32768L - rvb.IIR_ALPHA))/32768L;
-       const int IIR_A1 = (IIR_INPUT_A1 * rvb.IIR_ALPHA)/32768L + (g_buffer(rvb.IIR_DEST_A1) * (32768L - rvb.IIR_ALPHA))/32768L;
-       const int IIR_B0 = (IIR_INPUT_B0 * rvb.IIR_ALPHA)/32768L + (g_buffer(rvb.IIR_DEST_B0) * (32768L - rvb.IIR_ALPHA))/32768L;
-       const int IIR_B1 = (IIR_INPUT_B1 * rvb.IIR_ALPHA)/32768L + (g_buffer(rvb.IIR_DEST_B1) * (32768L - rvb.IIR_ALPHA))/32768L;
+ if(!rvb.StartAddr)                                    // reverb is off
+  {
+   rvb.iLastRVBLeft=rvb.iLastRVBRight=rvb.iRVBLeft=rvb.iRVBRight=0;
+   return;
+  }
 
-       s_buffer1(rvb.IIR_DEST_A0, IIR_A0);
-       s_buffer1(rvb.IIR_DEST_A1, IIR_A1);
-       s_buffer1(rvb.IIR_DEST_B0, IIR_B0);
-       s_buffer1(rvb.IIR_DEST_B1, IIR_B1);
- 
-       ACC0 = (g_buffer(rvb.ACC_SRC_A0) * rvb.ACC_COEF_A)/32768L +
-              (g_buffer(rvb.ACC_SRC_B0) * rvb.ACC_COEF_B)/32768L +
-              (g_buffer(rvb.ACC_SRC_C0) * rvb.ACC_COEF_C)/32768L +
-              (g_buffer(rvb.ACC_SRC_D0) * rvb.ACC_COEF_D)/32768L;
-       ACC1 = (g_buffer(rvb.ACC_SRC_A1) * rvb.ACC_COEF_A)/32768L +
-              (g_buffer(rvb.ACC_SRC_B1) * rvb.ACC_COEF_B)/32768L +
-              (g_buffer(rvb.ACC_SRC_C1) * rvb.ACC_COEF_C)/32768L +
-              (g_buffer(rvb.ACC_SRC_D1) * rvb.ACC_COEF_D)/32768L;
-
-       FB_A0 = g_buffer(rvb.MIX_DEST_A0 - rvb.FB_SRC_A);
-       FB_A1 = g_buffer(rvb.MIX_DEST_A1 - rvb.FB_SRC_A);
-       FB_B0 = g_buffer(rvb.MIX_DEST_B0 - rvb.FB_SRC_B);
-       FB_B1 = g_buffer(rvb.MIX_DEST_B1 - rvb.FB_SRC_B);
-
-       s_buffer(rvb.MIX_DEST_A0, ACC0 - (FB_A0 * rvb.FB_ALPHA)/32768L);
-       s_buffer(rvb.MIX_DEST_A1, ACC1 - (FB_A1 * rvb.FB_ALPHA)/32768L);
-       
-       s_buffer(rvb.MIX_DEST_B0, (rvb.FB_ALPHA * ACC0)/32768L - (FB_A0 * (int)(rvb.FB_ALPHA^0xFFFF8000))/32768L - (FB_B0 * rvb.FB_X)/32768L);
-       s_buffer(rvb.MIX_DEST_B1, (rvb.FB_ALPHA * ACC1)/32768L - (FB_A1 * (int)(rvb.FB_ALPHA^0xFFFF8000))/32768L - (FB_B1 * rvb.FB_X)/32768L);
- 
-       rvb.iLastRVBLeft  = rvb.iRVBLeft;
-       rvb.iLastRVBRight = rvb.iRVBRight;
+ RVBTaps(iTap);
 
-       rvb.iRVBLeft  = (g_buffer(rvb.MIX_DEST_A0)+g_buffer(rvb.MIX_DEST_B0))/3;
-       rvb.iRVBRight = (g_buffer(rvb.MIX_DEST_A1)+g_buffer(rvb.MIX_DEST_B1))/3;
+ for(ns=0;ns<iSliceLen;ns++)
+  {
+   iRVBCnt++;
 
-       rvb.iRVBLeft  = (rvb.iRVBLeft  * rvb.VolLeft)  / 0x4000;
-       rvb.iRVBRight = (rvb.iRVBRight * rvb.VolRight) / 0x4000;
+   if(iRVBCnt&1)                                       // we work on every second value: downsample to 22 khz
+    {
+     if(spuCtrl&0x80)                                  // -> reverb on? oki
+      {
+       if(iStep>=iRun)                                 // -> wrap the taps only now and then
+        {RVBDrop(iAddr,iStep);iRun=RVBAddrs(iAddr,iTap);iStep=0;}
 
-       rvb.CurrAddr++;
-       if(rvb.CurrAddr>0x3ffff) rvb.CurrAddr=rvb.StartAddr;
+       REVERBStep((short *)spuMem+iStep,iAddr,sRVBStart[ns<<1],sRVBStart[(ns<<1)+1]);
+       iStep++;
 
-       return rvb.iLastRVBLeft+(rvb.iRVBLeft-rvb.iLastRVBLeft)/2;
+       SSumL[ns]+=rvb.iLastRVBLeft+(rvb.iRVBLeft-rvb.iLastRVBLeft)/2;
       }
      else                                              // -> reverb off
       {
@@ -247,41 +370,39 @@ INLINE int MixREVERBLeft(int ns)
      rvb.CurrAddr++;
      if(rvb.CurrAddr>0x3ffff) rvb.CurrAddr=rvb.StartAddr;
     }
+   else SSumL[ns]+=rvb.iLastRVBLeft;
 
-   return rvb.iLastRVBLeft;
-  }
- else                                                  // easy fake reverb:
-  {
-   const int iRV=*sRVBPlay;                            // -> simply take the reverb mix buf value
-   *sRVBPlay++=0;                                      // -> init it after
-   if(sRVBPlay>=sRVBEnd) sRVBPlay=sRVBStart;           // -> and take care about wrap arounds
-   return iRV;                                         // -> return reverb mix buf val
+   // the right val is always scaled by the previous right val
+   SSumR[ns]+=rvb.iLastRVBRight+(rvb.iRVBRight-rvb.iLastRVBRight)/2;
+   rvb.iLastRVBRight=rvb.iRVBRight;
   }
+
+ RVBDrop(iAddr,iStep);
 }
 
+////////////////////////////////////////////////////////////////////////
+// MIX REVERB: adds the reverb of the slice to SSumL/SSumR
 ////////////////////////////////////////////////////////////////////////
 
-INLINE int MixREVERBRight(void)
+static INLINE void MixREVERB(void)
 {
- if(iUseReverb==0) return 0;
+ int ns;
+
+ if(iUseReverb==2) MixREVERBNeill();                   // Neill's reverb
  else
- if(iUseReverb==2)                                     // Neill's reverb:
+ if(iUseReverb==1)                                     // easy fake reverb:
   {
-   int i=rvb.iLastRVBRight+(rvb.iRVBRight-rvb.iLastRVBRight)/2;
-   rvb.iLastRVBRight=rvb.iRVBRight;
-   return i;                                           // -> just return the last right reverb val (little bit scaled by the previous right val)
-  }
- else                                                  // easy fake reverb:
-  {
-   const int iRV=*sRVBPlay;                            // -> simply take the reverb mix buf value
-   *sRVBPlay++=0;                                      // -> init it after
-   if(sRVBPlay>=sRVBEnd) sRVBPlay=sRVBStart;           // -> and take care about wrap arounds
-   return iRV;                                         // -> return reverb mix buf val
+   for(ns=0;ns<iSliceLen;ns++)
+    {
+     SSumL[ns]+=sRVBPlay[0];                           // -> simply take the reverb mix buf values
+     SSumR[ns]+=sRVBPlay[1];
+     sRVBPlay[0]=sRVBPlay[1]=0;                        // -> init them after
+     sRVBPlay+=2;
+     if(sRVBPlay>=sRVBEnd) sRVBPlay=sRVBStart;         // -> and take care about wrap arounds
+    }
   }
 }
 
-////////////////////////////////////////////////////////////////////////
-
 #endif
 
 /*
@@ -0,0 +1,297 @@
+/***************************************************************************
+                           ring.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// sample ring between the mixer and the sound driver: the mixer puts
+// each slice in, an own thread takes it out and feeds the driver, which
+// may block there as long as it likes. One writer, one reader, so the
+// two positions are all the sync we need.
+//
+// The mixer keeps about iOutputLatency ms in the ring (cycle mixing:
+// the emu time decides, else RingFull stops it). The driver clock and
+// the emu clock never quite agree, so with iRateControl and cycle
+// mixing the feeder plays the ring a bit faster or slower (up to 0.5%,
+// linear interpolation) to hold the fill at that target, instead of
+// running dry (underrun: a crackle) or over (overrun: samples dropped)
+// now and then. Close to the target it plays the samples as they are.
+// Without cycle mixing RingFull already holds the fill, so there is no
+// rate control.
+//
+// With an OutputFile there is no driver and no thread: RingWrite hands
+// the slices straight to filesnd.c, which has its own writer.
+////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+
+#define _IN_RING
+
+#include "externals.h"
+#include "dsoundoss.h"
+#include "ring.h"
+#include "filesnd.h"
+
+#define RINGSIZE   131072                              // samples (not frames), power of 2: ~1.5 s stereo
+#define RINGCHUNK  256                                 // max frames per driver call, ~6 ms
+#define RATEMAX    328                                 // max rate change, 1/65536 steps: 0.5%
+#define RATEGAIN   1311                                // rate change at 100% off the target: 2%
+#define RATEDEAD   16                                  // smaller rate changes snap back to 1.0
+
+static short            sRing[RINGSIZE];
+static short            sOut[RINGCHUNK*2];
+static volatile unsigned int uiRingWrite=0;            // free running, only the mixer moves it
+static volatile unsigned int uiRingRead=0;             // free running, only the feeder moves it
+static pthread_t        thRing;
+static int              bRingRunning=0;
+static volatile int     bRingQuit=0;
+static int              bRingFile=0;                   // output file instead of the driver
+
+static int              iRingChans=2;                  // samples per frame
+static unsigned int     uiTarget;                      // fill target, samples
+static unsigned int     uiFrac=0;                      // feeder position between two frames, 16.16
+static unsigned int     uiStep=0x10000;                // frames per output frame, 16.16
+static unsigned int     uiFillAvg;                     // smoothed fill, samples*16
+
+// stats (mixer and feeder count their own)
+static volatile unsigned long ulUnderruns=0,ulOverruns=0,ulDropped=0;
+static unsigned long    ulPlayed=0;                    // frames fed
+static unsigned int     uiFillMin,uiFillMax;           // samples, since the last RingStats
+static volatile int     bFillReset=0;                  // RingStats asks the feeder to restart min/max
+static double           dFillSum=0;
+static unsigned long    ulFillCnt=0;
+
+// rate for the smoothed fill: more than the target -> play faster
+static void RingRate(unsigned int uiFill)
+{
+ int d;
+
+ uiFillAvg+=(int)(uiFill*16-uiFillAvg)/64;
+
+ if(!iRateControl || !iCycleMixing) {uiStep=0x10000;return;}
+
+ d=(int)((((long long)uiFillAvg/16-(long long)uiTarget)*RATEGAIN)/(long long)uiTarget);
+ if(d> RATEMAX) d= RATEMAX;
+ if(d<-RATEMAX) d=-RATEMAX;
+ if(d<RATEDEAD && d>-RATEDEAD) d=0;                    // near the target: back to the plain copy
+ uiStep=0x10000+d;
+}
+
+// n frames from the ring at r into sOut, resampled by uiStep: returns
+// the frames used up
+static unsigned int RingResample(unsigned int r,unsigned int n)
+{
+ unsigned int i,f,pos=uiFrac;
+ int c,a,b;
+
+ for(i=0;i<n;i++,pos+=uiStep)
+  {
+   f=r+(pos>>16)*iRingChans;
+   for(c=0;c<iRingChans;c++)
+    {
+     a=sRing[(f+c)&(RINGSIZE-1)];
+     b=sRing[(f+iRingChans+c)&(RINGSIZE-1)];
+     sOut[i*iRingChans+c]=(short)(a+(((b-a)*(int)((pos&0xffff)>>1))>>15)); // 15 bit fraction: fits an int
+    }
+  }
+
+ uiFrac=pos&0xffff;
+ return pos>>16;
+}
+
+static void *RingThread(void *arg)
+{
+ unsigned int r,n,off,used;
+ int bPlaying=0;
+
+ while(!bRingQuit)
+  {
+   if(SoundGetBytesBuffered()) {usleep(1000);continue;} // driver still has enough
+
+   r=uiRingRead;
+   n=uiRingWrite-r;
+
+   if(!bPlaying)                                       // (re)start: wait for half the target first
+    {
+     if(n<uiTarget/2) {usleep(1000);continue;}
+     bPlaying=1;
+     uiFillAvg=uiTarget*16;
+     uiFrac=0;
+    }
+
+   if(n<(unsigned int)iRingChans*2)                    // ran dry: the emu is slower than the driver
+    {
+     ulUnderruns++;
+     bPlaying=0;
+     continue;
+    }
+   __sync_synchronize();                               // see the samples before using them
+
+   if(bFillReset)                                      // only the feeder writes min/max
+    {
+     uiFillMin=0xffffffff;uiFillMax=0;
+     bFillReset=0;
+    }
+   if(n<uiFillMin) uiFillMin=n;
+   if(n>uiFillMax) uiFillMax=n;
+   dFillSum+=n;ulFillCnt++;
+   RingRate(n);
+
+   if(uiStep==0x10000 && !uiFrac)                      // on time: the samples as they are
+    {
+     off=r&(RINGSIZE-1);
+     if(n>RINGSIZE-off) n=RINGSIZE-off;                // up to the ring end, the rest next time
+     if(n>RINGCHUNK*(unsigned int)iRingChans) n=RINGCHUNK*iRingChans;
+     n-=n%iRingChans;
+
+     SoundFeedStreamData((unsigned char *)(sRing+off),n*2);
+     used=n;
+     ulPlayed+=n/iRingChans;
+    }
+   else
+    {
+     n=n/iRingChans-1;                                 // frames we may interpolate into
+     n=(unsigned int)((((unsigned long long)n<<16)-uiFrac)/uiStep);
+     if(n>RINGCHUNK) n=RINGCHUNK;
+     if(!n) {usleep(1000);continue;}
+
+     used=RingResample(r,n)*iRingChans;
+     SoundFeedStreamData((unsigned char *)sOut,n*iRingChans*2);
+     ulPlayed+=n;
+    }
+
+   __sync_synchronize();                               // done with them before giving them back
+   uiRingRead=r+used;
+  }
+
+ return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+// mixer side: copy iSamples in, whatever doesn't fit is dropped (the
+// emu runs faster than the driver plays). Returns what was taken.
+int RingWrite(short * pSound,int iSamples)
+{
+ unsigned int w=uiRingWrite,n,off;
+
+ if(bRingFile)
+  {
+   FileSndWrite(pSound,iSamples);
+   return iSamples;
+  }
+
+ n=RINGSIZE-(w-uiRingRead);
+ if((unsigned int)iSamples<n) n=iSamples;
+ n-=n%iRingChans;                                      // whole frames only
+ if(n<(unsigned int)iSamples)
+  {
+   ulOverruns++;
+   ulDropped+=iSamples-n;
+  }
+
+ off=w&(RINGSIZE-1);
+ if(n>RINGSIZE-off)
+  {
+   memcpy(sRing+off,pSound,(RINGSIZE-off)*2);
+   memcpy(sRing,pSound+(RINGSIZE-off),(n-(RINGSIZE-off))*2);
+  }
+ else memcpy(sRing+off,pSound,n*2);
+
+ __sync_synchronize();                                 // samples first, then the position
+ uiRingWrite=w+n;
+
+ return n;
+}
+
+// mixer side: is the latency target reached? Then no more mixing for now
+int RingFull(void)
+{
+ if(bRingFile) return 0;                               // the file takes all
+ return uiRingWrite-uiRingRead>=uiTarget;
+}
+
+void RingStart(void)
+{
+ if(bRingRunning || bRingFile) return;
+
+ if(szOutputFile[0])
+  {
+   bRingFile=FileSndOpen(szOutputFile);
+   return;
+  }
+
+ iRingChans=iDisStereo?1:2;
+ uiTarget=(unsigned int)(iOutputLatency*44100/1000)*iRingChans;
+ if(uiTarget>RINGSIZE/2) uiTarget=RINGSIZE/2;
+
+ uiRingWrite=uiRingRead=0;
+ uiStep=0x10000;uiFrac=0;
+ ulUnderruns=ulOverruns=ulDropped=0;
+ ulPlayed=0;
+ uiFillMin=0xffffffff;uiFillMax=0;bFillReset=0;
+ dFillSum=0;ulFillCnt=0;
+
+ bRingQuit=0;
+ if(pthread_create(&thRing,NULL,RingThread,NULL)==0) bRingRunning=1;
+}
+
+void RingStop(void)
+{
+ if(bRingFile)
+  {
+   FileSndClose();
+   bRingFile=0;
+   return;
+  }
+ if(!bRingRunning) return;
+
+ bRingQuit=1;
+ pthread_join(thRing,NULL);
+ bRingRunning=0;
+
+ RingReport();
+}
+
+////////////////////////////////////////////////////////////////////////
+// stats
+////////////////////////////////////////////////////////////////////////
+
+void RingStats(RINGSTATS * pS)
+{
+ const double ms=1000.0/44100/iRingChans;              // per sample
+
+ pS->ulUnderruns=ulUnderruns;
+ pS->ulOverruns=ulOverruns;
+ pS->ulDropped=ulDropped/iRingChans;
+ pS->ulPlayed=ulPlayed;
+ pS->fFill=(uiRingWrite-uiRingRead)*ms;
+ pS->fFillMin=(uiFillMin!=0xffffffff)?uiFillMin*ms:0;
+ pS->fFillAvg=ulFillCnt?dFillSum/ulFillCnt*ms:0;
+ pS->fFillMax=uiFillMax*ms;
+ pS->fRate=uiStep/65536.0f;
+
+ bFillReset=1;                                         // min/max start over, done by the feeder
+}
+
+void RingReport(void)
+{
+ RINGSTATS s;
+
+ RingStats(&s);
+ if(!s.ulPlayed) return;
+
+ printf("dfsound: %.1f s played, %lu underruns, %lu overruns (%lu samples dropped), fill ms min/avg/max %.1f/%.1f/%.1f (target %d), rate %.4f\n",
+        s.ulPlayed/44100.0, s.ulUnderruns, s.ulOverruns, s.ulDropped,
+        s.fFillMin, s.fFillAvg, s.fFillMax, iOutputLatency, s.fRate);
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+                           ring.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _RING_INTERNALS_H
+#define _RING_INTERNALS_H
+
+typedef struct
+{
+ unsigned long ulUnderruns;                            // ring ran dry while playing
+ unsigned long ulOverruns;                             // RingWrite calls that didn't fit
+ unsigned long ulDropped;                              // frames lost by them
+ unsigned long ulPlayed;                               // frames fed to the driver
+ float         fFill;                                  // ms in the ring now
+ float         fFillMin;                               // ms, since the last RingStats
+ float         fFillAvg;                               // ms, since RingStart
+ float         fFillMax;
+ float         fRate;                                  // ring frames per driver frame
+} RINGSTATS;
+
+void RingStart(void);
+void RingStop(void);
+int  RingWrite(short * pSound,int iSamples);
+int  RingFull(void);
+void RingStats(RINGSTATS * pS);
+void RingReport(void);
+
+#endif // _RING_INTERNALS_H
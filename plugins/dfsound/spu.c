@@ -23,6 +23,12 @@
 #include "cfg.h"
 #include "dsoundoss.h"
 #include "regs.h"
+#include "ring.h"
+#include "spu.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #ifdef ENABLE_NLS
 #include <libintl.h>
@@ -56,6 +62,8 @@ unsigned char * spuMemC;
 unsigned char * pSpuIrq=0;
 unsigned char * pSpuBuffer;
 unsigned char * pMixIrq=0;
+uint32_t        ADPCMValid[ADPCMKEYS/32];              // per spu address/8: cached adpcm block still valid?
+uint32_t        RamDirty[RAMPAGES/32];                 // per spu ram page: written since the last full freeze?
 
 // user settings
 
@@ -68,6 +76,10 @@ int             iRecordMode=0;
 int             iUseReverb=2;
 int             iUseInterpolation=2;
 int             iDisStereo=0;
+int             iCycleMixing=0;
+int             iOutputLatency=60;
+int             iRateControl=1;
+char            szOutputFile[256]="";
 
 // MAIN infos struct for each channel
 
@@ -89,6 +101,7 @@ int             bSPUIsOpen=0;
 static pthread_t thread = -1;                          // thread id (linux)
 
 unsigned long dwNewChannel=0;                          // flags for faster testing, if new channel starts
+unsigned long dwChannelOn=0;                           // and the same for the playing ones (bOn)
 
 void (CALLBACK *irqCallback)(void)=0;                  // func of main emu, called on spu irq
 void (CALLBACK *cddavCallback)(unsigned short,unsigned short)=0;
@@ -103,12 +116,20 @@ static const int f[5][2] = {   {    0,  0  },
 int SSumR[NSSIZE];
 int SSumL[NSSIZE];
 int iFMod[NSSIZE];
-int iCycle=0;
 short * pS;
 
-static int lastch=-1;      // last channel processed on spu irq in timer mode
-static int lastns=0;       // last ns pos
-static int iSecureStart=0; // secure start counter
+int lastch=-1;             // last channel processed on spu irq in timer mode
+int lastns=0;              // last ns pos
+int iSecureStart=0;        // secure start counter
+
+// cycle mixing: psx cycles per 44100 Hz sample (33868800/44100), and
+// what SPUasync passed in but wasn't mixed yet
+#define SPUCYCLES 768
+unsigned long ulSpuCycles=0;         // < SPUCYCLES, the rest of the last calls
+long lSpuSamples=0;                  // samples owed, mixed in NSSIZE slices (the rest only for a batched write)
+unsigned long ulSyncCycles=0;        // cycles after the last SPUasync already counted (batched writes)
+int iSliceLen=NSSIZE;                // samples in the slice: less if a batched write needs them now
+static int bMixRest=0;               // MixToCycle: a short slice for the rest as well
 
 ////////////////////////////////////////////////////////////////////////
 // CODE AREA
@@ -250,6 +271,7 @@ INLINE void StartSound(int ch)
  s_chan[ch].bNew=0;                                    // init channel flags
  s_chan[ch].bStop=0;
  s_chan[ch].bOn=1;
+ dwChannelOn|=(1<<ch);
 
  s_chan[ch].SB[29]=0;                                  // init our interpolation helpers
  s_chan[ch].SB[30]=0;
@@ -419,6 +441,220 @@ INLINE int iGetInterpolationVal(int ch)
  return fa;
 }
 
+////////////////////////////////////////////////////////////////////////
+// ADPCM BLOCK CACHE
+// the nibbles of a 16 byte block, sign extended and shifted, only depend
+// on spu ram, so they get kept per block (by its 8 byte spu address,
+// that's how voices address them), and looped/reused samples just run
+// the prediction filter over them. That filter works on the voice's last
+// two samples, so it can't be cached itself... but filter 0 blocks don't
+// have one. Spu ram writes drop the blocks they touch (ADPCM_DROP),
+// and mark their page dirty for the next freeze while at it.
+////////////////////////////////////////////////////////////////////////
+
+#define ADPCMCACHE 4096                                // cached blocks, direct mapped by address
+
+typedef struct
+{
+ int            iAddr;                                 // spu address/8 of the block, -1: none
+ int            iPad;
+ short          sVal[28];                              // samples before the prediction filter
+} ADPCMBLOCK;
+
+static ADPCMBLOCK ADPCMCache[ADPCMCACHE];
+
+void DropADPCMAll(void)
+{
+ memset(ADPCMValid,0,sizeof(ADPCMValid));
+ memset(RamDirty,0xff,sizeof(RamDirty));
+}
+
+void DropADPCMRange(unsigned long addr,long lBytes)    // spu ram addr...addr+lBytes-1 got written (wraps)
+{
+ unsigned long k,n;
+
+ if(lBytes>=0x80000) {DropADPCMAll();return;}
+ if(lBytes<=0) return;
+
+ k=((addr>>3)-1)&(ADPCMKEYS-1);                        // the block 8 bytes before is touched as well
+ n=((addr+lBytes-1)>>3)-(addr>>3)+2;
+ while(n--)
+  {
+   ADPCMValid[k>>5]&=~(1u<<(k&31));
+   k=(k+1)&(ADPCMKEYS-1);
+  }
+
+ k=addr>>RAMPAGESHIFT;                                 // and the pages
+ n=((addr+lBytes-1)>>RAMPAGESHIFT)-k+1;
+ while(n--)
+  {
+   k&=RAMPAGES-1;
+   RamDirty[k>>5]|=1u<<(k&31);
+   k++;
+  }
+}
+
+// block at start -> 28 samples, s_1/s_2 are the filter history in and out
+
+static INLINE void DecodeADPCM(int * pSB,unsigned char * start,int * ps_1,int * ps_2)
+{
+ const int key=(start-spuMemC)>>3;
+ ADPCMBLOCK * pB=&ADPCMCache[key&(ADPCMCACHE-1)];
+ const int predict_nr=start[0]>>4;
+ int s_1=*ps_1,s_2=*ps_2,fa,i;
+
+ if(pB->iAddr!=key ||                                  // not cached or dropped meanwhile? expand the nibbles
+    !(ADPCMValid[key>>5]&(1u<<(key&31))))
+  {
+   const int shift_factor=start[0]&0xf;
+   unsigned char * p=start+2;
+   int d,s;
+
+   for(i=0;i<28;p++)
+    {
+     d=(int)*p;
+     s=((d&0xf)<<12);
+     if(s&0x8000) s|=0xffff0000;
+     pB->sVal[i++]=s>>shift_factor;
+     s=((d&0xf0)<<8);
+     if(s&0x8000) s|=0xffff0000;
+     pB->sVal[i++]=s>>shift_factor;
+    }
+
+   if((unsigned int)key<ADPCMKEYS)
+    {
+     pB->iAddr=key;
+     ADPCMValid[key>>5]|=1u<<(key&31);
+    }
+   else pB->iAddr=-1;                                  // (a voice ran off the end of spu ram)
+  }
+
+ if(predict_nr==0)                                     // no filter: the cached samples as they are
+  {
+   for(i=0;i<28;i++) pSB[i]=pB->sVal[i];
+   *ps_2=pB->sVal[26];*ps_1=pB->sVal[27];
+   return;
+  }
+
+ {
+  const int f0=f[predict_nr][0],f1=f[predict_nr][1];
+  for(i=0;i<28;i++)
+   {
+    fa=pB->sVal[i] + ((s_1 * f0)>>6) + ((s_2 * f1)>>6);
+    s_2=s_1;s_1=fa;
+    pSB[i]=fa;
+   }
+ }
+
+ *ps_1=s_1;*ps_2=s_2;
+}
+
+////////////////////////////////////////////////////////////////////////
+// VOICE MIXING
+// the channel loop puts the samples of one voice into iVoiceVal (0 for
+// muted ones and fmod freq channels), and MixVoice adds them to the sums
+// with the voice volumes, a range at a time: all of the slice, or the part
+// before an irq (the emu may change the volumes from there on).
+// With sse2 4 samples go at once. The sums of a slice then get clamped
+// and stored by StoreStereo, 4 stereo samples at once, with saturating
+// packs.
+// So the simd runs across the samples of one voice, not across the
+// voices of one sample: the voice state stays in SPUCHAN (save states
+// copy it as it is), and decode, ADSR and interpolation go on voice by
+// voice, since each depends on the sample before. The voices' slices
+// meet only in the sums.
+////////////////////////////////////////////////////////////////////////
+
+static int iVoiceVal[NSSIZE];                          // the slice of the voice in work
+
+#ifdef __SSE2__
+// (v*vol)/0x4000 in 4 lanes: vol is 0...0x3fff, and the low 32 bits of
+// the product are the same signed or unsigned. Rounds towards 0, like /.
+static __inline __m128i MulVol(__m128i v,__m128i vol)
+{
+ __m128i e=_mm_mul_epu32(v,vol);                       // lanes 0,2 (64 bit)
+ __m128i o=_mm_mul_epu32(_mm_srli_epi64(v,32),vol);    // lanes 1,3
+ __m128i p=_mm_unpacklo_epi32(_mm_shuffle_epi32(e,_MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(o,_MM_SHUFFLE(0,0,2,0)));
+ p=_mm_add_epi32(p,_mm_and_si128(_mm_srai_epi32(p,31),_mm_set1_epi32(0x3fff)));
+ return _mm_srai_epi32(p,14);
+}
+#endif
+
+static INLINE void MixVoice(int ch,int n0,int n1)
+{
+ const int vl=s_chan[ch].iLeftVolume;
+ const int vr=s_chan[ch].iRightVolume;
+ int ns=n0;
+
+ if(!vl && !vr) return;                                // nothing to hear
+
+#ifdef __SSE2__
+ {
+  const __m128i mvl=_mm_set1_epi32(vl),mvr=_mm_set1_epi32(vr);
+  for(;ns+4<=n1;ns+=4)
+   {
+    __m128i v=_mm_loadu_si128((__m128i *)(iVoiceVal+ns));
+    _mm_storeu_si128((__m128i *)(SSumL+ns),
+     _mm_add_epi32(_mm_loadu_si128((__m128i *)(SSumL+ns)),MulVol(v,mvl)));
+    _mm_storeu_si128((__m128i *)(SSumR+ns),
+     _mm_add_epi32(_mm_loadu_si128((__m128i *)(SSumR+ns)),MulVol(v,mvr)));
+   }
+ }
+#endif
+
+ for(;ns<n1;ns++)
+  {
+   SSumL[ns]+=(iVoiceVal[ns]*vl)/0x4000L;
+   SSumR[ns]+=(iVoiceVal[ns]*vr)/0x4000L;
+  }
+}
+
+// stereo out: (sum/voldiv) clamped to +-32767, sums are cleared
+
+static INLINE short * StoreStereo(short * p,int voldiv)
+{
+ int ns=0,d;
+
+#ifdef __SSE2__
+ {
+  // sum/voldiv in float: voldiv is 1...4, and the sums get limited to
+  // +-0x20000 first (everything beyond is clamped anyway), so the float
+  // is exact enough to truncate to the same int
+  const __m128  rcp=_mm_set1_ps(1.0f/voldiv);
+  const __m128  lo=_mm_set1_ps(-131072.0f),hi=_mm_set1_ps(131072.0f);
+  const __m128i min16=_mm_set1_epi16(-32767),zero=_mm_setzero_si128();
+  __m128 fl,fr;__m128i t;
+
+  for(;ns+4<=iSliceLen;ns+=4,p+=8)
+   {
+    fl=_mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)(SSumL+ns)));
+    fr=_mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)(SSumR+ns)));
+    fl=_mm_mul_ps(_mm_min_ps(_mm_max_ps(fl,lo),hi),rcp);
+    fr=_mm_mul_ps(_mm_min_ps(_mm_max_ps(fr,lo),hi),rcp);
+    t=_mm_packs_epi32(_mm_cvttps_epi32(fl),_mm_cvttps_epi32(fr)); // l0..l3 r0..r3, saturated
+    t=_mm_max_epi16(t,min16);                          // -32768 -> -32767
+    _mm_storeu_si128((__m128i *)p,_mm_unpacklo_epi16(t,_mm_srli_si128(t,8)));
+    _mm_storeu_si128((__m128i *)(SSumL+ns),zero);
+    _mm_storeu_si128((__m128i *)(SSumR+ns),zero);
+   }
+ }
+#endif
+
+ for(;ns<iSliceLen;ns++)
+  {
+   d = SSumL[ns] / voldiv; SSumL[ns] = 0;
+   if (d < -32767) d = -32767; if (d > 32767) d = 32767;
+   *p++ = d;
+
+   d = SSumR[ns] / voldiv; SSumR[ns] = 0;
+   if(d < -32767) d = -32767; if(d > 32767) d = 32767;
+   *p++ = d;
+  }
+
+ return p;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // MAIN SPU FUNCTION
 // here is the main job handler... thread, timer or direct func call
@@ -436,15 +672,16 @@ INLINE int iGetInterpolationVal(int ch)
 
 static void *MAINThread(void *arg)
 {
- int s_1,s_2,fa,ns;
+ int s_1,s_2,fa,ns,nsmix=0;
 #ifndef _MACOSX
  int voldiv=iVolume;
 #else
  const int voldiv=1;
 #endif
- unsigned char * start;unsigned int nSample;
- int ch,predict_nr,shift_factor,flags,d,s;
+ unsigned char * start;
+ int ch,flags,vol;
  int bIRQReturn=0;
+ unsigned long dwLeft;
 
  while(!bEndThread)                                    // until we are shutting down
   {
@@ -455,6 +692,20 @@ static void *MAINThread(void *arg)
    // until enuff free place is available/a new channel gets
    // started
 
+   if(iCycleMixing)                                    // cycle mixing: no buffer checks, only the emu time counts
+    {
+     if(lastch<0)                                      // (a pending irq continue finishes its slice anyway)
+      {
+       iSliceLen=NSSIZE;
+       if(lSpuSamples<NSSIZE)                          // less than a slice owed? keep it for the next call,
+        {                                              // unless a write has to happen right after them
+         if(!bMixRest || lSpuSamples<=0) return 0;
+         iSliceLen=lSpuSamples;
+        }
+       lSpuSamples-=iSliceLen;
+      }
+    }
+   else
    if(dwNewChannel)                                    // new channel should start immedately?
     {                                                  // (at least one bit 0 ... MAXCHANNEL is set?)
      iSecureStart++;                                   // -> set iSecure
@@ -462,8 +713,9 @@ static void *MAINThread(void *arg)
     }
    else iSecureStart=0;                                // 0: no new channel should start
 
+   if(!iCycleMixing)
    while(!iSecureStart && !bEndThread &&               // no new start? no thread end?
-         (SoundGetBytesBuffered()>TESTSIZE))           // and still enuff data in sound buffer?
+         RingFull())                                   // and still enuff data in the ring?
     {
      iSecureStart=0;                                   // reset secure
 
@@ -478,6 +730,7 @@ static void *MAINThread(void *arg)
    if(lastch>=0)                                       // will be -1 if no continue is pending
     {
      ch=lastch; ns=lastns; lastch=-1;                  // -> setup all kind of vars to continue
+     nsmix=ns;                                         // (what came before is mixed already)
      goto GOON;                                        // -> directly jump to the continue point
     }
 
@@ -487,14 +740,18 @@ static void *MAINThread(void *arg)
     {
      for(ch=0;ch<MAXCHAN;ch++)                         // loop em all... we will collect 1 ms of sound of each playing channel
       {
+       dwLeft=(dwChannelOn|dwNewChannel)>>ch;          // playing or starting ones from here on (re-read each time:
+       if(!dwLeft) break;                              // an irq may start some)
+       while(!(dwLeft&1)) {dwLeft>>=1;ch++;}           // -> next one of them
+
        if(s_chan[ch].bNew) StartSound(ch);             // start new sound
        if(!s_chan[ch].bOn) continue;                   // channel not playing? next
 
        if(s_chan[ch].iActFreq!=s_chan[ch].iUsedFreq)   // new psx frequency?
         VoiceChangeFrequency(ch);
 
-       ns=0;
-       while(ns<NSSIZE)                                // loop until 1 ms of data is reached
+       ns=0;nsmix=0;
+       while(ns<iSliceLen)                             // loop until 1 ms of data is reached
         {
          if(s_chan[ch].bFMod==1 && iFMod[ns])          // fmod freq channel
           FModChangeFrequency(ch,ns);
@@ -508,6 +765,7 @@ static void *MAINThread(void *arg)
              if (start == (unsigned char*)-1)          // special "stop" sign
               {
                s_chan[ch].bOn=0;                       // -> turn everything off
+               dwChannelOn&=~(1<<ch);
                s_chan[ch].ADSRX.lVolume=0;
                s_chan[ch].ADSRX.EnvelopeVol=0;
                goto ENDX;                              // -> and done for this channel
@@ -520,33 +778,12 @@ static void *MAINThread(void *arg)
              s_1=s_chan[ch].s_1;
              s_2=s_chan[ch].s_2;
 
-             predict_nr=(int)*start;start++;
-             shift_factor=predict_nr&0xf;
-             predict_nr >>= 4;
-             flags=(int)*start;start++;
+             flags=(int)start[1];
 
              // -------------------------------------- // 
 
-             for (nSample=0;nSample<28;start++)      
-              {
-               d=(int)*start;
-               s=((d&0xf)<<12);
-               if(s&0x8000) s|=0xffff0000;
-
-               fa=(s >> shift_factor);
-               fa=fa + ((s_1 * f[predict_nr][0])>>6) + ((s_2 * f[predict_nr][1])>>6);
-               s_2=s_1;s_1=fa;
-               s=((d & 0xf0) << 8);
-
-               s_chan[ch].SB[nSample++]=fa;
-
-               if(s&0x8000) s|=0xffff0000;
-               fa=(s>>shift_factor);
-               fa=fa + ((s_1 * f[predict_nr][0])>>6) + ((s_2 * f[predict_nr][1])>>6);
-               s_2=s_1;s_1=fa;
-
-               s_chan[ch].SB[nSample++]=fa;
-              }
+             DecodeADPCM(s_chan[ch].SB,start,&s_1,&s_2);
+             start+=16;
 
              //////////////////////////////////////////// irq check
 
@@ -559,6 +796,8 @@ static void *MAINThread(void *arg)
                     pSpuIrq <= s_chan[ch].pLoop)))
                {
                  s_chan[ch].iIrqDone=1;                // -> debug flag
+                 MixVoice(ch,nsmix,ns);                // -> the samples so far with the volumes so far
+                 nsmix=ns;
                  irqCallback();                        // -> call main emu
 
                  if(iSPUIRQWait)                       // -> option: wait after irq for main emu
@@ -595,7 +834,7 @@ static void *MAINThread(void *arg)
              if(bIRQReturn)                            // special return for "spu irq - wait for cpu action"
               {
                bIRQReturn=0;
-               if(iUseTimer!=2)
+               if(iUseTimer!=2 && !iCycleMixing)
                 { 
                  DWORD dwWatchTime=timeGetTime_spu()+2500;
 
@@ -622,26 +861,45 @@ GOON: ;
            s_chan[ch].spos -= 0x10000L;
           }
 
+         // both volumes 0 (and no fmod freq channel): nothing of the voice
+         // gets to the sums or the reverb, so only what has a state goes
+         // on - the position above, noise, envelope, simple interpolation.
+         // Same with the envelope at 0 for the sample value.
+
          if(s_chan[ch].bNoise)
               fa=iGetNoiseVal(ch);                     // get noise val
-         else fa=iGetInterpolationVal(ch);             // get sample val
+         else fa=0;                                    // (the sample val comes below)
+         vol=MixADSR(ch);
+
+         if(s_chan[ch].bFMod!=2 &&
+            !s_chan[ch].iLeftVolume && !s_chan[ch].iRightVolume)
+          {
+           if(!s_chan[ch].bNoise && iUseInterpolation==1)
+            iGetInterpolationVal(ch);                  // -> its helpers move on
+           iVoiceVal[ns]=0;                            // -> the volumes may come back before MixVoice
+           goto NEXTNS;
+          }
+
+         if(!s_chan[ch].bNoise && (vol || iUseInterpolation==1))
+          fa=iGetInterpolationVal(ch);                 // get sample val
 
-         s_chan[ch].sval = (MixADSR(ch) * fa) / 1023;  // mix adsr
+         s_chan[ch].sval = (vol * fa) / 1023;          // mix adsr
 
          if(s_chan[ch].bFMod==2)                       // fmod freq channel
-          iFMod[ns]=s_chan[ch].sval;                   // -> store 1T sample data, use that to do fmod on next channel
+          {
+           iFMod[ns]=s_chan[ch].sval;                  // -> store 1T sample data, use that to do fmod on next channel
+           iVoiceVal[ns]=0;                            // -> and don't mix it
+          }
          else                                          // no fmod freq channel
           {
            //////////////////////////////////////////////
            // ok, left/right sound volume (psx volume goes from 0 ... 0x3fff)
+           // gets done by MixVoice at the end of the channel
 
            if(s_chan[ch].iMute) 
             s_chan[ch].sval=0;                         // debug mute
-           else
-            {
-             SSumL[ns]+=(s_chan[ch].sval*s_chan[ch].iLeftVolume)/0x4000L;
-             SSumR[ns]+=(s_chan[ch].sval*s_chan[ch].iRightVolume)/0x4000L;
-            }
+
+           iVoiceVal[ns]=s_chan[ch].sval;
 
            //////////////////////////////////////////////
            // now let us store sound data for reverb    
@@ -652,11 +910,11 @@ GOON: ;
          ////////////////////////////////////////////////
          // ok, go on until 1 ms data of this channel is collected
 
-         ns++;
+NEXTNS:  ns++;
          s_chan[ch].spos += s_chan[ch].sinc;
 
         }
-ENDX:   ;
+ENDX:   MixVoice(ch,nsmix,ns);                         // the channel's slice (or what it played of it) into the sums
       }
     }
 
@@ -670,38 +928,22 @@ ENDX:   ;
   ///////////////////////////////////////////////////////
   // mix all channels (including reverb) into one buffer
 
+  MixREVERB();
+
   if(iDisStereo)                                       // no stereo?
    {
     int dl,dr;
-    for(ns=0;ns<NSSIZE;ns++)
+    for(ns=0;ns<iSliceLen;ns++)
      {
-      SSumL[ns]+=MixREVERBLeft(ns);
-
       dl=SSumL[ns]/voldiv;SSumL[ns]=0;
       if(dl<-32767) dl=-32767;if(dl>32767) dl=32767;
 
-      SSumR[ns]+=MixREVERBRight();
-
       dr=SSumR[ns]/voldiv;SSumR[ns]=0;
       if(dr<-32767) dr=-32767;if(dr>32767) dr=32767;
       *pS++=(dl+dr)/2;
      }
    }
-  else                                                 // stereo:
-  for (ns = 0; ns < NSSIZE; ns++)
-   {
-    SSumL[ns] += MixREVERBLeft(ns);
-
-    d = SSumL[ns] / voldiv; SSumL[ns] = 0;
-    if (d < -32767) d = -32767; if (d > 32767) d = 32767;
-    *pS++ = d;
-
-    SSumR[ns] += MixREVERBRight();
-
-    d = SSumR[ns] / voldiv; SSumR[ns] = 0;
-    if(d < -32767) d = -32767; if(d > 32767) d = 32767;
-    *pS++ = d;
-   }
+  else pS = StoreStereo(pS, voldiv);                   // stereo
 
   //////////////////////////////////////////////////////                   
   // special irq handling in the decode buffers (0x0000-0x1000)
@@ -723,7 +965,7 @@ ENDX:   ;
 
   if(pMixIrq && irqCallback)
    {
-    for(ns=0;ns<NSSIZE;ns++)
+    for(ns=0;ns<iSliceLen;ns++)
      {
       if((spuCtrl&0x40) && pSpuIrq && pSpuIrq<spuMemC+0x1000)                 
        {
@@ -739,15 +981,10 @@ ENDX:   ;
 
   InitREVERB();
 
-  // feed the sound
-  // wanna have around 1/60 sec (16.666 ms) updates
-  if (iCycle++ > 16)
-   {
-    SoundFeedStreamData((unsigned char *)pSpuBuffer,
-                        ((unsigned char *)pS) - ((unsigned char *)pSpuBuffer));
-    pS = (short *)pSpuBuffer;
-    iCycle = 0;
-   }
+  // feed the sound: every slice into the ring, the ring thread
+  // feeds the driver
+  RingWrite((short *)pSpuBuffer, pS - (short *)pSpuBuffer);
+  pS = (short *)pSpuBuffer;
  }
 
  // end of big main loop...
@@ -762,6 +999,20 @@ ENDX:   ;
 
 void CALLBACK SPUasync(unsigned long cycle)
 {
+ if(iCycleMixing)                                      // cycle mixing: mix exactly the samples of 'cycle' psx cycles
+  {
+   if(!bSpuInit) return;
+
+   if(cycle>ulSyncCycles) ulSpuCycles+=cycle-ulSyncCycles; // (batched writes may have counted some already)
+   ulSyncCycles=0;
+   lSpuSamples+=ulSpuCycles/SPUCYCLES;
+   ulSpuCycles%=SPUCYCLES;
+   iSpuAsyncWait=0;                                    // irq wait: the continue simply happens on the next call
+
+   MAINThread(0);
+   return;
+  }
+
  if(iSpuAsyncWait)
   {
    iSpuAsyncWait++;
@@ -777,6 +1028,25 @@ void CALLBACK SPUasync(unsigned long cycle)
   }
 }
 
+// cycle mixing: mix up to 'cycle' psx cycles after the last SPUasync
+// call, the rest of a slice included, so a batched register write
+// happens right on its sample (SPUwriteRegisters). SPUasync then only
+// adds what comes after.
+
+void MixToCycle(unsigned long cycle)
+{
+ if(!bSpuInit || cycle<=ulSyncCycles) return;
+
+ ulSpuCycles+=cycle-ulSyncCycles;
+ ulSyncCycles=cycle;
+ lSpuSamples+=ulSpuCycles/SPUCYCLES;
+ ulSpuCycles%=SPUCYCLES;
+
+ bMixRest=1;
+ MAINThread(0);
+ bMixRest=0;
+}
+
 // SPU UPDATE... new epsxe func
 //  1 time every 32 hsync lines
 //  (312/32)x50 in pal
@@ -786,9 +1056,12 @@ void CALLBACK SPUasync(unsigned long cycle)
 // leave that func in the linux port, until epsxe linux is using
 // the async function as well
 
+// (cycle mixing needs the cycles, so here it takes the 32 lines as
+// 32*2150, about right for pal and ntsc)
+
 void CALLBACK SPUupdate(void)
 {
- SPUasync(0);
+ SPUasync(iCycleMixing ? 32*2150 : 0);
 }
 
 // XA AUDIO
@@ -817,6 +1090,7 @@ long CALLBACK SPUinit(void)
 {
  spuMemC=(unsigned char *)spuMem;                      // just small setup
  memset((void *)s_chan,0,MAXCHAN*sizeof(SPUCHAN));
+ dwChannelOn=0;
  memset((void *)&rvb,0,sizeof(REVERBInfo));
  InitADSR();
  return 0;
@@ -828,6 +1102,13 @@ void SetupTimer(void)
  memset(SSumR,0,NSSIZE*sizeof(int));                   // init some mixing buffers
  memset(SSumL,0,NSSIZE*sizeof(int));
  memset(iFMod,0,NSSIZE*sizeof(int));
+
+ StartTimer();
+}
+
+// STARTTIMER: start mixing on the buffers as they are (a freeze keeps them)
+void StartTimer(void)
+{
  pS=(short *)pSpuBuffer;                               // setup soundbuffer pointer
 
  bEndThread=0;                                         // init thread vars
@@ -883,6 +1164,9 @@ void SetupStreams(void)
  CDDAPlay  = CDDAStart;
  CDDAFeed  = CDDAStart + 1;
 
+ DropADPCMAll();                                       // nothing decoded yet
+ memset(ADPCMCache,0xff,sizeof(ADPCMCache));           // (-1 addresses)
+
  for(i=0;i<MAXCHAN;i++)                                // loop sound channels
   {
 // we don't use mutex sync... not needed, would only 
@@ -926,15 +1210,22 @@ long SPUopen(void)
  spuMemC = (unsigned char *)spuMem;
  pMixIrq = 0;
  memset((void *)s_chan, 0, (MAXCHAN + 1) * sizeof(SPUCHAN));
+ dwChannelOn = 0;
  pSpuIrq = 0;
  iSPUIRQWait = 1;
 
  ReadConfig();                                         // read user stuff
 
- SetupSound();                                         // setup sound (before init!)
+ if(!szOutputFile[0]) SetupSound();                    // setup sound (before init!), unless it goes into a file
 
  SetupStreams();                                       // prepare streaming
 
+ ulSpuCycles = 0;                                      // cycle mixing: nothing owed yet
+ lSpuSamples = 0;
+ ulSyncCycles = 0;
+ iSliceLen = NSSIZE;
+ RingStart();                                          // the driver gets fed from the ring
+
  SetupTimer();                                         // timer for feeding data
 
  bSPUIsOpen = 1;
@@ -951,7 +1242,9 @@ long CALLBACK SPUclose(void)
 
  RemoveTimer();                                        // no more feeding
 
- RemoveSound();                                        // no more sound handling
+ RingStop();                                           // no more ring feeding either
+
+ if(!szOutputFile[0]) RemoveSound();                   // no more sound handling
 
  RemoveStreams();                                      // no more streaming
 
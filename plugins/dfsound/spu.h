@@ -16,6 +16,10 @@
  ***************************************************************************/
 
 void SetupTimer(void);
+void StartTimer(void);
 void RemoveTimer(void);
+void DropADPCMRange(unsigned long addr,long lBytes);
+void DropADPCMAll(void);
+void MixToCycle(unsigned long cycle);
 void CALLBACK SPUplayADPCMchannel(xa_decode_t *xap);
 void CALLBACK SPUplayCDDAchannel(short *pcm, int bytes);
\ No newline at end of file
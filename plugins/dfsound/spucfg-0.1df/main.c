@@ -20,6 +20,12 @@
 
 void SaveConfig(GtkWidget *widget, gpointer user_datal);
 
+/* options without a widget, written back as they were read */
+static int iCycleMixing = 0;
+static int iOutputLatency = 60;
+static int iRateControl = 1;
+static char szOutputFile[256] = "";
+
 /*	This function checks for the value being outside the accepted range,
 	and returns the appropriate boundary value */
 int set_limit (char *p, int len, int lower, int upper)
@@ -205,6 +211,42 @@ int main(int argc, char *argv[])
 
     gtk_combo_box_set_active(GTK_COMBO_BOX(glade_xml_get_widget(xml, "cbReverb2")), val);
 
+    if (pB) {
+		strcpy(t, "\nCycleMixing");
+		p = strstr(pB, t);
+		if (p) {
+		    p = strstr(p, "=");
+		    len = 1;
+		}
+		iCycleMixing = set_limit (p, len, 0, 1);
+
+		strcpy(t, "\nOutputLatency");
+		p = strstr(pB, t);
+		if (p) {
+		    p = strstr(p, "=");
+		    len = 1;
+		    iOutputLatency = set_limit (p, len, 20, 500);
+		}
+
+		strcpy(t, "\nRateControl");
+		p = strstr(pB, t);
+		if (p) {
+		    p = strstr(p, "=");
+		    len = 1;
+		    iRateControl = set_limit (p, len, 0, 1);
+		}
+
+		strcpy(t, "\nOutputFile");
+		p = strstr(pB, t);
+		if (p) {
+		    p = strstr(p, "=");
+		}
+		if (p) {
+		    for (p++; *p == ' ' || *p == '\t'; p++) ;
+		    sscanf(p, "%255[^\r\n]", szOutputFile);
+		}
+    }
+
     if (pB)
 		free(pB);
 
@@ -253,6 +295,12 @@ void SaveConfig(GtkWidget *widget, gpointer user_data)
 	val = gtk_combo_box_get_active(GTK_COMBO_BOX(glade_xml_get_widget(xml, "cbReverb2")));
 	fprintf(fp, "\nUseReverb = %d\n", val);
 
+	fprintf(fp, "\nCycleMixing = %d\n", iCycleMixing);
+	fprintf(fp, "\nOutputLatency = %d\n", iOutputLatency);
+	fprintf(fp, "\nRateControl = %d\n", iRateControl);
+	if (szOutputFile[0])
+		fprintf(fp, "\nOutputFile = %s\n", szOutputFile);
+
 	fclose(fp);
 	gtk_exit(0);
 }
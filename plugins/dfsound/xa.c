@@ -44,14 +44,21 @@ uint32_t * CDDAEnd   = NULL;
 int             iLeftXAVol  = 32767;
 int             iRightXAVol = 32767;
 
-static int gauss_ptr = 0;
-static int gauss_window[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+int gauss_ptr = 0;
+int gauss_window[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
 #define gvall0 gauss_window[gauss_ptr]
 #define gvall(x) gauss_window[(gauss_ptr+x)&3]
 #define gvalr0 gauss_window[4+gauss_ptr]
 #define gvalr(x) gauss_window[4+((gauss_ptr+x)&3)]
 
+#include "xafir_i.h"
+
+short sXAFirL[XAFIRHIST+16384];                        // per channel: the last samples of the sector before,
+short sXAFirR[XAFIRHIST+16384];                        // then the new one
+int   iXAFirPos=0;                                     // next output, 1/7 input samples past sXAFir*[XAFIRHIST]
+int   iXAFirStereo=-1;
+
 ////////////////////////////////////////////////////////////////////////
 // MIX XA & CDDA
 ////////////////////////////////////////////////////////////////////////
@@ -61,7 +68,7 @@ INLINE void MixXA(void)
  int ns;
  uint32_t l;
 
- for(ns=0;ns<NSSIZE && XAPlay!=XAFeed;ns++)
+ for(ns=0;ns<iSliceLen && XAPlay!=XAFeed;ns++)
   {
    XALastVal=*XAPlay++;
    if(XAPlay==XAEnd) XAPlay=XAStart;
@@ -77,7 +84,7 @@ INLINE void MixXA(void)
  if(XAPlay==XAFeed && XARepeat)
   {
    XARepeat--;
-   for(;ns<NSSIZE;ns++)
+   for(;ns<iSliceLen;ns++)
     {
 #ifdef XA_HACK
      SSumL[ns]+=(((short)(XALastVal&0xffff))       * iLeftXAVol)/32768;
@@ -89,7 +96,7 @@ INLINE void MixXA(void)
     }
   }
 
- for(ns=0;ns<NSSIZE && CDDAPlay!=CDDAFeed && (CDDAPlay!=CDDAEnd-1||CDDAFeed!=CDDAStart);ns++)
+ for(ns=0;ns<iSliceLen && CDDAPlay!=CDDAFeed && (CDDAPlay!=CDDAEnd-1||CDDAFeed!=CDDAStart);ns++)
   {
    l=*CDDAPlay++;
    if(CDDAPlay==CDDAEnd) CDDAPlay=CDDAStart;
@@ -109,6 +116,93 @@ unsigned long timeGetTime_spu()
  return tv.tv_sec * 1000 + tv.tv_usec/1000;            // to do that, but at least it works
 }
 
+////////////////////////////////////////////////////////////////////////
+// XA POLYPHASE RESAMPLING
+////////////////////////////////////////////////////////////////////////
+
+// 37.8 and 18.9 kHz to 44.1 kHz are exactly 7/6 and 7/3: each output
+// sits 6/7 (3/7) input samples after the one before, so the 7 filters
+// of xafir_i.h cover every position there is. A whole sector gets
+// split into channels behind the tail of the last one, then each output
+// is one 16 tap filter per channel.
+
+static __inline uint32_t XAFir(const short * pL,const short * pR,const short * pC)
+{
+#ifdef __SSE2__
+ __m128i c0=_mm_loadu_si128((__m128i *)pC);
+ __m128i c1=_mm_loadu_si128((__m128i *)(pC+8));
+ __m128i l=_mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((__m128i *)pL),c0),
+                         _mm_madd_epi16(_mm_loadu_si128((__m128i *)(pL+8)),c1));
+ __m128i r=_mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((__m128i *)pR),c0),
+                         _mm_madd_epi16(_mm_loadu_si128((__m128i *)(pR+8)),c1));
+ __m128i t=_mm_add_epi32(_mm_unpacklo_epi32(l,r),      // l0+l2 r0+r2 l1+l3 r1+r3
+                         _mm_unpackhi_epi32(l,r));
+ t=_mm_add_epi32(t,_mm_unpackhi_epi64(t,t));           // l r
+ t=_mm_srai_epi32(_mm_add_epi32(t,_mm_set1_epi32(8192)),14);
+ return (uint32_t)_mm_cvtsi128_si32(_mm_packs_epi32(t,t));
+#else
+ int k,l=8192,r=8192;
+
+ for(k=0;k<XAFIRTAPS;k++)
+  {
+   l+=pL[k]*pC[k];
+   r+=pR[k]*pC[k];
+  }
+ l>>=14;r>>=14;
+ if(l<-32768) l=-32768;
+ if(l> 32767) l=32767;
+ if(r<-32768) r=-32768;
+ if(r> 32767) r=32767;
+ return (l&0xffff)|((uint32_t)r<<16);
+#endif
+}
+
+static INLINE void FeedXAFir(xa_decode_t *xap)
+{
+ int n=xap->nsamples,i,iPhase,iStep=xap->freq*7/44100;   // n: frames
+ short * pR=xap->stereo?sXAFirR:sXAFirL;                // mono: both sides from the same
+
+ if(xap->stereo!=iXAFirStereo)                         // other stream: no tail to go on from
+  {
+   memset(sXAFirL,0,XAFIRHIST*sizeof(short));
+   memset(sXAFirR,0,XAFIRHIST*sizeof(short));
+   iXAFirPos=0;
+   iXAFirStereo=xap->stereo;
+  }
+
+ if(xap->stereo)
+  {
+   for(i=0;i<n;i++)
+    {
+     sXAFirL[XAFIRHIST+i]=xap->pcm[i*2];
+     sXAFirR[XAFIRHIST+i]=xap->pcm[i*2+1];
+    }
+  }
+ else memcpy(sXAFirL+XAFIRHIST,xap->pcm,n*sizeof(short));
+
+ // output at i+iPhase/7 needs the taps i...i+15, the newest of them
+ // is the sector's i'th sample
+ for(i=iXAFirPos/7,iPhase=iXAFirPos%7;i<n;)
+  {
+   *XAFeed++=XAFir(sXAFirL+i,pR+i,xafir[iPhase]);
+
+   if(XAFeed==XAEnd) XAFeed=XAStart;
+   if(XAFeed==XAPlay)                                  // full: the rest of the sector is lost
+    {
+     if(XAPlay!=XAStart) XAFeed=XAPlay-1;
+     i=n;iPhase=0;
+     break;
+    }
+
+   iPhase+=iStep;
+   while(iPhase>=7) {iPhase-=7;i++;}
+  }
+ iXAFirPos=(i-n)*7+iPhase;
+
+ memmove(sXAFirL,sXAFirL+n,XAFIRHIST*sizeof(short));   // the tail for the next sector
+ memmove(sXAFirR,sXAFirR+n,XAFIRHIST*sizeof(short));
+}
+
 ////////////////////////////////////////////////////////////////////////
 // FEED XA 
 ////////////////////////////////////////////////////////////////////////
@@ -134,6 +228,15 @@ INLINE void FeedXA(xa_decode_t *xap)
 
  if(iPlace==0) return;                                 // no place at all
 
+#ifndef XA_HACK
+ if(!iXAPitch && iUseInterpolation &&                  // the usual rates, no pitch change: the filters
+    (xap->freq==37800 || xap->freq==18900))
+  {
+   FeedXAFir(xap);
+   return;
+  }
+#endif
+
  //----------------------------------------------------//
  if(iXAPitch)                                          // pitch change option?
   {
@@ -390,20 +493,40 @@ INLINE void FeedXA(xa_decode_t *xap)
 // FEED CDDA
 ////////////////////////////////////////////////////////////////////////
 
+// cdda already is 44.1 kHz: copied in runs, as much as fits up to the
+// buffer end (one place stays free, else full would look like empty)
 INLINE void FeedCDDA(unsigned char *pcm, int nBytes)
 {
+ uint32_t * pPlay;
+ int n;
+
  while(nBytes>0)
   {
    if(CDDAFeed==CDDAEnd) CDDAFeed=CDDAStart;
-   while(CDDAFeed==CDDAPlay-1||
-         (CDDAFeed==CDDAEnd-1&&CDDAPlay==CDDAStart))
+   pPlay=CDDAPlay;                                     // (the mixer moves it meanwhile)
+   if(pPlay>CDDAFeed) n=pPlay-CDDAFeed-1;
+   else               n=(CDDAEnd-CDDAFeed)+(pPlay-CDDAStart)-1;
+   if(n>CDDAEnd-CDDAFeed) n=CDDAEnd-CDDAFeed;
+   if(n>(nBytes+3)/4)     n=(nBytes+3)/4;
+
+   if(!n)                                              // full
+    {
+     if (!iUseTimer) {usleep(1000);continue;}
+     else return;
+    }
+
+#ifdef WORDS_BIGENDIAN
    {
-    if (!iUseTimer) usleep(1000);
-    else return;
+    int i;
+    for(i=0;i<n;i++)
+     CDDAFeed[i]=(pcm[i*4] | (pcm[i*4+1]<<8) | (pcm[i*4+2]<<16) | (pcm[i*4+3]<<24));
    }
-   *CDDAFeed++=(*pcm | (*(pcm+1)<<8) | (*(pcm+2)<<16) | (*(pcm+3)<<24));
-   nBytes-=4;
-   pcm+=4;
+#else
+   memcpy(CDDAFeed,pcm,n*4);
+#endif
+   CDDAFeed+=n;
+   nBytes-=n*4;
+   pcm+=n*4;
   }
 }
 
@@ -0,0 +1,39 @@
+/***************************************************************************
+                          xafir_i.h  -  description
+                           -----------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XAFIR_H
+#define XAFIR_H
+
+// 7 phase filter bank for xa (37.8/18.9 kHz -> 44.1 kHz, 7/6 and 7/3):
+// kaiser windowed sinc (beta 6.5), 112 taps at 7x the input rate,
+// cutoff 0.48 of the input rate. Flat up to 0.4 (-0.5 dB), images of
+// that at -50 dB and less. Row p is for an output p/7 input samples
+// past the newest of the 16 (plus the 7.5 samples delay of all rows),
+// oldest tap first, 1.0 = 16384, each row sums to 16384.
+
+#define XAFIRPHASES 7
+#define XAFIRTAPS   16
+
+static const short xafir[XAFIRPHASES][XAFIRTAPS]={
+	{    20,   -55,   105,  -156,   172,   -73,  -413, 15597,  1803, -1017,   653,  -400,   220,  -101,    35,    -6},
+	{     6,   -10,    -4,    72,  -259,   715, -1991, 14623,  4496, -1959,  1093,  -611,   314,  -139,    47,    -9},
+	{    -4,    25,   -90,   245,  -572,  1242, -2865, 12782,  7422, -2707,  1394,  -737,   363,  -156,    53,   -11},
+	{    -9,    46,  -141,   344,  -732,  1464, -3066, 10285, 10287, -3066,  1464,  -732,   344,  -141,    46,    -9},
+	{   -11,    53,  -156,   363,  -737,  1394, -2707,  7422, 12782, -2865,  1242,  -572,   245,   -90,    25,    -4},
+	{    -9,    47,  -139,   314,  -611,  1093, -1959,  4496, 14623, -1991,   715,  -259,    72,    -4,   -10,     6},
+	{    -6,    35,  -101,   220,  -400,   653, -1017,  1803, 15597,  -413,   -73,   172,  -156,   105,   -55,    20},
+};
+
+#endif
@@ -0,0 +1,491 @@
+/***************************************************************************
+                          blit.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// line converters for the display blits in draw.c: vram (15 or 24 bit)
+// to xrgb or yuy2, and xrgb (filter output) to yuy2. The scalar funcs
+// are the old loops of draw.c; the ssse3 and avx2 ones are built with
+// function target attributes, so no special compiler flags are needed,
+// and picked at runtime by cpuid. All of them give the same bits.
+//
+// The yuv math is the one of the scalar code, done with pmaddwd on
+// (r,g) and (b,0) word pairs. Its abs() never does anything (all sums
+// are positive for 0..255 input), the min() is kept.
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_BLIT
+
+#include "externals.h"
+#include "gpu.h"
+#include "swap.h"
+#include "blit.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && !defined(__BIG_ENDIAN__)
+#define BLIT_X86
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+int iBlitKernels = BLIT_AVX2;                          // highest level wanted
+
+////////////////////////////////////////////////////////////////////////
+// scalar
+////////////////////////////////////////////////////////////////////////
+
+static void To32_C(uint32_t * pdest, unsigned short * psrc, int n)
+{
+ unsigned short s;
+ int i;
+
+ for (i = 0; i < n; i++)
+  {
+   s = GETLE16(&psrc[i]);
+   pdest[i] =
+      (((s << 19) & 0xf80000) | ((s << 6) & 0xf800) | ((s >> 7) & 0xf8)) | 0xff000000;
+  }
+}
+
+static void To32_24_C(uint32_t * pdest, unsigned char * psrc, int n)
+{
+ uint32_t lu;
+ int i;
+
+ for (i = 0; i < n; i++)
+  {
+   lu = *((uint32_t *)psrc);
+   pdest[i] =
+      0xff000000 | (RED(lu) << 16) | (GREEN(lu) << 8) | (BLUE(lu));
+   psrc += 3;
+  }
+}
+
+#ifdef __BIG_ENDIAN__
+#define YUVPAIR(Y,U,V) ((Y) << 24 | (U) << 16 | (Y) << 8 | (V))
+#else
+#define YUVPAIR(Y,U,V) ((Y) << 24 | (V) << 16 | (Y) << 8 | (U))
+#endif
+
+static void ToYUV_C(uint32_t * pdest, unsigned short * psrc, int n)
+{
+ unsigned short s;
+ int Y,U,V, R,G,B;
+ int i;
+
+ for (i = 0; i < n; i++)
+  {
+   s = GETLE16(&psrc[i]);
+
+   R = (s << 3) &0xf8;
+   G = (s >> 2) &0xf8;
+   B = (s >> 7) &0xf8;
+
+   Y = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
+   U = min(abs(R * -1214 + G * -2384 + B * 3598 + 4096 + 1048576) >> 13, 240);
+   V = min(abs(R * 3598 + G * -3013 + B * -585 + 4096 + 1048576) >> 13, 240);
+
+   pdest[i] = YUVPAIR(Y,U,V);
+  }
+}
+
+static void ToYUV_24_C(uint32_t * pdest, unsigned char * psrc, int n)
+{
+ uint32_t lu;
+ int Y,U,V, R,G,B;
+ int i;
+
+ for (i = 0; i < n; i++)
+  {
+   lu = *((uint32_t *)psrc);
+
+   R = RED(lu);
+   G = GREEN(lu);
+   B = BLUE(lu);
+
+   Y = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
+   U = min(abs(R * -1214 + G * -2384 + B * 3598 + 4096 + 1048576) >> 13, 240);
+   V = min(abs(R * 3598 + G * -3013 + B * -585 + 4096 + 1048576) >> 13, 240);
+
+   pdest[i] = YUVPAIR(Y,U,V);
+   psrc += 3;
+  }
+}
+
+static void RGBToYUV_C(uint32_t * d, uint32_t * s, int n)
+{
+ int R,G,B, Y1,Y2,U,V;
+ int x;
+
+ for (x = 0; x < n >> 1; x++)
+  {
+   R = (*s >> 16) & 0xff;
+   G = (*s >> 8) & 0xff;
+   B = *s & 0xff;
+   s++;
+
+   Y1 = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
+   U = min(abs(R * -1214 + G * -2384 + B * 3598 + 4096 + 1048576) >> 13, 240);
+   V = min(abs(R * 3598 + G * -3013 + B * -585 + 4096 + 1048576) >> 13, 240);
+
+   R = (*s >> 16) & 0xff;
+   G = (*s >> 8) & 0xff;
+   B = *s & 0xff;
+   s++;
+
+   Y2 = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
+
+#ifdef __BIG_ENDIAN__
+   *d = V | Y2 << 8 | U << 16 | Y1 << 24;
+#else
+   *d = U | Y1 << 8 | V << 16 | Y2 << 24;
+#endif
+   d++;
+  }
+}
+
+#ifdef BLIT_X86
+
+// word pair (lo,hi) in every dword, for pmaddwd
+#define WPAIR(lo,hi) ((int)((((uint32_t)(hi) & 0xffff) << 16) | ((uint32_t)(lo) & 0xffff)))
+
+#define SHUF4(a,b,c,d) a,b,c,d
+#define Z (-128)
+
+////////////////////////////////////////////////////////////////////////
+// ssse3: 4 pixels per xmm dword vector
+////////////////////////////////////////////////////////////////////////
+
+#define SSSE3FUNC   static __attribute__((target("ssse3")))
+#define SSSE3INLINE static __inline __attribute__((always_inline,target("ssse3")))
+
+SSSE3INLINE __m128i To32Vec(__m128i x)                 // x: 15 bit pixels in dwords
+{
+ __m128i r = _mm_and_si128(_mm_slli_epi32(x, 19), _mm_set1_epi32(0xf80000));
+ __m128i g = _mm_and_si128(_mm_slli_epi32(x, 6),  _mm_set1_epi32(0xf800));
+ __m128i b = _mm_and_si128(_mm_srli_epi32(x, 7),  _mm_set1_epi32(0xf8));
+
+ return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi32((int)0xff000000)));
+}
+
+SSSE3INLINE void YUVVec(__m128i rg, __m128i b, __m128i * y, __m128i * u, __m128i * v)
+{
+ *y = _mm_add_epi32(_mm_madd_epi16(rg, _mm_set1_epi32(WPAIR(2104, 4130))),
+                    _mm_madd_epi16(b,  _mm_set1_epi32(WPAIR(802, 0))));
+ *u = _mm_add_epi32(_mm_madd_epi16(rg, _mm_set1_epi32(WPAIR(-1214, -2384))),
+                    _mm_madd_epi16(b,  _mm_set1_epi32(WPAIR(3598, 0))));
+ *v = _mm_add_epi32(_mm_madd_epi16(rg, _mm_set1_epi32(WPAIR(3598, -3013))),
+                    _mm_madd_epi16(b,  _mm_set1_epi32(WPAIR(-585, 0))));
+
+ *y = _mm_srli_epi32(_mm_add_epi32(*y, _mm_set1_epi32(4096 + 131072)), 13);
+ *u = _mm_srli_epi32(_mm_add_epi32(*u, _mm_set1_epi32(4096 + 1048576)), 13);
+ *v = _mm_srli_epi32(_mm_add_epi32(*v, _mm_set1_epi32(4096 + 1048576)), 13);
+
+ *y = _mm_min_epi16(*y, _mm_set1_epi32(235));          // high words are 0 on both sides
+ *u = _mm_min_epi16(*u, _mm_set1_epi32(240));
+ *v = _mm_min_epi16(*v, _mm_set1_epi32(240));
+}
+
+SSSE3INLINE __m128i YUVPairVec(__m128i y, __m128i u, __m128i v)
+{
+ return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(y, 24), _mm_slli_epi32(v, 16)),
+                     _mm_or_si128(_mm_slli_epi32(y, 8), u));
+}
+
+SSSE3INLINE __m128i YUV15Vec(__m128i x)                // x: 15 bit pixels in dwords
+{
+ __m128i rg = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(x, 3),  _mm_set1_epi32(0xf8)),
+                           _mm_and_si128(_mm_slli_epi32(x, 14), _mm_set1_epi32(0xf80000)));
+ __m128i b  = _mm_and_si128(_mm_srli_epi32(x, 7), _mm_set1_epi32(0xf8));
+ __m128i y, u, v;
+
+ YUVVec(rg, b, &y, &u, &v);
+ return YUVPairVec(y, u, v);
+}
+
+SSSE3FUNC void To32_SSSE3(uint32_t * pdest, unsigned short * psrc, int n)
+{
+ __m128i z = _mm_setzero_si128();
+ __m128i s;
+ int i;
+
+ for (i = 0; i + 8 <= n; i += 8)
+  {
+   s = _mm_loadu_si128((__m128i *)(psrc + i));
+   _mm_storeu_si128((__m128i *)(pdest + i),     To32Vec(_mm_unpacklo_epi16(s, z)));
+   _mm_storeu_si128((__m128i *)(pdest + i + 4), To32Vec(_mm_unpackhi_epi16(s, z)));
+  }
+ To32_C(pdest + i, psrc + i, n - i);
+}
+
+SSSE3FUNC void To32_24_SSSE3(uint32_t * pdest, unsigned char * psrc, int n)
+{
+ __m128i shuf = _mm_setr_epi8(SHUF4(2,1,0,Z), SHUF4(5,4,3,Z), SHUF4(8,7,6,Z), SHUF4(11,10,9,Z));
+ __m128i a = _mm_set1_epi32((int)0xff000000);
+ __m128i s;
+ int i;
+
+ for (i = 0; i + 5 <= n; i += 4)                       // the 16 byte load stays within 3*n+1
+  {
+   s = _mm_loadu_si128((__m128i *)(psrc + i * 3));
+   _mm_storeu_si128((__m128i *)(pdest + i), _mm_or_si128(_mm_shuffle_epi8(s, shuf), a));
+  }
+ To32_24_C(pdest + i, psrc + i * 3, n - i);
+}
+
+SSSE3FUNC void ToYUV_SSSE3(uint32_t * pdest, unsigned short * psrc, int n)
+{
+ __m128i z = _mm_setzero_si128();
+ __m128i s;
+ int i;
+
+ for (i = 0; i + 8 <= n; i += 8)
+  {
+   s = _mm_loadu_si128((__m128i *)(psrc + i));
+   _mm_storeu_si128((__m128i *)(pdest + i),     YUV15Vec(_mm_unpacklo_epi16(s, z)));
+   _mm_storeu_si128((__m128i *)(pdest + i + 4), YUV15Vec(_mm_unpackhi_epi16(s, z)));
+  }
+ ToYUV_C(pdest + i, psrc + i, n - i);
+}
+
+SSSE3FUNC void ToYUV_24_SSSE3(uint32_t * pdest, unsigned char * psrc, int n)
+{
+ __m128i shrg = _mm_setr_epi8(SHUF4(0,Z,1,Z), SHUF4(3,Z,4,Z), SHUF4(6,Z,7,Z), SHUF4(9,Z,10,Z));
+ __m128i shb  = _mm_setr_epi8(SHUF4(2,Z,Z,Z), SHUF4(5,Z,Z,Z), SHUF4(8,Z,Z,Z), SHUF4(11,Z,Z,Z));
+ __m128i s, y, u, v;
+ int i;
+
+ for (i = 0; i + 5 <= n; i += 4)
+  {
+   s = _mm_loadu_si128((__m128i *)(psrc + i * 3));
+   YUVVec(_mm_shuffle_epi8(s, shrg), _mm_shuffle_epi8(s, shb), &y, &u, &v);
+   _mm_storeu_si128((__m128i *)(pdest + i), YUVPairVec(y, u, v));
+  }
+ ToYUV_24_C(pdest + i, psrc + i * 3, n - i);
+}
+
+SSSE3FUNC void RGBToYUV_SSSE3(uint32_t * pdest, uint32_t * psrc, int n)
+{
+ __m128i shrg = _mm_setr_epi8(SHUF4(2,Z,1,Z), SHUF4(6,Z,5,Z), SHUF4(10,Z,9,Z), SHUF4(14,Z,13,Z));
+ __m128i shb  = _mm_setr_epi8(SHUF4(0,Z,Z,Z), SHUF4(4,Z,Z,Z), SHUF4(8,Z,Z,Z), SHUF4(12,Z,Z,Z));
+ __m128i lo = _mm_set1_epi32(0xffff);
+ __m128i s0, s1, y0, u0, v0, y1, u1, v1;
+ int i;
+
+ for (i = 0; i + 8 <= n; i += 8)
+  {
+   s0 = _mm_loadu_si128((__m128i *)(psrc + i));
+   s1 = _mm_loadu_si128((__m128i *)(psrc + i + 4));
+   YUVVec(_mm_shuffle_epi8(s0, shrg), _mm_shuffle_epi8(s0, shb), &y0, &u0, &v0);
+   YUVVec(_mm_shuffle_epi8(s1, shrg), _mm_shuffle_epi8(s1, shb), &y1, &u1, &v1);
+
+   y0 = _mm_packs_epi32(y0, y1);                       // words, so a pixel pair is one dword
+   u0 = _mm_packs_epi32(u0, u1);
+   v0 = _mm_packs_epi32(v0, v1);
+
+   _mm_storeu_si128((__m128i *)(pdest + (i >> 1)),     // u from the first, y1 y2, v from the first
+      _mm_or_si128(_mm_or_si128(_mm_and_si128(u0, lo), _mm_slli_epi32(y0, 8)),
+                   _mm_slli_epi32(_mm_and_si128(v0, lo), 16)));
+  }
+ RGBToYUV_C(pdest + (i >> 1), psrc + i, n - i);
+}
+
+////////////////////////////////////////////////////////////////////////
+// avx2: the same with 8 pixels per ymm
+////////////////////////////////////////////////////////////////////////
+
+#define AVX2FUNC   static __attribute__((target("avx2")))
+#define AVX2INLINE static __inline __attribute__((always_inline,target("avx2")))
+
+AVX2INLINE __m256i To32Vec256(__m256i x)
+{
+ __m256i r = _mm256_and_si256(_mm256_slli_epi32(x, 19), _mm256_set1_epi32(0xf80000));
+ __m256i g = _mm256_and_si256(_mm256_slli_epi32(x, 6),  _mm256_set1_epi32(0xf800));
+ __m256i b = _mm256_and_si256(_mm256_srli_epi32(x, 7),  _mm256_set1_epi32(0xf8));
+
+ return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_set1_epi32((int)0xff000000)));
+}
+
+AVX2INLINE void YUVVec256(__m256i rg, __m256i b, __m256i * y, __m256i * u, __m256i * v)
+{
+ *y = _mm256_add_epi32(_mm256_madd_epi16(rg, _mm256_set1_epi32(WPAIR(2104, 4130))),
+                       _mm256_madd_epi16(b,  _mm256_set1_epi32(WPAIR(802, 0))));
+ *u = _mm256_add_epi32(_mm256_madd_epi16(rg, _mm256_set1_epi32(WPAIR(-1214, -2384))),
+                       _mm256_madd_epi16(b,  _mm256_set1_epi32(WPAIR(3598, 0))));
+ *v = _mm256_add_epi32(_mm256_madd_epi16(rg, _mm256_set1_epi32(WPAIR(3598, -3013))),
+                       _mm256_madd_epi16(b,  _mm256_set1_epi32(WPAIR(-585, 0))));
+
+ *y = _mm256_srli_epi32(_mm256_add_epi32(*y, _mm256_set1_epi32(4096 + 131072)), 13);
+ *u = _mm256_srli_epi32(_mm256_add_epi32(*u, _mm256_set1_epi32(4096 + 1048576)), 13);
+ *v = _mm256_srli_epi32(_mm256_add_epi32(*v, _mm256_set1_epi32(4096 + 1048576)), 13);
+
+ *y = _mm256_min_epi16(*y, _mm256_set1_epi32(235));
+ *u = _mm256_min_epi16(*u, _mm256_set1_epi32(240));
+ *v = _mm256_min_epi16(*v, _mm256_set1_epi32(240));
+}
+
+AVX2INLINE __m256i YUVPairVec256(__m256i y, __m256i u, __m256i v)
+{
+ return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(y, 24), _mm256_slli_epi32(v, 16)),
+                        _mm256_or_si256(_mm256_slli_epi32(y, 8), u));
+}
+
+AVX2INLINE __m256i Load24(unsigned char * p)           // 8 pixels, 12 per 128 bit lane
+{
+ return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i *)p)),
+                                _mm_loadu_si128((__m128i *)(p + 12)), 1);
+}
+
+AVX2FUNC void To32_AVX2(uint32_t * pdest, unsigned short * psrc, int n)
+{
+ int i;
+
+ for (i = 0; i + 16 <= n; i += 16)
+  {
+   _mm256_storeu_si256((__m256i *)(pdest + i),
+      To32Vec256(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)(psrc + i)))));
+   _mm256_storeu_si256((__m256i *)(pdest + i + 8),
+      To32Vec256(_mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)(psrc + i + 8)))));
+  }
+ _mm256_zeroupper();                                   // the rest is legacy sse
+ To32_SSSE3(pdest + i, psrc + i, n - i);
+}
+
+AVX2FUNC void To32_24_AVX2(uint32_t * pdest, unsigned char * psrc, int n)
+{
+ __m256i shuf = _mm256_setr_epi8(SHUF4(2,1,0,Z), SHUF4(5,4,3,Z), SHUF4(8,7,6,Z), SHUF4(11,10,9,Z),
+                                 SHUF4(2,1,0,Z), SHUF4(5,4,3,Z), SHUF4(8,7,6,Z), SHUF4(11,10,9,Z));
+ __m256i a = _mm256_set1_epi32((int)0xff000000);
+ int i;
+
+ for (i = 0; i + 9 <= n; i += 8)                       // second load ends at byte 3*i+28
+  _mm256_storeu_si256((__m256i *)(pdest + i),
+     _mm256_or_si256(_mm256_shuffle_epi8(Load24(psrc + i * 3), shuf), a));
+ _mm256_zeroupper();                                   // the rest is legacy sse
+ To32_24_SSSE3(pdest + i, psrc + i * 3, n - i);
+}
+
+AVX2FUNC void ToYUV_AVX2(uint32_t * pdest, unsigned short * psrc, int n)
+{
+ __m256i x, rg, b, y, u, v;
+ int i;
+
+ for (i = 0; i + 8 <= n; i += 8)
+  {
+   x  = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i *)(psrc + i)));
+   rg = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(x, 3),  _mm256_set1_epi32(0xf8)),
+                        _mm256_and_si256(_mm256_slli_epi32(x, 14), _mm256_set1_epi32(0xf80000)));
+   b  = _mm256_and_si256(_mm256_srli_epi32(x, 7), _mm256_set1_epi32(0xf8));
+   YUVVec256(rg, b, &y, &u, &v);
+   _mm256_storeu_si256((__m256i *)(pdest + i), YUVPairVec256(y, u, v));
+  }
+ ToYUV_C(pdest + i, psrc + i, n - i);
+}
+
+AVX2FUNC void ToYUV_24_AVX2(uint32_t * pdest, unsigned char * psrc, int n)
+{
+ __m256i shrg = _mm256_setr_epi8(SHUF4(0,Z,1,Z), SHUF4(3,Z,4,Z), SHUF4(6,Z,7,Z), SHUF4(9,Z,10,Z),
+                                 SHUF4(0,Z,1,Z), SHUF4(3,Z,4,Z), SHUF4(6,Z,7,Z), SHUF4(9,Z,10,Z));
+ __m256i shb  = _mm256_setr_epi8(SHUF4(2,Z,Z,Z), SHUF4(5,Z,Z,Z), SHUF4(8,Z,Z,Z), SHUF4(11,Z,Z,Z),
+                                 SHUF4(2,Z,Z,Z), SHUF4(5,Z,Z,Z), SHUF4(8,Z,Z,Z), SHUF4(11,Z,Z,Z));
+ __m256i s, y, u, v;
+ int i;
+
+ for (i = 0; i + 9 <= n; i += 8)
+  {
+   s = Load24(psrc + i * 3);
+   YUVVec256(_mm256_shuffle_epi8(s, shrg), _mm256_shuffle_epi8(s, shb), &y, &u, &v);
+   _mm256_storeu_si256((__m256i *)(pdest + i), YUVPairVec256(y, u, v));
+  }
+ _mm256_zeroupper();                                   // the rest is legacy sse
+ ToYUV_24_SSSE3(pdest + i, psrc + i * 3, n - i);
+}
+
+AVX2FUNC void RGBToYUV_AVX2(uint32_t * pdest, uint32_t * psrc, int n)
+{
+ __m256i shrg = _mm256_setr_epi8(SHUF4(2,Z,1,Z), SHUF4(6,Z,5,Z), SHUF4(10,Z,9,Z), SHUF4(14,Z,13,Z),
+                                 SHUF4(2,Z,1,Z), SHUF4(6,Z,5,Z), SHUF4(10,Z,9,Z), SHUF4(14,Z,13,Z));
+ __m256i shb  = _mm256_setr_epi8(SHUF4(0,Z,Z,Z), SHUF4(4,Z,Z,Z), SHUF4(8,Z,Z,Z), SHUF4(12,Z,Z,Z),
+                                 SHUF4(0,Z,Z,Z), SHUF4(4,Z,Z,Z), SHUF4(8,Z,Z,Z), SHUF4(12,Z,Z,Z));
+ __m256i lo = _mm256_set1_epi32(0xffff);
+ __m256i s0, s1, y0, u0, v0, y1, u1, v1, d;
+ int i;
+
+ for (i = 0; i + 16 <= n; i += 16)
+  {
+   s0 = _mm256_loadu_si256((__m256i *)(psrc + i));
+   s1 = _mm256_loadu_si256((__m256i *)(psrc + i + 8));
+   YUVVec256(_mm256_shuffle_epi8(s0, shrg), _mm256_shuffle_epi8(s0, shb), &y0, &u0, &v0);
+   YUVVec256(_mm256_shuffle_epi8(s1, shrg), _mm256_shuffle_epi8(s1, shb), &y1, &u1, &v1);
+
+   y0 = _mm256_packs_epi32(y0, y1);                    // packs per lane: pairs 0,1,4,5 | 2,3,6,7
+   u0 = _mm256_packs_epi32(u0, u1);
+   v0 = _mm256_packs_epi32(v0, v1);
+
+   d = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(u0, lo), _mm256_slli_epi32(y0, 8)),
+                       _mm256_slli_epi32(_mm256_and_si256(v0, lo), 16));
+   _mm256_storeu_si256((__m256i *)(pdest + (i >> 1)), _mm256_permute4x64_epi64(d, 0xd8));
+  }
+ _mm256_zeroupper();                                   // the rest is legacy sse
+ RGBToYUV_SSSE3(pdest + (i >> 1), psrc + i, n - i);
+}
+
+#endif // BLIT_X86
+
+////////////////////////////////////////////////////////////////////////
+
+BLITFUNCS BlitFuncs[BLIT_LEVELS] =
+{
+ {"scalar", To32_C, To32_24_C, ToYUV_C, ToYUV_24_C, RGBToYUV_C},
+#ifdef BLIT_X86
+ {"ssse3",  To32_SSSE3, To32_24_SSSE3, ToYUV_SSSE3, ToYUV_24_SSSE3, RGBToYUV_SSSE3},
+ {"avx2",   To32_AVX2,  To32_24_AVX2,  ToYUV_AVX2,  ToYUV_24_AVX2,  RGBToYUV_AVX2},
+#endif
+};
+
+BLITFUNCS * pBlit = &BlitFuncs[BLIT_SCALAR];
+
+int BlitCpuLevel(void)
+{
+#ifdef BLIT_X86
+ static int iLevel = -1;
+ unsigned int a, b, c, d, xlo, xhi;
+
+ if (iLevel >= 0) return iLevel;
+
+ iLevel = BLIT_SCALAR;
+ if (!__get_cpuid(1, &a, &b, &c, &d)) return iLevel;
+ if (!(c & bit_SSSE3)) return iLevel;
+ iLevel = BLIT_SSSE3;
+
+ if (!(c & bit_OSXSAVE) || !(c & bit_AVX)) return iLevel;
+ __asm__ __volatile__("xgetbv" : "=a" (xlo), "=d" (xhi) : "c" (0));
+ if ((xlo & 6) != 6) return iLevel;                    // os doesn't save the ymm regs
+
+ if (__get_cpuid_max(0, NULL) < 7) return iLevel;
+ __cpuid_count(7, 0, a, b, c, d);
+ if (b & bit_AVX2) iLevel = BLIT_AVX2;
+
+ return iLevel;
+#else
+ return BLIT_SCALAR;
+#endif
+}
+
+void BlitSelect(void)
+{
+ int iLevel = min(iBlitKernels, BlitCpuLevel());
+
+ while (iLevel > BLIT_SCALAR && !BlitFuncs[iLevel].name) iLevel--;
+ pBlit = &BlitFuncs[iLevel];
+}
@@ -0,0 +1,43 @@
+/***************************************************************************
+                          blit.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _BLIT_INTERNALS_H
+#define _BLIT_INTERNALS_H
+
+// line converters of the display blits. n is the pixel count of the
+// source line; the 24 bit ones read 3*n+1 bytes, like the old loops.
+
+typedef struct
+{
+ const char * name;
+ void (*To32)(uint32_t * pdest, unsigned short * psrc, int n);     // 15 bit vram -> xrgb
+ void (*To32_24)(uint32_t * pdest, unsigned char * psrc, int n);   // 24 bit vram -> xrgb
+ void (*ToYUV)(uint32_t * pdest, unsigned short * psrc, int n);    // 15 bit vram -> one yuy2 pair per pixel
+ void (*ToYUV_24)(uint32_t * pdest, unsigned char * psrc, int n);  // 24 bit vram -> one yuy2 pair per pixel
+ void (*RGBToYUV)(uint32_t * pdest, uint32_t * psrc, int n);       // xrgb -> yuy2, n even
+} BLITFUNCS;
+
+#define BLIT_SCALAR 0
+#define BLIT_SSSE3  1
+#define BLIT_AVX2   2
+#define BLIT_LEVELS 3
+
+extern BLITFUNCS   BlitFuncs[BLIT_LEVELS];             // name is NULL if not built in
+extern BLITFUNCS * pBlit;                              // the ones in use
+
+int  BlitCpuLevel(void);
+void BlitSelect(void);
+
+#endif // _BLIT_INTERNALS_H
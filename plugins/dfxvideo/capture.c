@@ -0,0 +1,186 @@
+/***************************************************************************
+                          capture.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// gpu capture: logs everything the emu sends to the gpu, starting with
+// the vram and drawing state at a vsync, so tools/gpureplay can run the
+// rasterizer on it without emu. Toggled with F11, written to
+// ~/pcsxNNNN.gcap. Everything here runs on the emu thread.
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_CAPTURE
+
+#include "externals.h"
+#include "gpu.h"
+#include "swap.h"
+#include "thread.h"
+#include "capture.h"
+
+BOOL bCapturing = FALSE;
+
+static BOOL  bCapturePending = FALSE;
+static FILE *fCapture = NULL;
+
+////////////////////////////////////////////////////////////////////////
+
+static void WriteWords(uint32_t * pMem, int iSize)     // already little endian
+{
+ if(fwrite(pMem, 4, iSize, fCapture) != (size_t)iSize)
+  {
+   printf("dfxvideo: gpu capture write error, stopped\n");
+   CaptureStop();
+  }
+}
+
+static void WriteTag(int iType, int iCount)
+{
+ uint32_t tag;
+
+ PUTLE32(&tag, CAP_TAG(iType, iCount));
+ WriteWords(&tag, 1);
+}
+
+static BOOL OpenCapture(void)
+{
+ char filename[256];
+ uint32_t ul[5];
+ FILE *f;
+ int i = 0;
+
+ do                                                    // next free number, like the snapshots
+  {
+   i++;
+   sprintf(filename, "%s/pcsx%04d.gcap", getenv("HOME"), i);
+   f = fopen(filename, "rb");
+   if(f) fclose(f);
+  }
+ while(f);
+
+ fCapture = fopen(filename, "wb");
+ if(!fCapture) return FALSE;
+
+ setvbuf(fCapture, NULL, _IOFBF, 1024*1024);
+
+ memcpy(ul, CAP_MAGIC, 8);
+ PUTLE32(&ul[2], CAP_VERSION);
+ PUTLE32(&ul[3], iGPUHeight);
+ PUTLE32(&ul[4], dwGPUVersion);
+ fwrite(ul, 4, 5, fCapture);
+
+ printf("dfxvideo: gpu capture to %s\n", filename);
+ return TRUE;
+}
+
+////////////////////////////////////////////////////////////////////////
+// on/off, the capture itself starts at the next vsync
+////////////////////////////////////////////////////////////////////////
+
+void CaptureToggle(void)
+{
+ if(bCapturing || bCapturePending) CaptureStop();
+ else                              bCapturePending = TRUE;
+}
+
+void CaptureStop(void)
+{
+ bCapturePending = FALSE;
+ if(!fCapture) return;
+
+ bCapturing = FALSE;
+ fclose(fCapture);
+ fCapture = NULL;
+ printf("dfxvideo: gpu capture stopped\n");
+}
+
+////////////////////////////////////////////////////////////////////////
+// full state, at the start and whenever vram changed behind our back
+// (freeze load). The drawing state is written as the GP0 words that
+// set it, so the replay needs no access to the rasterizer vars.
+////////////////////////////////////////////////////////////////////////
+
+void CaptureState(void)
+{
+ uint32_t ul[CAP_STATEWORDS];
+ uint32_t tpage;
+ int i;
+
+ if(!fCapture) return;
+
+ if(iUseGPUThread) GPUThreadStop();                    // draw state back on this thread
+
+ if(dwGPUVersion==2) tpage = lGPUstatusRet & 0x1fff;
+ else                tpage = (lGPUstatusRet & 0x7ff) | usMirror;
+
+ ul[0] = lGPUstatusRet;
+ for(i=0;i<256;i++) ul[1+i] = ulStatusControl[i];
+ ul[257] = 0xe1000000 | tpage;
+ ul[258] = 0xe2000000 | lGPUInfoVals[INFO_TW];
+ ul[259] = 0xe3000000 | lGPUInfoVals[INFO_DRAWSTART];
+ ul[260] = 0xe4000000 | lGPUInfoVals[INFO_DRAWEND];
+ ul[261] = 0xe5000000 | lGPUInfoVals[INFO_DRAWOFF];
+ ul[262] = 0xe6000000 | ((lGPUstatusRet >> 11) & 3);
+
+ for(i=0;i<CAP_STATEWORDS;i++) PUTLE32(&ul[i], ul[i]);
+
+ WriteTag(CAP_STATE, 0);
+ if(fCapture) WriteWords(ul, CAP_STATEWORDS);
+ if(fCapture) WriteWords((uint32_t *)psxVub, 512*iGPUHeight);
+
+ if(iUseGPUThread) GPUThreadStart();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void CaptureData(int iType, uint32_t * pMem, int iSize)
+{
+ int n;
+
+ while(iSize > 0 && fCapture)
+  {
+   n = iSize > CAP_MAXCOUNT ? CAP_MAXCOUNT : iSize;
+   WriteTag(iType, n);
+   if(fCapture) WriteWords(pMem, n);
+   pMem += n; iSize -= n;
+  }
+}
+
+void CaptureStatus(uint32_t gdata)
+{
+ WriteTag(CAP_STATUS, 0);
+ PUTLE32(&gdata, gdata);
+ if(fCapture) WriteWords(&gdata, 1);
+}
+
+void CaptureRead(int iSize)
+{
+ WriteTag(CAP_READ, iSize);
+}
+
+void CaptureVSync(void)
+{
+ if(bCapturing) WriteTag(CAP_VSYNC, 0);
+
+ if(bCapturePending)
+  {
+   bCapturePending = FALSE;
+   if(!OpenCapture())
+    {
+     printf("dfxvideo: can't create gpu capture file\n");
+     return;
+    }
+   CaptureState();
+   bCapturing = (fCapture != NULL);
+  }
+}
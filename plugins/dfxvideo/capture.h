@@ -0,0 +1,60 @@
+/***************************************************************************
+                          capture.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _CAPTURE_INTERNALS_H
+#define _CAPTURE_INTERNALS_H
+
+// gpu capture file, replayed by tools/gpureplay. All values little endian.
+//
+//   header   "GPUCAPT\0", u32 version, u32 vram height (512 or 1024),
+//            u32 gpu version (2 for some zn boards)
+//   records  u32 tag (type<<24 | count), followed by:
+//
+//   CAP_STATE   status, 256 control words (as in a freeze), the draw
+//               state as GP0 words e1..e6, then the vram image
+//   CAP_DATA    count words written to the data port
+//   CAP_DMA     count words of a dma chain, the packets of several nodes
+//   CAP_STATUS  one word written to the status port
+//   CAP_READ    nothing, count words were read from the data port
+//   CAP_VSYNC   nothing, end of a frame
+
+#define CAP_MAGIC      "GPUCAPT"
+#define CAP_VERSION    1
+#define CAP_MAXCOUNT   0xffffff
+#define CAP_STATEWORDS (1+256+6)                       // before the vram
+
+#define CAP_TAG(type,count) (((uint32_t)(type)<<24)|(count))
+#define CAP_TYPE(tag)       ((tag)>>24)
+#define CAP_COUNT(tag)      ((tag)&CAP_MAXCOUNT)
+
+enum
+{
+ CAP_STATE,
+ CAP_DATA,
+ CAP_DMA,
+ CAP_STATUS,
+ CAP_READ,
+ CAP_VSYNC
+};
+
+void CaptureToggle(void);
+void CaptureStop(void);
+void CaptureState(void);
+void CaptureData(int iType, uint32_t * pMem, int iSize);
+void CaptureStatus(uint32_t gdata);
+void CaptureRead(int iSize);
+void CaptureVSync(void);
+
+#endif // _CAPTURE_INTERNALS_H
@@ -163,6 +163,34 @@ void ReadConfigFile()
  if(iUseFixes<0) iUseFixes=0;
  if(iUseFixes>1) iUseFixes=1;
 
+ GetValue("GPUThread", iUseGPUThread);
+ if(iUseGPUThread<0) iUseGPUThread=0;
+ if(iUseGPUThread>1) iUseGPUThread=1;
+
+ GetValue("TileThreads", iTileThreads);
+ if(iTileThreads<0)  iTileThreads=0;
+ if(iTileThreads>16) iTileThreads=16;
+
+ GetValue("SpanKernels", iUseSpanKernels);
+ if(iUseSpanKernels<0) iUseSpanKernels=0;
+ if(iUseSpanKernels>1) iUseSpanKernels=1;
+
+ GetValue("DirtyRects", iUseDirtyRects);
+ if(iUseDirtyRects<0) iUseDirtyRects=0;
+ if(iUseDirtyRects>1) iUseDirtyRects=1;
+
+ GetValue("BlitKernels", iBlitKernels);                // 0 scalar, 1 ssse3, 2 avx2 (if the cpu has it)
+ if(iBlitKernels<0) iBlitKernels=0;
+ if(iBlitKernels>2) iBlitKernels=2;
+
+ GetValue("FilterThreads", iFilterThreads);            // 0/1 filter on the display thread only
+ if(iFilterThreads<0)  iFilterThreads=0;
+ if(iFilterThreads>16) iFilterThreads=16;
+
+ GetValue("FramePacing", iFramePacing);
+ if(iFramePacing<0) iFramePacing=0;
+ if(iFramePacing>1) iFramePacing=1;
+
  free(pB);
 }
 
@@ -230,6 +258,13 @@ void ReadConfig(void)
  iUseNoStretchBlt=1;
  iUseDither=0;
  iShowFPS=0;
+ iUseGPUThread=0;
+ iTileThreads=0;
+ iUseSpanKernels=1;
+ iUseDirtyRects=1;
+ iBlitKernels=2;
+ iFilterThreads=0;
+ iFramePacing=1;
 
  // read sets
  ReadConfigFile();
@@ -281,6 +316,13 @@ void WriteConfig(void) {
   iUseNoStretchBlt=1;
   iUseDither=0;
   iShowFPS=0;
+  iUseGPUThread=0;
+  iTileThreads=0;
+  iUseSpanKernels=1;
+  iUseDirtyRects=1;
+  iBlitKernels=2;
+  iFilterThreads=0;
+  iFramePacing=1;
 
   size = 0;
   pB=(char *)malloc(4096);
@@ -307,6 +349,13 @@ void WriteConfig(void) {
  SetFloatValue("FrameRate", fFrameRate);
  SetValue("CfgFixes", (unsigned int)dwCfgFixes);
  SetValue("UseFixes", iUseFixes);
+ SetValue("GPUThread", iUseGPUThread);
+ SetValue("TileThreads", iTileThreads);
+ SetValue("SpanKernels", iUseSpanKernels);
+ SetValue("DirtyRects", iUseDirtyRects);
+ SetValue("BlitKernels", iBlitKernels);
+ SetValue("FilterThreads", iFilterThreads);
+ SetValue("FramePacing", iFramePacing);
 
  out = fopen(t,"wb");
  if (!out) return;
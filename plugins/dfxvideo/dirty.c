@@ -0,0 +1,188 @@
+/***************************************************************************
+                          dirty.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// dirty vram tiles, so DoBufferSwap can skip what didn't change since
+// the last swap. Set on the thread that parses GP0 (draw prims by their
+// bbox in the draw area, vram loads, moves and fills by their rect),
+// read and cleared by the swap after GPUThreadSync. Erring on the big
+// side is fine, missing a write is not.
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_DIRTY
+
+#include "externals.h"
+#include "swap.h"
+#include "dirty.h"
+
+#define SIGNSHIFT 21
+
+int iUseDirtyRects = 1;
+
+static uint32_t ulDirty[DIRTYROWS];
+
+////////////////////////////////////////////////////////////////////////
+
+uint32_t DirtyCols(int32_t x0, int32_t x1)             // tile cols of x0..x1, wraps at 1024
+{
+ uint32_t m0,m1;
+
+ if(x1-x0>=1023) return 0xffffffff;
+
+ x0=(x0&1023)>>DIRTYSHIFTX;
+ x1=(x1&1023)>>DIRTYSHIFTX;
+ m0=0xffffffff<<x0;
+ m1=0xffffffff>>(31-x1);
+
+ if(x0<=x1) return m0&m1;
+ return m0|m1;
+}
+
+uint32_t DirtyRow(int32_t y)
+{
+ return ulDirty[(y&iGPUHeightMask)>>DIRTYSHIFTY];
+}
+
+void DirtyRect(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+ int32_t rows=iGPUHeight>>DIRTYSHIFTY;
+ int32_t r,n;
+ uint32_t mask;
+
+ if(x1<x0 || y1<y0) return;
+
+ mask=DirtyCols(x0,x1);
+ n=(y1>>DIRTYSHIFTY)-(y0>>DIRTYSHIFTY)+1;
+ if(n>rows) n=rows;
+
+ for(r=y0>>DIRTYSHIFTY;n>0;r++,n--)
+  ulDirty[r&(rows-1)]|=mask;
+}
+
+BOOL DirtyArea(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+ int32_t rows=iGPUHeight>>DIRTYSHIFTY;
+ int32_t r,n;
+ uint32_t mask;
+
+ mask=DirtyCols(x0,x1);
+ n=(y1>>DIRTYSHIFTY)-(y0>>DIRTYSHIFTY)+1;
+ if(n>rows) n=rows;
+
+ for(r=y0>>DIRTYSHIFTY;n>0;r++,n--)
+  if(ulDirty[r&(rows-1)]&mask) return TRUE;
+ return FALSE;
+}
+
+void DirtyAll(void)
+{
+ memset(ulDirty,0xff,sizeof(ulDirty));
+}
+
+void DirtyClean(void)
+{
+ memset(ulDirty,0,sizeof(ulDirty));
+}
+
+////////////////////////////////////////////////////////////////////////
+// drawing prims: bbox of the vertices (as the prim funcs offset them),
+// clipped to the draw area, which the rasterizer never leaves
+////////////////////////////////////////////////////////////////////////
+
+static void Vertex(uint32_t gdata, int32_t * x, int32_t * y)
+{
+ *x=(short)(gdata&0xffff);
+ *y=(short)(gdata>>16);
+ if(!(dwActFixes&8))
+  {
+   *x=(short)((*x<<SIGNSHIFT)>>SIGNSHIFT);
+   *y=(short)((*y<<SIGNSHIFT)>>SIGNSHIFT);
+  }
+ *x+=PSXDisplay.DrawOffset.x;
+ *y+=PSXDisplay.DrawOffset.y;
+}
+
+void DirtyPrim(unsigned char command, uint32_t * pMem)
+{
+ static const unsigned char polyVtx[8][4] =            // vertex words of the poly types
+  {{1,2,3,0},{1,3,5,0},{1,2,3,4},{1,3,5,7},
+   {1,3,5,0},{1,4,7,0},{1,3,5,7},{1,4,7,10}};
+ int32_t x0,y0,x1,y1,x,y,w,h;
+ int i,n;
+
+ if(drawX>drawW || drawY>drawH) return;                // nothing gets drawn
+
+ if(command>=0x20 && command<0x40)                     // polys
+  {
+   const unsigned char * v=polyVtx[(command>>2)&7];
+
+   Vertex(GETLE32(&pMem[v[0]]),&x0,&y0);
+   x1=x0;y1=y0;
+   n=(command&8)?4:3;
+   for(i=1;i<n;i++)
+    {
+     Vertex(GETLE32(&pMem[v[i]]),&x,&y);
+     if(x<x0) x0=x;
+     if(x>x1) x1=x;
+     if(y<y0) y0=y;
+     if(y>y1) y1=y;
+    }
+   x1++;y1++;                                          // a spare pixel, like the tiles below
+  }
+ else if(command>=0x40 && command<0x60)                // lines
+  {
+   if(command&8)                                       // poly line: whole draw area
+    {
+     x0=drawX;y0=drawY;x1=drawW;y1=drawH;
+    }
+   else
+    {
+     Vertex(GETLE32(&pMem[1]),&x0,&y0);
+     Vertex(GETLE32(&pMem[(command&0x10)?3:2]),&x,&y);
+     x1=x;y1=y;
+     if(x<x0) {x1=x0;x0=x;}
+     if(y<y0) {y1=y0;y0=y;}
+     x1++;y1++;
+    }
+  }
+ else if(command>=0x60 && command<0x80)                // tiles and sprites
+  {
+   if(PSXDisplay.DrawOffset.y<=-512)                   // AdjustCoord1 may wrap y
+    {
+     x0=drawX;y0=drawY;x1=drawW;y1=drawH;
+    }
+   else
+    {
+     switch(command&0x1c)
+      {
+       case 0x00: w=GETLE32(&pMem[2])&0x3ff;h=GETLE32(&pMem[2])>>16; break;
+       case 0x04: w=GETLE32(&pMem[3])&0x3ff;h=GETLE32(&pMem[3])>>16; break;
+       case 0x08: case 0x0c: w=h=1;  break;
+       case 0x10: case 0x14: w=h=8;  break;
+       default:              w=h=16; break;
+      }
+     Vertex(GETLE32(&pMem[1]),&x0,&y0);
+     x1=x0+w;y1=y0+(h&0x3ff);
+    }
+  }
+ else return;
+
+ if(x0<drawX) x0=drawX;
+ if(y0<drawY) y0=drawY;
+ if(x1>drawW) x1=drawW;
+ if(y1>drawH) y1=drawH;
+
+ DirtyRect(x0,y0,x1,y1);
+}
@@ -0,0 +1,34 @@
+/***************************************************************************
+                          dirty.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _DIRTY_INTERNALS_H
+#define _DIRTY_INTERNALS_H
+
+// vram changed since the last display update, in tiles of 32x16 - one
+// bit per tile column, one word per tile row
+
+#define DIRTYSHIFTX 5
+#define DIRTYSHIFTY 4
+#define DIRTYROWS   (1024>>DIRTYSHIFTY)
+
+void     DirtyRect(int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+void     DirtyPrim(unsigned char command, uint32_t * pMem);
+void     DirtyAll(void);
+void     DirtyClean(void);
+uint32_t DirtyCols(int32_t x0, int32_t x1);
+uint32_t DirtyRow(int32_t y);
+BOOL     DirtyArea(int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+
+#endif // _DIRTY_INTERNALS_H
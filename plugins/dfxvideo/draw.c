@@ -22,17 +22,20 @@
 #include "draw.h"
 #include "prim.h"
 #include "menu.h"
+#include "dirty.h"
+#include "blit.h"
+#include "filter.h"
 #include "interp.h"
 #include "swap.h"
 
 // misc globals
 int            iResX;
 int            iResY;
-long           lLowerpart;
+TLS long       lLowerpart;
 BOOL           bIsFirstFrame = TRUE;
-BOOL           bCheckMask = FALSE;
-unsigned short sSetMask = 0;
-unsigned long  lSetMask = 0;
+TLS BOOL       bCheckMask = FALSE;
+TLS unsigned short sSetMask = 0;
+TLS unsigned long  lSetMask = 0;
 int            iDesktopCol = 16;
 int            iShowFPS = 0;
 int            iWinSize; 
@@ -67,6 +70,10 @@ extern XvImage  *XvShmCreateImage(Display*, XvPortID, int, char*, int, int, XShm
 
 #include <time.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // prototypes
 void hq2x_32( unsigned char * srcPtr, DWORD srcPitch, unsigned char * dstPtr, int width, int height);
 void hq3x_32( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height);
@@ -114,13 +121,14 @@ static __inline int GetResult2(DWORD A, DWORD B, DWORD C, DWORD D, DWORD E)
 	+ ((((A & qlowpixelMask8) + (B & qlowpixelMask8) + (C & qlowpixelMask8) + (D & qlowpixelMask8)) >> 2) & qlowpixelMask8))))
 
 
-void Super2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
-	            unsigned char  *dstBitmap, int width, int height)
+static void Super2xSaI_rows(unsigned char *srcPtr, DWORD srcPitch,
+	            unsigned char  *dstBitmap, int width, int height, int y0, int y1)
 {
  DWORD dstPitch        = srcPitch<<1;
  DWORD srcPitchHalf    = srcPitch>>1;
  int   finWidth        = srcPitch>>2;
  DWORD line;
+ int rows;
  DWORD *dP;
  DWORD *bP;
  int iXA,iXB,iXC,iYA,iYB,iYC,finish;
@@ -132,13 +140,13 @@ void Super2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
  DWORD product1a, product1b,
        product2a, product2b;
 
- finalw=width<<1;
- finalh=height<<1;
-
- line = 0;
+ line = y0 << 1;                                       // rows y0..y1-1 of height rows
+ srcPtr += y0 * srcPitch;
+ height -= y0;
+ rows = y1 - y0;
 
   {
-   for (; height; height-=1)
+   for (; rows; rows-=1, height-=1)
 	{
      bP = (DWORD *)srcPtr;
 	 dP = (DWORD *)(dstBitmap + line*dstPitch);
@@ -260,22 +268,29 @@ void Super2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
   }
 }
 
+void Super2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
+                    unsigned char *dstBitmap, int width, int height)
+{
+ finalw=width<<1;
+ finalh=height<<1;
+
+ FilterBands(Super2xSaI_rows, srcPtr, srcPitch, dstBitmap, width, height);
+}
+
 ////////////////////////////////////////////////////////////////////////
 
-void Std2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
-                  unsigned char *dstBitmap, int width, int height)
+static void Std2xSaI_rows(unsigned char *srcPtr, DWORD srcPitch,
+                  unsigned char *dstBitmap, int width, int height, int y0, int y1)
 {
  DWORD dstPitch        = srcPitch<<1;
  DWORD srcPitchHalf    = srcPitch>>1;
  int   finWidth        = srcPitch>>2;
  DWORD line;
+ int rows;
  DWORD *dP;
  DWORD *bP;
  int iXA,iXB,iXC,iYA,iYB,iYC,finish;
 
- finalw=width<<1;
- finalh=height<<1;
-
  DWORD colorA, colorB;
  DWORD colorC, colorD,
        colorE, colorF, colorG, colorH,
@@ -283,10 +298,13 @@ void Std2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
        colorM, colorN, colorO, colorP;
  DWORD product, product1, product2;
 
- line = 0;
+ line = y0 << 1;                                       // rows y0..y1-1 of height rows
+ srcPtr += y0 * srcPitch;
+ height -= y0;
+ rows = y1 - y0;
 
   {
-   for (; height; height-=1)
+   for (; rows; rows-=1, height-=1)
 	{
      bP = (DWORD *)srcPtr;
 	 dP = (DWORD *)(dstBitmap + line*dstPitch);
@@ -466,15 +484,25 @@ void Std2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
   }
 }
 
+void Std2xSaI_ex8(unsigned char *srcPtr, DWORD srcPitch,
+                  unsigned char *dstBitmap, int width, int height)
+{
+ finalw=width<<1;
+ finalh=height<<1;
+
+ FilterBands(Std2xSaI_rows, srcPtr, srcPitch, dstBitmap, width, height);
+}
+
 ////////////////////////////////////////////////////////////////////////
 
-void SuperEagle_ex8(unsigned char *srcPtr, DWORD srcPitch,
-	                unsigned char  *dstBitmap, int width, int height)
+static void SuperEagle_rows(unsigned char *srcPtr, DWORD srcPitch,
+	                unsigned char  *dstBitmap, int width, int height, int y0, int y1)
 {
  DWORD dstPitch        = srcPitch<<1;
  DWORD srcPitchHalf    = srcPitch>>1;
  int   finWidth        = srcPitch>>2;
  DWORD line;
+ int rows;
  DWORD *dP;
  DWORD *bP;
  int iXA,iXB,iXC,iYA,iYB,iYC,finish;
@@ -486,13 +514,13 @@ void SuperEagle_ex8(unsigned char *srcPtr, DWORD srcPitch,
  DWORD product1a, product1b,
        product2a, product2b;
 
- finalw=width<<1;
- finalh=height<<1;
-
- line = 0;
+ line = y0 << 1;                                       // rows y0..y1-1 of height rows
+ srcPtr += y0 * srcPitch;
+ height -= y0;
+ rows = y1 - y0;
 
   {
-   for (; height; height-=1)
+   for (; rows; rows-=1, height-=1)
 	{
      bP = (DWORD *)srcPtr;
 	 dP = (DWORD *)(dstBitmap + line*dstPitch);
@@ -634,6 +662,15 @@ void SuperEagle_ex8(unsigned char *srcPtr, DWORD srcPitch,
   }
 }
 
+void SuperEagle_ex8(unsigned char *srcPtr, DWORD srcPitch,
+                    unsigned char *dstBitmap, int width, int height)
+{
+ finalw=width<<1;
+ finalh=height<<1;
+
+ FilterBands(SuperEagle_rows, srcPtr, srcPitch, dstBitmap, width, height);
+}
+
 /////////////////////////
 
 //#include <assert.h>
@@ -698,39 +735,40 @@ static __inline void scale2x_32_def_whole(uint32_t*  dst0, uint32_t* dst1, const
 	}
 }
 
-void Scale2x_ex8(unsigned char *srcPtr, DWORD srcPitch,
-				 unsigned char  *dstPtr, int width, int height)
+static void Scale2x_rows(unsigned char *srcPtr, DWORD srcPitch,
+				 unsigned char  *dstPtr, int width, int height, int y0, int y1)
 {
-	//const int srcpitch = srcPitch;
 	const int dstPitch = srcPitch<<1;
+	const int srcRowPixels = srcPitch>>2;
+
+	uint32_t  *src = (uint32_t  *)srcPtr;
+	uint32_t  *dst0, *dst1;
+	int y;
+
+	// the source rows the old single pass loop used: in the middle it
+	// centers on the row above, so that's kept
+	for (y = y0; y < y1; y++) {
+		dst0 = (uint32_t  *)dstPtr + y * (dstPitch >> 1);
+		dst1 = dst0 + (dstPitch >> 2);
+
+		if (y == 0)
+			scale2x_32_def_whole(dst0, dst1, src, src, src + srcRowPixels, width);
+		else if (y == height - 1)
+			scale2x_32_def_whole(dst0, dst1, src + (y - 1) * srcRowPixels,
+				src + y * srcRowPixels, src + y * srcRowPixels, width);
+		else
+			scale2x_32_def_whole(dst0, dst1, src + (y - 1) * srcRowPixels,
+				src + (y - 1) * srcRowPixels, src + y * srcRowPixels, width);
+	}
+}
 
-	int count = height;
-
+void Scale2x_ex8(unsigned char *srcPtr, DWORD srcPitch,
+				 unsigned char  *dstPtr, int width, int height)
+{
 	finalw=width<<1;
 	finalh=height<<1;
 
-	uint32_t  *dst0 = (uint32_t  *)dstPtr;
-	uint32_t  *dst1 = dst0 + (dstPitch >> 2);
-
-	uint32_t  *src0 = (uint32_t  *)srcPtr;
-	uint32_t  *src1 = src0 + (srcPitch >> 2);
-	uint32_t  *src2 = src1 + (srcPitch >> 2);
-	scale2x_32_def_whole(dst0, dst1, src0, src0, src1, width);
-
-	count -= 2;
-	while(count) {
-		dst0 += dstPitch >> 1;
-		dst1 += dstPitch >> 1;
-		scale2x_32_def_whole(dst0, dst1, src0, src0, src1, width);
-		src0 = src1;
-		src1 = src2;
-		src2 += srcPitch >> 2;
-		--count;
-	}
-	dst0 += dstPitch >> 1;
-	dst1 += dstPitch >> 1;
-	scale2x_32_def_whole(dst0, dst1, src0, src1, src1, width);
-
+	FilterBands(Scale2x_rows, srcPtr, srcPitch, dstPtr, width, height);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -827,44 +865,38 @@ static __inline void scale3x_32_def_whole(uint32_t* dst0, uint32_t* dst1, uint32
 }
 
 
-void Scale3x_ex8(unsigned char *srcPtr, DWORD srcPitch,
-				 unsigned char  *dstPtr, int width, int height)
+static void Scale3x_rows(unsigned char *srcPtr, DWORD srcPitch,
+				 unsigned char  *dstPtr, int width, int height, int y0, int y1)
 {
-	int count = height;
-
 	int dstPitch = srcPitch*3;
-	int dstRowPixels = dstPitch>>2;	
+	int dstRowPixels = dstPitch>>2;
+	int srcRowPixels = srcPitch>>2;
 
-	finalw=width*3;
-	finalh=height*3;
+	uint32_t  *src = (uint32_t  *)srcPtr;
+	uint32_t  *dst0, *dst1, *dst2;
+	int y, ya, yb;
 
-	uint32_t  *dst0 = (uint32_t  *)dstPtr;
-	uint32_t  *dst1 = dst0 + dstRowPixels;
-	uint32_t  *dst2 = dst1 + dstRowPixels;
+	for (y = y0; y < y1; y++) {
+		dst0 = (uint32_t  *)dstPtr + y * dstRowPixels * 3;
+		dst1 = dst0 + dstRowPixels;
+		dst2 = dst1 + dstRowPixels;
 
-	uint32_t  *src0 = (uint32_t  *)srcPtr;
-	uint32_t  *src1 = src0 + (srcPitch >> 2);
-	uint32_t  *src2 = src1 + (srcPitch >> 2);
-	scale3x_32_def_whole(dst0, dst1, dst2, src0, src0, src2, width);
+		ya = y > 0 ? y - 1 : 0;
+		yb = y < height - 1 ? y + 1 : y;
+		if (y == 0) yb = 2;			// as the old single pass loop did
 
-	count -= 2;
-	while(count) {
-		dst0 += dstRowPixels*3;
-		dst1 += dstRowPixels*3;
-		dst2 += dstRowPixels*3;
-
-		scale3x_32_def_whole(dst0, dst1, dst2, src0, src1, src2, width);
-		src0 = src1;
-		src1 = src2;
-		src2 += srcPitch >> 2;
-		--count;
+		scale3x_32_def_whole(dst0, dst1, dst2, src + ya * srcRowPixels,
+			src + y * srcRowPixels, src + yb * srcRowPixels, width);
 	}
+}
 
-	dst0 += dstRowPixels*3;
-	dst1 += dstRowPixels*3;
-	dst2 += dstRowPixels*3;
+void Scale3x_ex8(unsigned char *srcPtr, DWORD srcPitch,
+				 unsigned char  *dstPtr, int width, int height)
+{
+	finalw=width*3;
+	finalh=height*3;
 
-	scale3x_32_def_whole(dst0, dst1, dst2, src0, src1, src1, width);
+	FilterBands(Scale3x_rows, srcPtr, srcPitch, dstPtr, width, height);
 }
 
 
@@ -1322,13 +1354,74 @@ shminfo.readOnly = 0;
 void (*p2XSaIFunc) (unsigned char *, DWORD, unsigned char *, int, int);
 unsigned char *pBackBuffer = 0;
 
+////////////////////////////////////////////////////////////////////////
+// dirty tiles: the shm image (and the back buffer of the filters) keep
+// their content between swaps, so only vram rows/tiles that changed
+// since the last swap have to be converted again
+////////////////////////////////////////////////////////////////////////
+
+#define DIRTYREFRESH 50                                // put the image at least every n swaps
+
+static BOOL     bSwapInvalid = TRUE;                   // whole image must be redone
+static BOOL     bBlitAll = TRUE;
+static uint32_t ulBlitCols;                            // dirty cols under the display
+static int      iSkippedSwaps = 0;
+
+static BOOL SwapNeeded(unsigned int w, unsigned int h)
+{
+ static int32_t lLast[12];
+ int32_t l[12];
+ int32_t x = PSXDisplay.DisplayPosition.x;
+ int32_t y = PSXDisplay.DisplayPosition.y;
+ int32_t vw;
+
+ l[0] = x;
+ l[1] = y;
+ l[2] = PSXDisplay.DisplayMode.x;
+ l[3] = PSXDisplay.DisplayMode.y;
+ l[4] = PSXDisplay.RGB24;
+ l[5] = PreviousPSXDisplay.Range.x0;
+ l[6] = PreviousPSXDisplay.Range.x1;
+ l[7] = PreviousPSXDisplay.Range.y0;
+ l[8] = PreviousPSXDisplay.DisplayMode.y;
+ l[9] = w;
+ l[10] = h;
+ l[11] = iWindowMode | (iMaintainAspect << 1) | (use_yuv << 2) | ((ulKeybits & KEY_SHOWFPS) << 3);
+
+ if (PSXDisplay.RGB24) vw = (PreviousPSXDisplay.Range.x1 * 3 + 1) / 2 + 1; // 4 byte reads
+ else                  vw = PreviousPSXDisplay.Range.x1;
+
+ bBlitAll = TRUE;
+
+ if (!iUseDirtyRects || bSwapInvalid || (ulKeybits & KEY_SHOWFPS) ||
+     x + vw > 1024 || memcmp(l, lLast, sizeof(l)))     // lines wrapping into the next one: no
+  {
+   memcpy(lLast, l, sizeof(l));
+   bSwapInvalid = FALSE;
+   iSkippedSwaps = 0;
+   return TRUE;
+  }
+
+ bBlitAll = FALSE;
+ ulBlitCols = DirtyCols(x, x + vw - 1);
+
+ if (DirtyArea(x, y, x + vw - 1, y + PreviousPSXDisplay.DisplayMode.y - 1))
+  {
+   iSkippedSwaps = 0;
+   return TRUE;
+  }
+
+ if (++iSkippedSwaps < DIRTYREFRESH) return FALSE;     // nothing new on screen
+ iSkippedSwaps = 0;
+ return TRUE;                                          // put it again, converts nothing
+}
+
 void BlitScreen32(unsigned char *surf, int32_t x, int32_t y)
 {
  unsigned char *pD;
  unsigned int startxy;
- uint32_t lu;
- unsigned short s;
- unsigned short row, column;
+ uint32_t mask;
+ unsigned short row, column, end;
  unsigned short dx = PreviousPSXDisplay.Range.x1;
  unsigned short dy = PreviousPSXDisplay.DisplayMode.y;
 
@@ -1361,29 +1454,31 @@ void BlitScreen32(unsigned char *surf, int32_t x, int32_t y)
   {
    for (column = 0; column < dy; column++)
     {
+     if (!bBlitAll && !(DirtyRow(column + y) & ulBlitCols)) continue;
      startxy = ((1024) * (column + y)) + x;
      pD = (unsigned char *)&psxVuw[startxy];
      destpix = (uint32_t *)(surf + (column * lPitch));
-     for (row = 0; row < dx; row++)
-      {
-       lu = *((uint32_t *)pD);
-       destpix[row] = 
-          0xff000000 | (RED(lu) << 16) | (GREEN(lu) << 8) | (BLUE(lu));
-       pD += 3;
-      }
+     pBlit->To32_24(destpix, pD, dx);
     }
   }
  else
   {
    for (column = 0;column<dy;column++)
     {
+     if (bBlitAll) mask = 0xffffffff;
+     else if (!(mask = DirtyRow(column + y) & ulBlitCols)) continue;
      startxy = (1024 * (column + y)) + x;
      destpix = (uint32_t *)(surf + (column * lPitch));
-     for (row = 0; row < dx; row++)
+     for (row = 0; row < dx; row = end)                // runs of dirty tile cols
       {
-       s = GETLE16(&psxVuw[startxy++]);
-       destpix[row] = 
-          (((s << 19) & 0xf80000) | ((s << 6) & 0xf800) | ((s >> 7) & 0xf8)) | 0xff000000;
+       end = ((((x + row) >> DIRTYSHIFTX) + 1) << DIRTYSHIFTX) - x;
+       if (mask & (1u << ((x + row) >> DIRTYSHIFTX)))
+        {
+         while (end < dx && (mask & (1u << ((x + end) >> DIRTYSHIFTX))))
+          end += 1 << DIRTYSHIFTX;
+         if (end > dx) end = dx;
+         pBlit->To32(destpix + row, &psxVuw[startxy + row], end - row);
+        }
       }
     }
   }
@@ -1393,11 +1488,9 @@ void BlitToYUV(unsigned char * surf,int32_t x,int32_t y)
 {
  unsigned char * pD;
  unsigned int startxy;
- uint32_t lu;unsigned short s;
  unsigned short row,column;
  unsigned short dx = PreviousPSXDisplay.Range.x1;
  unsigned short dy = PreviousPSXDisplay.DisplayMode.y;
- int Y,U,V, R,G,B;
 
  int32_t lPitch = PSXDisplay.DisplayMode.x << 2;
  uint32_t *destpix;
@@ -1443,54 +1536,21 @@ void BlitToYUV(unsigned char * surf,int32_t x,int32_t y)
   {
    for (column = 0; column < dy; column++)
     {
+     if (!bBlitAll && !(DirtyRow(column + y) & ulBlitCols)) continue;
      startxy = (1024 * (column + y)) + x;
      pD = (unsigned char *)&psxVuw[startxy];
      destpix = (uint32_t *)(surf + (column * lPitch));
-     for (row = 0; row < dx; row++)
-      {
-       lu = *((uint32_t *)pD);
-
-       R = RED(lu);
-       G = GREEN(lu);
-       B = BLUE(lu);
-
-       Y = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
-       U = min(abs(R * -1214 + G * -2384 + B * 3598 + 4096 + 1048576) >> 13, 240);
-       V = min(abs(R * 3598 + G * -3013 + B * -585 + 4096 + 1048576) >> 13, 240);
-
-#ifdef __BIG_ENDIAN__
-       destpix[row] = Y << 24 | U << 16 | Y << 8 | V;
-#else
-       destpix[row] = Y << 24 | V << 16 | Y << 8 | U;
-#endif
-       pD += 3;
-      }
+     pBlit->ToYUV_24(destpix, pD, dx);
     }
   }
  else
   {
    for (column = 0; column < dy; column++)
     {
+     if (!bBlitAll && !(DirtyRow(column + y) & ulBlitCols)) continue;
      startxy = (1024 * (column + y)) + x;
      destpix = (uint32_t *)(surf + (column * lPitch));
-     for (row = 0; row < dx; row++)
-      {
-       s = GETLE16(&psxVuw[startxy++]);
-
-       R = (s << 3) &0xf8;
-       G = (s >> 2) &0xf8;
-       B = (s >> 7) &0xf8;
-
-       Y = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
-       U = min(abs(R * -1214 + G * -2384 + B * 3598 + 4096 + 1048576) >> 13, 240);
-       V = min(abs(R * 3598 + G * -3013 + B * -585 + 4096 + 1048576) >> 13, 240);
-
-#ifdef __BIG_ENDIAN__
-       destpix[row] = Y << 24 | U << 16 | Y << 8 | V;
-#else
-       destpix[row] = Y << 24 | V << 16 | Y << 8 | U;
-#endif
-      }
+     pBlit->ToYUV(destpix, &psxVuw[startxy], dx);
     }
   }
 }
@@ -1498,34 +1558,12 @@ void BlitToYUV(unsigned char * surf,int32_t x,int32_t y)
 //dst will have half the pitch (32bit to 16bit)
 void RGB2YUV(uint32_t *s, int width, int height, uint32_t *d)
 {
-	int x,y;
-	int R,G,B, Y1,Y2,U,V;
+	int y;
 
 	for (y=0; y<height; y++) {
-		for(x=0; x<width>>1; x++) {
-			R = (*s >> 16) & 0xff;
-			G = (*s >> 8) & 0xff;
-			B = *s & 0xff;
-			s++;
-
-			Y1 = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
-			U = min(abs(R * -1214 + G * -2384 + B * 3598 + 4096 + 1048576) >> 13, 240);
-			V = min(abs(R * 3598 + G * -3013 + B * -585 + 4096 + 1048576) >> 13, 240);
-
-			R = (*s >> 16) & 0xff;
-			G = (*s >> 8) & 0xff;
-			B = *s & 0xff;
-			s++;
-
-			Y2 = min(abs(R * 2104 + G * 4130 + B * 802 + 4096 + 131072) >> 13, 235);
-
-#ifdef __BIG_ENDIAN__
-			*d = V | Y2 << 8 | U << 16 | Y1 << 24;
-#else
-			*d = U | Y1 << 8 | V << 16 | Y2 << 24;
-#endif
-			d++;
-		}
+		pBlit->RGBToYUV(d, s, width);
+		s += width & ~1;
+		d += width >> 1;
 	}
 }
 
@@ -1564,6 +1602,10 @@ void DoBufferSwap(void)
 
 	XSync(display,False);
 
+	XGetGeometry(display, window, &_dw, (int *)&_d, (int *)&_d, &_w, &_h, &_d, &_d);
+	if (!SwapNeeded(_w, _h))
+		return;
+
 	if(use_yuv) {
 		if (iUseNoStretchBlt==0 || finalw > 320 || finalh > 256) {
 			BlitToYUV((unsigned char *)shminfo.shmaddr, PSXDisplay.DisplayPosition.x, PSXDisplay.DisplayPosition.y);
@@ -1580,7 +1622,8 @@ void DoBufferSwap(void)
 		p2XSaIFunc(pBackBuffer, finalw<<2, (unsigned char *)shminfo.shmaddr,finalw,finalh);
 	}
 
-	XGetGeometry(display, window, &_dw, (int *)&_d, (int *)&_d, &_w, &_h, &_d, &_d);
+	DirtyClean();
+
 	if (use_yuv) {
 		xvi = XvShmCreateImage(display, yuv_port, yuv_id, 0, finalw, finalh, &shminfo);
 	} else
@@ -1658,6 +1701,8 @@ void DoClearScreenBuffer(void)                         // CLEAR DX BUFFER
  XvPutImage(display, xv_port, window, hGC, XCimage,
            0, 0, 8, 8, 0, 0, _w, _h);
  //XSync(display,False);
+
+ bSwapInvalid = TRUE;
 }
 
 void DoClearFrontBuffer(void)                          // CLEAR DX BUFFER
@@ -1671,6 +1716,9 @@ int Xinitialize()
 {
    iDesktopCol=32;
 
+ bSwapInvalid = TRUE;                                  // new shm image
+ BlitSelect();
+
 
  if(iUseNoStretchBlt>0)
   {
@@ -1716,6 +1764,8 @@ int Xinitialize()
    p2XSaIFunc=hq3x_32;
   }
 
+ if(p2XSaIFunc) FilterStart();                         // band threads for the filter
+
  bUsingTWin=FALSE;
 
  InitMenu();
@@ -1744,6 +1794,8 @@ void Xcleanup()                                        // X CLEANUP
    if(pSaIBigBuff) free(pSaIBigBuff);
    pSaIBigBuff=0;
   }
+
+ FilterStop();
 }
 
 unsigned long ulInitDisplay(void)
@@ -1847,18 +1899,159 @@ void ShowTextGpuPic(void)
 {
 }
 
-static void hq2x_32_def(uint32_t * dst0, uint32_t * dst1, const uint32_t * src0, const uint32_t * src1, const uint32_t * src2, unsigned count)
+////////////////////////////////////////////////////////////////////////
+// hq2x/hq3x: the 8 neighbour yuv tests of a pixel (interp_32_diff) are
+// done for a whole row up front, from y/u/v rows computed once per
+// source row. interp_32_diff is r+g+b, r-b and -r+2g-b of the channel
+// differences against limits, so the same y/u/v of each pixel give the
+// same answer (its early out on the top 5 bits can't change it, the
+// low bits alone never pass the limits).
+////////////////////////////////////////////////////////////////////////
+
+#define HQMAXW 640
+#define HQPAD  16                                      // edge pixel + simd overrun
+
+typedef struct
+{
+ int           iRow[4];                                // source row in each slot
+ short         sY[4][HQMAXW+HQPAD];                    // [1+i] is pixel i, edges repeated
+ short         sU[4][HQMAXW+HQPAD];
+ short         sV[4][HQMAXW+HQPAD];
+ unsigned char ucMask[HQMAXW+HQPAD];
+} HQRows_t;
+
+static int HQRow(HQRows_t * hq, const uint32_t * src, int srcRowPixels, int row, int width)
+{
+ int k = row & 3, i, r, g, b;
+ const uint32_t * p = src + row * srcRowPixels;
+ short * y = hq->sY[k], * u = hq->sU[k], * v = hq->sV[k];
+
+ if (hq->iRow[k] == row) return k;
+ hq->iRow[k] = row;
+
+ for (i = 0; i < width; i++)
+  {
+   r = (p[i] >> 16) & 0xff;
+   g = (p[i] >> 8) & 0xff;
+   b = p[i] & 0xff;
+   y[i + 1] = r + g + b;
+   u[i + 1] = r - b;
+   v[i + 1] = -r + 2 * g - b;
+  }
+ y[0] = y[1]; u[0] = u[1]; v[0] = v[1];
+ for (i = width + 1; i < width + HQPAD; i++)
+  {
+   y[i] = y[width]; u[i] = u[width]; v[i] = v[width];
+  }
+ return k;
+}
+
+#ifdef __SSE2__
+
+#define HQLOAD(a,k,o) _mm_loadu_si128((__m128i *)&(a)[k][i + (o)])
+
+static __inline __m128i HQDiff(__m128i y1, __m128i u1, __m128i v1,
+                               __m128i y2, __m128i u2, __m128i v2, int bit)
+{
+ __m128i z = _mm_setzero_si128(), d, m;
+
+ d = _mm_sub_epi16(y1, y2);
+ m = _mm_cmpgt_epi16(_mm_max_epi16(d, _mm_sub_epi16(z, d)), _mm_set1_epi16(INTERP_Y_LIMIT));
+ d = _mm_sub_epi16(u1, u2);
+ m = _mm_or_si128(m, _mm_cmpgt_epi16(_mm_max_epi16(d, _mm_sub_epi16(z, d)), _mm_set1_epi16(INTERP_U_LIMIT)));
+ d = _mm_sub_epi16(v1, v2);
+ m = _mm_or_si128(m, _mm_cmpgt_epi16(_mm_max_epi16(d, _mm_sub_epi16(z, d)), _mm_set1_epi16(INTERP_V_LIMIT)));
+
+ return _mm_and_si128(m, _mm_set1_epi16(bit));
+}
+
+#define HQDIFF(k,o,bit) HQDiff(HQLOAD(hq->sY,k,o), HQLOAD(hq->sU,k,o), HQLOAD(hq->sV,k,o), y4, u4, v4, bit)
+
+#endif
+
+static __inline int HQDiff1(HQRows_t * hq, int k1, int i1, int k2, int i2)
+{
+ int d;
+
+ d = hq->sY[k1][i1] - hq->sY[k2][i2];
+ if (d < -INTERP_Y_LIMIT || d > INTERP_Y_LIMIT) return 1;
+ d = hq->sU[k1][i1] - hq->sU[k2][i2];
+ if (d < -INTERP_U_LIMIT || d > INTERP_U_LIMIT) return 1;
+ d = hq->sV[k1][i1] - hq->sV[k2][i2];
+ if (d < -INTERP_V_LIMIT || d > INTERP_V_LIMIT) return 1;
+ return 0;
+}
+
+// masks of one output row: k0,k1,k2 are the slots of the rows above, at
+// and below, bit 1 (above) comes from the slots ka,kb
+static void HQMasks(HQRows_t * hq, int k0, int k1, int k2, int ka, int kb, int width)
+{
+ int i = 0;
+
+#ifdef __SSE2__
+ __m128i y4, u4, v4, m;
+
+ for (; i < width; i += 8)                             // the padding takes the overrun
+  {
+   y4 = HQLOAD(hq->sY, k1, 1);
+   u4 = HQLOAD(hq->sU, k1, 1);
+   v4 = HQLOAD(hq->sV, k1, 1);
+
+   m = HQDIFF(k0, 0, 0x01);
+   m = _mm_or_si128(m, HQDiff(HQLOAD(hq->sY, ka, 1), HQLOAD(hq->sU, ka, 1), HQLOAD(hq->sV, ka, 1),
+                              HQLOAD(hq->sY, kb, 1), HQLOAD(hq->sU, kb, 1), HQLOAD(hq->sV, kb, 1), 0x02));
+   m = _mm_or_si128(m, HQDIFF(k0, 2, 0x04));
+   m = _mm_or_si128(m, HQDIFF(k1, 0, 0x08));
+   m = _mm_or_si128(m, HQDIFF(k1, 2, 0x10));
+   m = _mm_or_si128(m, HQDIFF(k2, 0, 0x20));
+   m = _mm_or_si128(m, HQDIFF(k2, 1, 0x40));
+   m = _mm_or_si128(m, HQDIFF(k2, 2, 0x80));
+
+   _mm_storel_epi64((__m128i *)&hq->ucMask[i], _mm_packus_epi16(m, m));
+  }
+#else
+ for (; i < width; i++)
+  hq->ucMask[i] = HQDiff1(hq, k0, i, k1, i + 1) |
+                  HQDiff1(hq, ka, i + 1, kb, i + 1) << 1 |
+                  HQDiff1(hq, k0, i + 2, k1, i + 1) << 2 |
+                  HQDiff1(hq, k1, i, k1, i + 1) << 3 |
+                  HQDiff1(hq, k1, i + 2, k1, i + 1) << 4 |
+                  HQDiff1(hq, k2, i, k1, i + 1) << 5 |
+                  HQDiff1(hq, k2, i + 1, k1, i + 1) << 6 |
+                  HQDiff1(hq, k2, i + 2, k1, i + 1) << 7;
+#endif
+}
+
+// the slots for output row y; the old single pass loop of hq3x took row
+// 2 as the one below row 0, and carried that into bit 1 of row 1
+static void HQSetup(HQRows_t * hq, const uint32_t * src, int srcRowPixels, int width, int height,
+                    int y, BOOL bHQ3, int * r0, int * r2)
+{
+ int k0, k1, k2, ka, kb;
+
+ *r0 = y > 0 ? y - 1 : 0;
+ *r2 = y < height - 1 ? y + 1 : y;
+ if (bHQ3 && y == 0) *r2 = 2;
+
+ k0 = HQRow(hq, src, srcRowPixels, *r0, width);
+ k1 = HQRow(hq, src, srcRowPixels, y, width);
+ k2 = HQRow(hq, src, srcRowPixels, *r2, width);
+ ka = k0; kb = k1;
+ if (bHQ3 && y == 1)
+  {
+   ka = HQRow(hq, src, srcRowPixels, 2, width);
+   kb = HQRow(hq, src, srcRowPixels, 0, width);
+  }
+
+ HQMasks(hq, k0, k1, k2, ka, kb, width);
+}
+
+static void hq2x_32_def(uint32_t * dst0, uint32_t * dst1, const uint32_t * src0, const uint32_t * src1, const uint32_t * src2, const unsigned char * masks, unsigned count)
 {
-	static unsigned char cache_vert_mask[640];
-	unsigned char cache_horiz_mask = 0;
-	
 	unsigned i;
 	unsigned char mask;
 	uint32_t  c[9];
 
-	if (src0 == src1)	//processing first row
-		memset(cache_vert_mask, 0, count);	
-	
 	for(i=0;i<count;++i) {
 		c[1] = src0[0];
 		c[4] = src1[0];
@@ -1884,19 +2077,7 @@ static void hq2x_32_def(uint32_t * dst0, uint32_t * dst1, const uint32_t * src0,
 			c[8] = c[7];
 		}
 
-		mask = 0;
-
-		mask |= interp_32_diff(c[0], c[4]) << 0;
-		mask |= cache_vert_mask[i];
-		mask |= interp_32_diff(c[2], c[4]) << 2;
-		mask |= cache_horiz_mask;
-		cache_horiz_mask = interp_32_diff(c[5], c[4]) << 3;
-		mask |= cache_horiz_mask << 1;	// << 3 << 1 == << 4
-		mask |= interp_32_diff(c[6], c[4]) << 5;
-		cache_vert_mask[i] = interp_32_diff(c[7], c[4]) << 1;
-		mask |= cache_vert_mask[i] << 5; // << 1 << 5 == << 6
-		mask |= interp_32_diff(c[8], c[4]) << 7;
-
+		mask = masks[i];
 
 		switch (mask) {
 #include "hq2x.h"
@@ -1911,51 +2092,41 @@ static void hq2x_32_def(uint32_t * dst0, uint32_t * dst1, const uint32_t * src0,
 	}
 }
 
-void hq2x_32( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height)
+static void hq2x_32_rows( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height, int y0, int y1)
 {
 	const int dstPitch = srcPitch<<1;
+	const int srcRowPixels = srcPitch>>2;
 
-	int count = height;
+	uint32_t  *src = (uint32_t  *)srcPtr;
+	uint32_t  *dst0;
+	HQRows_t  hq;
+	int y, r0, r2;
 
-	finalw=width*2;
-	finalh=height*2;
-
-	uint32_t  *dst0 = (uint32_t  *)dstPtr;
-	uint32_t  *dst1 = dst0 + (dstPitch >> 2);
+	memset(hq.iRow, 0xff, sizeof(hq.iRow));
 
-	uint32_t  *src0 = (uint32_t  *)srcPtr;
-	uint32_t  *src1 = src0 + (srcPitch >> 2);
-	uint32_t  *src2 = src1 + (srcPitch >> 2);
-	hq2x_32_def(dst0, dst1, src0, src0, src1, width);
+	for (y = y0; y < y1; y++) {
+		HQSetup(&hq, src, srcRowPixels, width, height, y, FALSE, &r0, &r2);
 
-
-	count -= 2;
-	while(count) {
-		dst0 += dstPitch >> 1;		//next 2 lines (dstPitch / 4 char per int * 2)
-		dst1 += dstPitch >> 1;
-		hq2x_32_def(dst0, dst1, src0, src1, src2, width);
-		src0 = src1;
-		src1 = src2;
-		src2 += srcPitch >> 2;
-		--count;
+		dst0 = (uint32_t  *)dstPtr + y * (dstPitch >> 1);		//2 lines (dstPitch / 4 char per int * 2)
+		hq2x_32_def(dst0, dst0 + (dstPitch >> 2), src + r0 * srcRowPixels,
+			src + y * srcRowPixels, src + r2 * srcRowPixels, hq.ucMask, width);
 	}
-	dst0 += dstPitch >> 1;
-	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src1, width);
 }
 
-static void hq3x_32_def(uint32_t*  dst0, uint32_t*  dst1, uint32_t*  dst2, const uint32_t* src0, const uint32_t* src1, const uint32_t* src2, unsigned count)
+void hq2x_32( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height)
 {
-	static unsigned char cache_vert_mask[640];
-	unsigned char cache_horiz_mask = 0;
+	finalw=width*2;
+	finalh=height*2;
 
+	FilterBands(hq2x_32_rows, srcPtr, srcPitch, dstPtr, width, height);
+}
+
+static void hq3x_32_def(uint32_t*  dst0, uint32_t*  dst1, uint32_t*  dst2, const uint32_t* src0, const uint32_t* src1, const uint32_t* src2, const unsigned char * masks, unsigned count)
+{
 	unsigned i;
 	unsigned char mask;
 	uint32_t  c[9];
 
-	if (src0 == src1)	//processing first row
-		memset(cache_vert_mask, 0, count);	
-
 	for(i=0;i<count;++i) {
 		c[1] = src0[0];
 		c[4] = src1[0];
@@ -1981,18 +2152,7 @@ static void hq3x_32_def(uint32_t*  dst0, uint32_t*  dst1, uint32_t*  dst2, const
 			c[8] = c[7];
 		}
 
-		mask = 0;
-		
-		mask |= interp_32_diff(c[0], c[4]) << 0;
-		mask |= cache_vert_mask[i];
-		mask |= interp_32_diff(c[2], c[4]) << 2;
-		mask |= cache_horiz_mask;
-		cache_horiz_mask = interp_32_diff(c[5], c[4]) << 3;
-		mask |= cache_horiz_mask << 1;	// << 3 << 1 == << 4
-		mask |= interp_32_diff(c[6], c[4]) << 5;
-		cache_vert_mask[i] = interp_32_diff(c[7], c[4]) << 1;
-		mask |= cache_vert_mask[i] << 5; // << 1 << 5 == << 6
-		mask |= interp_32_diff(c[8], c[4]) << 7;
+		mask = masks[i];
 
 		switch (mask) {
 #include "hq3x.h"
@@ -2007,41 +2167,32 @@ static void hq3x_32_def(uint32_t*  dst0, uint32_t*  dst1, uint32_t*  dst2, const
 	}
 }
 
-void hq3x_32( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height)
+static void hq3x_32_rows( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height, int y0, int y1)
 {
-	int count = height;
-
 	int dstPitch = srcPitch*3;
 	int dstRowPixels = dstPitch>>2;
+	int srcRowPixels = srcPitch>>2;
 
-	finalw=width*3;
-	finalh=height*3;
+	uint32_t  *src = (uint32_t  *)srcPtr;
+	uint32_t  *dst0;
+	HQRows_t  hq;
+	int y, r0, r2;
 
-	uint32_t  *dst0 = (uint32_t  *)dstPtr;
-	uint32_t  *dst1 = dst0 + dstRowPixels;
-	uint32_t  *dst2 = dst1 + dstRowPixels;
+	memset(hq.iRow, 0xff, sizeof(hq.iRow));
 
-	uint32_t  *src0 = (uint32_t  *)srcPtr;
-	uint32_t  *src1 = src0 + (srcPitch >> 2);
-	uint32_t  *src2 = src1 + (srcPitch >> 2);
-	hq3x_32_def(dst0, dst1, dst2, src0, src0, src2, width);
+	for (y = y0; y < y1; y++) {
+		HQSetup(&hq, src, srcRowPixels, width, height, y, TRUE, &r0, &r2);
 
-	count -= 2;
-	while(count) {
-		dst0 += dstRowPixels * 3;
-		dst1 += dstRowPixels * 3;
-		dst2 += dstRowPixels * 3;
-
-		hq3x_32_def(dst0, dst1, dst2, src0, src1, src2, width);
-		src0 = src1;
-		src1 = src2;
-		src2 += srcPitch >> 2;
-		--count;
+		dst0 = (uint32_t  *)dstPtr + y * dstRowPixels * 3;
+		hq3x_32_def(dst0, dst0 + dstRowPixels, dst0 + dstRowPixels * 2, src + r0 * srcRowPixels,
+			src + y * srcRowPixels, src + r2 * srcRowPixels, hq.ucMask, width);
 	}
-	dst0 += dstRowPixels * 3;
-	dst1 += dstRowPixels * 3;
-	dst2 += dstRowPixels * 3;
+}
 
-	hq3x_32_def(dst0, dst1, dst2, src0, src1, src1, width);
+void hq3x_32( unsigned char * srcPtr,  DWORD srcPitch, unsigned char * dstPtr, int width, int height)
+{
+	finalw=width*3;
+	finalh=height*3;
 
+	FilterBands(hq3x_32_rows, srcPtr, srcPitch, dstPtr, width, height);
 }
@@ -46,17 +46,27 @@
 #define GPUSTATUS_DRAWINGALLOWED      0x00000400
 #define GPUSTATUS_DITHER              0x00000200
 
-#define GPUIsBusy (lGPUstatusRet &= ~GPUSTATUS_IDLE)
-#define GPUIsIdle (lGPUstatusRet |= GPUSTATUS_IDLE)
+// with the gpu thread the worker updates the status while GPUreadStatus
+// reads it on the emu thread, so both go through atomics. Everything
+// else on the emu thread touches it only after GPUThreadSync.
+#define GPUStatusGet()  __atomic_load_n(&lGPUstatusRet, __ATOMIC_ACQUIRE)
+#define GPUStatusSet(v) __atomic_store_n(&lGPUstatusRet, (v), __ATOMIC_RELEASE)
 
-#define GPUIsNotReadyForCommands (lGPUstatusRet &= ~GPUSTATUS_READYFORCOMMANDS)
-#define GPUIsReadyForCommands (lGPUstatusRet |= GPUSTATUS_READYFORCOMMANDS)
+#define GPUIsBusy __atomic_and_fetch(&lGPUstatusRet, ~GPUSTATUS_IDLE, __ATOMIC_RELEASE)
+#define GPUIsIdle __atomic_or_fetch(&lGPUstatusRet, GPUSTATUS_IDLE, __ATOMIC_RELEASE)
+
+#define GPUIsNotReadyForCommands __atomic_and_fetch(&lGPUstatusRet, ~GPUSTATUS_READYFORCOMMANDS, __ATOMIC_RELEASE)
+#define GPUIsReadyForCommands __atomic_or_fetch(&lGPUstatusRet, GPUSTATUS_READYFORCOMMANDS, __ATOMIC_RELEASE)
 
 #define __X11_C_
 //X11 render
 #define __inline inline
 #define CALLBACK
 
+// rasterizer state (draw area, texture page, vertex scratch...) is kept
+// per thread, so the tile workers can run soft.c side by side (tile.c)
+#define TLS __thread
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -165,20 +175,20 @@ extern char *         pCaptionText;
 
 extern int            iResX;
 extern int            iResY;
-extern int32_t           GlobalTextAddrX,GlobalTextAddrY,GlobalTextTP;
-extern int32_t           GlobalTextREST,GlobalTextABR,GlobalTextPAGE;
-extern short          ly0,lx0,ly1,lx1,ly2,lx2,ly3,lx3;
-extern long           lLowerpart;
+extern TLS int32_t           GlobalTextAddrX,GlobalTextAddrY,GlobalTextTP;
+extern TLS int32_t           GlobalTextREST,GlobalTextABR,GlobalTextPAGE;
+extern TLS short          ly0,lx0,ly1,lx1,ly2,lx2,ly3,lx3;
+extern TLS long           lLowerpart;
 extern BOOL           bIsFirstFrame;
 extern int            iWinSize;
-extern BOOL           bCheckMask;
-extern unsigned short sSetMask;
-extern unsigned long  lSetMask;
+extern TLS BOOL           bCheckMask;
+extern TLS unsigned short sSetMask;
+extern TLS unsigned long  lSetMask;
 extern BOOL           bDeviceOK;
-extern short          g_m1;
-extern short          g_m2;
-extern short          g_m3;
-extern short          DrawSemiTrans;
+extern TLS short          g_m1;
+extern TLS short          g_m2;
+extern TLS short          g_m3;
+extern TLS short          DrawSemiTrans;
 extern int            iUseGammaVal;
 extern int            iMaintainAspect;
 extern int            iDesktopCol;
@@ -197,22 +207,22 @@ extern unsigned short usCursorActive;
 
 #ifndef _IN_PRIMDRAW
 
-extern BOOL           bUsingTWin;
-extern TWin_t         TWin;
+extern TLS BOOL           bUsingTWin;
+extern TLS TWin_t         TWin;
 //extern unsigned long  clutid;
 extern void (*primTableJ[256])(unsigned char *);
 extern void (*primTableSkip[256])(unsigned char *);
-extern unsigned short  usMirror;
-extern int            iDither;
+extern TLS unsigned short  usMirror;
+extern TLS int            iDither;
 extern uint32_t  dwCfgFixes;
 extern uint32_t  dwActFixes;
 extern int            iUseFixes;
 extern int            iUseDither;
 extern BOOL           bDoVSyncUpdate;
-extern int32_t           drawX;
-extern int32_t           drawY;
-extern int32_t           drawW;
-extern int32_t           drawH;
+extern TLS int32_t           drawX;
+extern TLS int32_t           drawY;
+extern TLS int32_t           drawW;
+extern TLS int32_t           drawH;
 
 #endif
 
@@ -291,6 +301,71 @@ extern float          fps_cur;
 
 #endif
 
+// thread.c
+
+#ifndef _IN_THREAD
+
+extern int            iUseGPUThread;
+
+#endif
+
+// tile.c
+
+#ifndef _IN_TILE
+
+extern int            iTileThreads;
+extern TLS BOOL       bTileBand;
+
+#endif
+
+// span.c
+
+#ifndef _IN_SPAN
+
+extern int            iUseSpanKernels;
+
+#endif
+
+// capture.c
+
+#ifndef _IN_CAPTURE
+
+extern BOOL           bCapturing;
+
+#endif
+
+// dirty.c
+
+#ifndef _IN_DIRTY
+
+extern int            iUseDirtyRects;
+
+#endif
+
+// blit.c
+
+#ifndef _IN_BLIT
+
+extern int            iBlitKernels;
+
+#endif
+
+// filter.c
+
+#ifndef _IN_FILTER
+
+extern int            iFilterThreads;
+
+#endif
+
+// pace.c
+
+#ifndef _IN_PACE
+
+extern int            iFramePacing;
+
+#endif
+
 // cfg.c
 
 #ifndef _IN_CFG
@@ -306,7 +381,7 @@ extern char * pConfigFile;
 extern uint32_t dwGPUVersion;
 extern int           iGPUHeight;
 extern int           iGPUHeightMask;
-extern int           GlobalTextIL;
+extern TLS int       GlobalTextIL;
 extern int           iTileCheat;
 
 #endif
@@ -0,0 +1,159 @@
+/***************************************************************************
+                          filter.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// thread pool for the post filters (2xSaI, Scale2x/3x, hq2x/3x): the
+// frame is cut into bands of rows and every thread takes bands until
+// none are left. The filters read their source only and each band has
+// its own output rows, so the result is the same as in one go.
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_FILTER
+
+#include <pthread.h>
+
+#include "externals.h"
+#include "filter.h"
+
+#define MAXFILTERTHREADS 16
+#define MAXFILTERBANDS   32
+#define MINFILTERBAND    8                             // rows
+
+int iFilterThreads = 0;
+
+static pthread_t       thFilter[MAXFILTERTHREADS];
+static int             iFilterWorkers = 0;
+static pthread_mutex_t mtxFilter = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cndFilterGo = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  cndFilterDone = PTHREAD_COND_INITIALIZER;
+static int             iFilterGen = 0;
+static int             iFilterBusy = 0;
+static int             bFilterQuit = FALSE;
+static volatile int    iNextFilterBand;
+
+static struct                                          // the job of the current generation
+{
+ FILTERROWS      func;
+ unsigned char * srcPtr;
+ DWORD           srcPitch;
+ unsigned char * dstPtr;
+ int             width,height;
+ int             bands;
+} fj;
+
+static void FilterWork(void)
+{
+ int b;
+
+ while((b=__sync_fetch_and_add(&iNextFilterBand,1))<fj.bands)
+  fj.func(fj.srcPtr,fj.srcPitch,fj.dstPtr,fj.width,fj.height,
+          (fj.height*b)/fj.bands,(fj.height*(b+1))/fj.bands);
+}
+
+static void *FilterWorker(void *arg)
+{
+ int gen=0;                                            // FilterStart reset iFilterGen
+
+ pthread_mutex_lock(&mtxFilter);
+ for(;;)
+  {
+   while(gen==iFilterGen && !bFilterQuit)
+    pthread_cond_wait(&cndFilterGo,&mtxFilter);
+   if(bFilterQuit) break;
+   gen=iFilterGen;
+   pthread_mutex_unlock(&mtxFilter);
+
+   FilterWork();
+
+   pthread_mutex_lock(&mtxFilter);
+   if(--iFilterBusy==0) pthread_cond_signal(&cndFilterDone);
+  }
+ pthread_mutex_unlock(&mtxFilter);
+
+ return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void FilterBands(FILTERROWS func, unsigned char * srcPtr, DWORD srcPitch,
+                 unsigned char * dstPtr, int width, int height)
+{
+ int n=(iFilterWorkers+1)*2;                           // some spare bands for balancing
+
+ if(n>MAXFILTERBANDS)         n=MAXFILTERBANDS;
+ if(n>height/MINFILTERBAND)   n=height/MINFILTERBAND;
+
+ if(!iFilterWorkers || n<2)                            // no pool or tiny frame: here, in one go
+  {
+   func(srcPtr,srcPitch,dstPtr,width,height,0,height);
+   return;
+  }
+
+ fj.func=func;
+ fj.srcPtr=srcPtr;
+ fj.srcPitch=srcPitch;
+ fj.dstPtr=dstPtr;
+ fj.width=width;
+ fj.height=height;
+ fj.bands=n;
+
+ pthread_mutex_lock(&mtxFilter);
+ iNextFilterBand=0;
+ iFilterBusy=iFilterWorkers;
+ iFilterGen++;
+ pthread_cond_broadcast(&cndFilterGo);
+ pthread_mutex_unlock(&mtxFilter);
+
+ FilterWork();                                         // this thread takes bands too
+
+ pthread_mutex_lock(&mtxFilter);
+ while(iFilterBusy) pthread_cond_wait(&cndFilterDone,&mtxFilter);
+ pthread_mutex_unlock(&mtxFilter);
+}
+
+////////////////////////////////////////////////////////////////////////
+// pool
+////////////////////////////////////////////////////////////////////////
+
+void FilterStart(void)
+{
+ int i,n=iFilterThreads-1;                             // the display thread is one of them
+
+ if(iFilterWorkers) return;
+ if(n>MAXFILTERTHREADS) n=MAXFILTERTHREADS;
+
+ bFilterQuit=FALSE;
+ iFilterGen=0;
+ for(i=0;i<n;i++)
+  {
+   if(pthread_create(&thFilter[i],NULL,FilterWorker,NULL)!=0) break;
+   iFilterWorkers++;
+  }
+}
+
+void FilterStop(void)
+{
+ int i;
+
+ if(!iFilterWorkers) return;
+
+ pthread_mutex_lock(&mtxFilter);
+ bFilterQuit=TRUE;
+ pthread_cond_broadcast(&cndFilterGo);
+ pthread_mutex_unlock(&mtxFilter);
+
+ for(i=0;i<iFilterWorkers;i++) pthread_join(thFilter[i],NULL);
+ iFilterWorkers=0;
+}
@@ -0,0 +1,30 @@
+/***************************************************************************
+                          filter.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _FILTER_INTERNALS_H
+#define _FILTER_INTERNALS_H
+
+// one band of a post filter: source rows y0..y1-1 of a frame of height
+// rows. Bands only write their own output rows, but may read any row.
+
+typedef void (*FILTERROWS)(unsigned char * srcPtr, DWORD srcPitch, unsigned char * dstPtr,
+                           int width, int height, int y0, int y1);
+
+void FilterBands(FILTERROWS func, unsigned char * srcPtr, DWORD srcPitch,
+                 unsigned char * dstPtr, int width, int height);
+void FilterStart(void);
+void FilterStop(void);
+
+#endif // _FILTER_INTERNALS_H
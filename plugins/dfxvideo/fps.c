@@ -22,6 +22,7 @@
 #include "externals.h"
 #include "fps.h"
 #include "gpu.h"
+#include "pace.h"
 
 // FPS stuff
 float          fFrameRateHz=0;
@@ -57,6 +58,7 @@ void CheckFrameRate(void)
  else                                                  // non-skipping mode:
   {
    if(UseFrameLimit) FrameCap();                       // -> do it
+   else if(iFramePacing) PaceFrame(1,FALSE);           // -> or just measure
    if(ulKeybits&KEY_SHOWFPS) calcfps();                // -> and calc fps display
   }
 }
@@ -77,6 +79,12 @@ void FrameCap (void)
  int overslept=0, tickstogo=0;
  BOOL Waiting = TRUE;
 
+ if(iFramePacing)                                      // pace.c does it
+  {
+   PaceFrame(1,TRUE);
+   return;
+  }
+
   {
    curticks = timeGetTime();
    _ticks_since_last_update = curticks - lastticks;
@@ -126,6 +134,19 @@ void FrameSkip(void)
 
  if(!dwLaceCnt) return;                                // important: if no updatelace happened, we ignore it completely
 
+ if(iFramePacing)                                      // pace.c decides from the frame costs
+  {
+   if(bInitCap)                                        // -> first time, or FrameCap paced the laces
+    {
+     PaceResync();
+     bInitCap=FALSE;
+    }
+   PaceFrame(dwLaceCnt,UseFrameLimit);
+   bSkipNextFrame=PaceSkipNext();
+   dwLaceCnt=0;
+   return;
+  }
+
  if(iNumSkips)                                         // we are in skipping mode?
   {
    dwLastLace+=dwLaceCnt;                              // -> calc frame limit helper (number of laces)
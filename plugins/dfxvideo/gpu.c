@@ -32,6 +32,11 @@
 #include "key.h"
 #include "fps.h"
 #include "swap.h"
+#include "thread.h"
+#include "tile.h"
+#include "capture.h"
+#include "dirty.h"
+#include "pace.h"
 
 #ifdef ENABLE_NLS
 #include <libintl.h>
@@ -89,6 +94,7 @@ static uint32_t gpuDataM[256];
 static unsigned   char gpuCommand = 0;
 static long       gpuDataC = 0;
 static long       gpuDataP = 0;
+static volatile BOOL bResetDrawState = FALSE;
 
 VRAMLoad_t        VRAMWrite;
 VRAMLoad_t        VRAMRead;
@@ -249,6 +255,8 @@ void CALLBACK GPUmakeSnapshot(void)
  unsigned long snapshotnr = 0;
  unsigned char *pD;
 
+ GPUThreadSync();
+
  height = PreviousPSXDisplay.DisplayMode.y;
 
  size = height * PreviousPSXDisplay.Range.x1 * 3 + 0x38;
@@ -352,6 +360,7 @@ long CALLBACK GPUinit()                                // GPU INIT
 
  memset(psxVSecure,0x00,(iGPUHeight*2)*1024 + (1024*1024));
  memset(lGPUInfoVals,0x00,16*sizeof(uint32_t));
+ DirtyAll();
 
  SetFPSHandler();
 
@@ -402,12 +411,16 @@ long GPUopen(unsigned long * disp,char * CapText,char * CfgFile)
  ReadConfig();                                         // read registry
 
  InitFPS();
+ PaceInit();
 
  bIsFirstFrame  = TRUE;                                // we have to init later
  bDoVSyncUpdate = TRUE;
 
  d=ulInitDisplay();                                    // setup x
 
+ TileStart();                                          // band workers, if wanted
+ if(iUseGPUThread) GPUThreadStart();                   // rasterizer on its own thread?
+
  if(disp)
 	*disp=d;                                     // wanna x pointer? ok
 
@@ -422,6 +435,10 @@ long GPUopen(unsigned long * disp,char * CapText,char * CfgFile)
 
 long CALLBACK GPUclose()                               // GPU CLOSE
 {
+ GPUThreadStop();                                      // finish queued prims first
+ TileStop();
+ CaptureStop();
+ PaceReport();                                         // frame time p50/p99, if paced
 
  ReleaseKeyHandler();                                  // de-subclass window
 
@@ -445,6 +462,13 @@ long CALLBACK GPUshutdown()                            // GPU SHUTDOWN
 // Update display (swap buffers)
 ////////////////////////////////////////////////////////////////////////
 
+static void PresentFrame(void)                         // swap, timed for the frame pacing
+{
+ PacePresentStart();
+ DoBufferSwap();
+ PacePresentEnd();
+}
+
 void updateDisplay(void)                               // UPDATE DISPLAY
 {
  if(PSXDisplay.Disabled)                               // disable?
@@ -469,7 +493,7 @@ void updateDisplay(void)                               // UPDATE DISPLAY
   {
    static int fpscount; UseFrameSkip=1;
 
-   if(!bSkipNextFrame) DoBufferSwap();                 // -> to skip or not to skip
+   if(!bSkipNextFrame) PresentFrame();                 // -> to skip or not to skip
    if(fpscount%6)                                      // -> skip 6/7 frames
         bSkipNextFrame = TRUE;
    else bSkipNextFrame = FALSE;
@@ -480,7 +504,7 @@ void updateDisplay(void)                               // UPDATE DISPLAY
 
  if(UseFrameSkip)                                      // skip ?
   {
-   if(!bSkipNextFrame) DoBufferSwap();                 // -> to skip or not to skip
+   if(!bSkipNextFrame) PresentFrame();                 // -> to skip or not to skip
    if(dwActFixes&0xa0)                                 // -> pc fps calculation fix/old skipping fix
     {
      if((fps_skip < fFrameRateHz) && !(bSkipNextFrame))  // -> skip max one in a row
@@ -491,7 +515,7 @@ void updateDisplay(void)                               // UPDATE DISPLAY
   }
  else                                                  // no skip ?
   {
-   DoBufferSwap();                                     // -> swap
+   PresentFrame();                                     // -> swap
   }
 }
 
@@ -782,6 +806,10 @@ void CALLBACK GPUcursor(int iPlayer,int x,int y)
 
 void CALLBACK GPUupdateLace(void)                      // VSYNC
 {
+ GPUThreadSync();                                      // frame must be complete
+
+ CaptureVSync();                                       // frame mark, or start a pending capture
+
  if(!(dwActFixes&1))
   lGPUstatusRet^=0x80000000;                           // odd/even bit
 
@@ -822,6 +850,13 @@ void CALLBACK GPUupdateLace(void)                      // VSYNC
 
 uint32_t CALLBACK GPUreadStatus(void)             // READ STATUS
 {
+ if(GPUThreadBusy())                                   // worker still drawing?
+  {
+   if(!(dwActFixes&1))                                 // -> report busy, don't wait
+    return GPUStatusGet()&~GPUSTATUS_IDLE;
+   GPUThreadSync();                                    // -> toggle below needs exclusive status
+  }
+
  if(dwActFixes&1)
   {
    static int iNumRead=0;                              // odd/even hack
@@ -832,7 +867,22 @@ uint32_t CALLBACK GPUreadStatus(void)             // READ STATUS
     }
   }
 
- return lGPUstatusRet;
+ return GPUStatusGet();
+}
+
+////////////////////////////////////////////////////////////////////////
+// drawing part of a gpu reset. The rasterizer state is per thread, so
+// with the gpu thread this is left to DoWriteDataMem
+////////////////////////////////////////////////////////////////////////
+
+static void ResetDrawState(void)
+{
+ drawX=drawY=0;drawW=drawH=0;
+ sSetMask=0;lSetMask=0;bCheckMask=FALSE;
+ usMirror=0;
+ GlobalTextAddrX=0;GlobalTextAddrY=0;
+ GlobalTextTP=0;GlobalTextABR=0;
+ bUsingTWin = FALSE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -844,6 +894,10 @@ void CALLBACK GPUwriteStatus(uint32_t gdata)      // WRITE STATUS
 {
  uint32_t lCommand=(gdata>>24)&0xff;
 
+ GPUThreadSync();                                      // GP1 runs in order, on this thread
+
+ if(bCapturing) CaptureStatus(gdata);
+
  ulStatusControl[lCommand]=gdata;                      // store command for freezing
 
  switch(lCommand)
@@ -856,14 +910,10 @@ void CALLBACK GPUwriteStatus(uint32_t gdata)      // WRITE STATUS
     PSXDisplay.Disabled=1;
     DataWriteMode=DataReadMode=DR_NORMAL;
     PSXDisplay.DrawOffset.x=PSXDisplay.DrawOffset.y=0;
-    drawX=drawY=0;drawW=drawH=0;
-    sSetMask=0;lSetMask=0;bCheckMask=FALSE;
-    usMirror=0;
-    GlobalTextAddrX=0;GlobalTextAddrY=0;
-    GlobalTextTP=0;GlobalTextABR=0;
+    if(iUseGPUThread) bResetDrawState=TRUE;            // state belongs to the gpu thread
+    else              ResetDrawState();
     PSXDisplay.RGB24=FALSE;
     PSXDisplay.Interlaced=FALSE;
-    bUsingTWin = FALSE;
     return;
    //--------------------------------------------------//
    // dis/enable display 
@@ -1125,13 +1175,54 @@ __inline void FinishedVRAMRead(void)
  lGPUstatusRet&=~GPUSTATUS_READYFORVRAM;
 }
 
+// n pixels of a transfer row: the data words are a stream of le 16 bit
+// pixels, so a row is one memcpy. Only a run that crosses the end of
+// vram goes pixel by pixel, the pointer wraps there like it always did.
+
+static __inline void VRAMWriteRun(unsigned short * src, int n)
+{
+ if(VRAMWrite.ImagePtr+n<=psxVuw_eom)
+  {
+   memcpy(VRAMWrite.ImagePtr,src,n*2);
+   VRAMWrite.ImagePtr+=n;
+   if(VRAMWrite.ImagePtr>=psxVuw_eom) VRAMWrite.ImagePtr-=iGPUHeight*1024;
+   return;
+  }
+ while(n--)
+  {
+   *VRAMWrite.ImagePtr++=*src++;
+   if(VRAMWrite.ImagePtr>=psxVuw_eom) VRAMWrite.ImagePtr-=iGPUHeight*1024;
+  }
+}
+
+static __inline void VRAMReadRun(unsigned short * dst, int n)
+{
+ if(VRAMRead.ImagePtr+n<=psxVuw_eom)
+  {
+   memcpy(dst,VRAMRead.ImagePtr,n*2);
+   VRAMRead.ImagePtr+=n;
+   if(VRAMRead.ImagePtr>=psxVuw_eom) VRAMRead.ImagePtr-=iGPUHeight*1024;
+   return;
+  }
+ while(n--)
+  {
+   *dst++=*VRAMRead.ImagePtr++;
+   if(VRAMRead.ImagePtr>=psxVuw_eom) VRAMRead.ImagePtr-=iGPUHeight*1024;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////
 // core read from vram
 ////////////////////////////////////////////////////////////////////////
 
 void CALLBACK GPUreadDataMem(uint32_t * pMem, int iSize)
 {
- int i;
+ unsigned short * dst=(unsigned short *)pMem;          // the words as le pixel pairs
+ int n,left=iSize*2;
+
+ GPUThreadSync();                                      // vram readback: wait for pending prims
+
+ if(bCapturing) CaptureRead(iSize);
 
  if(DataReadMode!=DR_VRAMTRANSFER) return;
 
@@ -1143,49 +1234,36 @@ void CALLBACK GPUreadDataMem(uint32_t * pMem, int iSize)
  while(VRAMRead.ImagePtr<psxVuw)
   VRAMRead.ImagePtr+=iGPUHeight*1024;
 
- for(i=0;i<iSize;i++)
+ if(iSize<=0) goto ENDREAD;
+ if(VRAMRead.ColsRemaining<=0 || VRAMRead.RowsRemaining<=0)
+  {FinishedVRAMRead();goto ENDREAD;}
+
+ while(left>0 && VRAMRead.ColsRemaining>0)             // row by row
   {
-   // do 2 seperate 16bit reads for compatibility (wrap issues)
-   if ((VRAMRead.ColsRemaining > 0) && (VRAMRead.RowsRemaining > 0))
+   n=VRAMRead.RowsRemaining;
+   if(n>left) n=left;
+   VRAMReadRun(dst,n);
+   dst+=n;
+   left-=n;
+   VRAMRead.RowsRemaining-=n;
+
+   if(VRAMRead.RowsRemaining<=0)
     {
-     // lower 16 bit
-     lGPUdataRet=(uint32_t)GETLE16(VRAMRead.ImagePtr);
-
-     VRAMRead.ImagePtr++;
-     if(VRAMRead.ImagePtr>=psxVuw_eom) VRAMRead.ImagePtr-=iGPUHeight*1024;
-     VRAMRead.RowsRemaining --;
-
-     if(VRAMRead.RowsRemaining<=0)
-      {
-       VRAMRead.RowsRemaining = VRAMRead.Width;
-       VRAMRead.ColsRemaining--;
-       VRAMRead.ImagePtr += 1024 - VRAMRead.Width;
-       if(VRAMRead.ImagePtr>=psxVuw_eom) VRAMRead.ImagePtr-=iGPUHeight*1024;
-      }
-
-     // higher 16 bit (always, even if it's an odd width)
-     lGPUdataRet|=(uint32_t)GETLE16(VRAMRead.ImagePtr)<<16;
-     PUTLE32(pMem, lGPUdataRet); pMem++;
-
-     if(VRAMRead.ColsRemaining <= 0)
-      {FinishedVRAMRead();goto ENDREAD;}
-
-     VRAMRead.ImagePtr++;
+     VRAMRead.RowsRemaining = VRAMRead.Width;
+     VRAMRead.ColsRemaining--;
+     VRAMRead.ImagePtr += 1024 - VRAMRead.Width;
      if(VRAMRead.ImagePtr>=psxVuw_eom) VRAMRead.ImagePtr-=iGPUHeight*1024;
-     VRAMRead.RowsRemaining--;
-     if(VRAMRead.RowsRemaining<=0)
-      {
-       VRAMRead.RowsRemaining = VRAMRead.Width;
-       VRAMRead.ColsRemaining--;
-       VRAMRead.ImagePtr += 1024 - VRAMRead.Width;
-       if(VRAMRead.ImagePtr>=psxVuw_eom) VRAMRead.ImagePtr-=iGPUHeight*1024;
-      }
-     if(VRAMRead.ColsRemaining <= 0)
-      {FinishedVRAMRead();goto ENDREAD;}
     }
-   else {FinishedVRAMRead();goto ENDREAD;}
   }
 
+ if(VRAMRead.ColsRemaining<=0)
+  {
+   if(left&1) {*dst++=*VRAMRead.ImagePtr;left--;}     // odd count: the high half is the next pixel, as ever
+   FinishedVRAMRead();
+  }
+
+ if(left<iSize*2) lGPUdataRet=GETLE32((uint32_t *)dst-1);
+
 ENDREAD:
  GPUIsIdle;
 }
@@ -1275,11 +1353,18 @@ const unsigned char primTableCX[256] =
     0,0,0,0,0,0,0,0
 };
 
-void CALLBACK GPUwriteDataMem(uint32_t * pMem, int iSize)
+void DoWriteDataMem(uint32_t * pMem, int iSize)
 {
  unsigned char command;
  uint32_t gdata=0;
  int i=0;
+
+ if(bResetDrawState)                                   // gp1 reset from the emu thread
+  {
+   TileFlush();
+   ResetDrawState();
+   bResetDrawState=FALSE;
+  }
  GPUIsBusy;
  GPUIsNotReadyForCommands;
 
@@ -1288,6 +1373,8 @@ STARTVRAM:
  if(DataWriteMode==DR_VRAMTRANSFER)
   {
    BOOL bFinished=FALSE;
+   unsigned short * src;                               // the words as le pixel pairs
+   int n,left;
 
    // make sure we are in vram
    while(VRAMWrite.ImagePtr>=psxVuw_eom)
@@ -1295,45 +1382,38 @@ STARTVRAM:
    while(VRAMWrite.ImagePtr<psxVuw)
     VRAMWrite.ImagePtr+=iGPUHeight*1024;
 
-   // now do the loop
+   // now do the rows
+   src=(unsigned short *)pMem;
+   left=(iSize-i)*2;
    while(VRAMWrite.ColsRemaining>0)
     {
-     while(VRAMWrite.RowsRemaining>0)
+     if(VRAMWrite.RowsRemaining>0)
       {
-       if(i>=iSize) {goto ENDVRAM;}
-       i++;
-
-       gdata=GETLE32(pMem); pMem++;
-
-       PUTLE16(VRAMWrite.ImagePtr, (unsigned short)gdata); VRAMWrite.ImagePtr++;
-       if(VRAMWrite.ImagePtr>=psxVuw_eom) VRAMWrite.ImagePtr-=iGPUHeight*1024;
-       VRAMWrite.RowsRemaining --;
-
-       if(VRAMWrite.RowsRemaining <= 0)
-        {
-         VRAMWrite.ColsRemaining--;
-         if (VRAMWrite.ColsRemaining <= 0)             // last pixel is odd width
-          {
-           gdata=(gdata&0xFFFF)|(((uint32_t)GETLE16(VRAMWrite.ImagePtr))<<16);
-           FinishedVRAMWrite();
-           bDoVSyncUpdate=TRUE;
-           goto ENDVRAM;
-          }
-         VRAMWrite.RowsRemaining = VRAMWrite.Width;
-         VRAMWrite.ImagePtr += 1024 - VRAMWrite.Width;
-        }
-
-       PUTLE16(VRAMWrite.ImagePtr, (unsigned short)(gdata>>16)); VRAMWrite.ImagePtr++;
-       if(VRAMWrite.ImagePtr>=psxVuw_eom) VRAMWrite.ImagePtr-=iGPUHeight*1024;
-       VRAMWrite.RowsRemaining --;
+       if(!left) break;
+       n=VRAMWrite.RowsRemaining;
+       if(n>left) n=left;
+       VRAMWriteRun(src,n);
+       src+=n;
+       left-=n;
+       VRAMWrite.RowsRemaining-=n;
+       if(VRAMWrite.RowsRemaining>0) break;             // out of data mid row
       }
 
      VRAMWrite.RowsRemaining = VRAMWrite.Width;
      VRAMWrite.ColsRemaining--;
      VRAMWrite.ImagePtr += 1024 - VRAMWrite.Width;
+     if(VRAMWrite.ImagePtr>=psxVuw_eom) VRAMWrite.ImagePtr-=iGPUHeight*1024;
      bFinished=TRUE;
     }
 
+   n=(iSize-i)*2-left;                                 // pixels used, an odd last one takes a whole word
+   pMem+=(n+1)>>1;
+   i+=(n+1)>>1;
+   if(n) gdata=GETLE32(pMem-1);                        // lGPUdataRet, as before
+
+   if(VRAMWrite.ColsRemaining>0) goto ENDVRAM;         // more to come
+
+   if(n&1) gdata=(gdata&0xFFFF)|(((uint32_t)GETLE16(VRAMWrite.ImagePtr))<<16);
    FinishedVRAMWrite();
    if(bFinished) bDoVSyncUpdate=TRUE;
   }
@@ -1385,7 +1465,9 @@ ENDVRAM:
      if(gpuDataP == gpuDataC)
       {
        gpuDataC=gpuDataP=0;
-       primFunc[gpuCommand]((unsigned char *)gpuDataM);
+       DirtyPrim(gpuCommand,gpuDataM);
+       if(!TileQueue(gpuCommand,gpuDataM,primFunc))    // binned for the tile workers?
+        primFunc[gpuCommand]((unsigned char *)gpuDataM);
       }
     } 
   }
@@ -1398,6 +1480,16 @@ ENDVRAM:
 
 ////////////////////////////////////////////////////////////////////////
 
+void CALLBACK GPUwriteDataMem(uint32_t * pMem, int iSize)
+{
+ if(bCapturing) CaptureData(CAP_DATA,pMem,iSize);
+
+ GPUThreadPush(pMem,iSize);                            // queued, or executed right away
+ if(!iUseGPUThread) TileFlush();                       // single thread: draw binned prims now
+}
+
+////////////////////////////////////////////////////////////////////////
+
 void CALLBACK GPUwriteData(uint32_t gdata)
 {
  PUTLE32(&gdata, gdata);
@@ -1419,6 +1511,8 @@ long CALLBACK GPUgetMode(void)
 {
  long iT=0;
 
+ GPUThreadSync();
+
  if(DataWriteMode==DR_VRAMTRANSFER) iT|=0x1;
  if(DataReadMode ==DR_VRAMTRANSFER) iT|=0x2;
  return iT;
@@ -1449,48 +1543,61 @@ void SetFixes(void)
 // process gpu commands
 ////////////////////////////////////////////////////////////////////////
 
-unsigned long lUsedAddr[3];
+// the chain walk: a visited bit per ram word finds loops exactly (a
+// node seen twice ends the walk), and only the bitmap words that were
+// set get cleared again afterwards. The packets of consecutive nodes
+// are sent as one run, the data port doesn't care where they split.
 
-__inline BOOL CheckForEndlessLoop(unsigned long laddr)
-{
- if(laddr==lUsedAddr[1]) return TRUE;
- if(laddr==lUsedAddr[2]) return TRUE;
+#define CHAINNODES (0x1000000>>2)                      // 24 bit addresses (zn), psx ram is 2 MB of it
+#define CHAINRUN   4096                                // words sent at once
+
+static uint32_t ulChainVisited[CHAINNODES>>5];
+static uint32_t ulChainTouched[CHAINNODES>>5];         // the bitmap words to clear
+static uint32_t ulChainRun[CHAINRUN];
 
- if(laddr<lUsedAddr[0]) lUsedAddr[1]=laddr;
- else                   lUsedAddr[2]=laddr;
- lUsedAddr[0]=laddr;
- return FALSE;
+static void ChainSend(int iSize)
+{
+ if(bCapturing) CaptureData(CAP_DMA,ulChainRun,iSize);
+ GPUThreadPush(ulChainRun,iSize);
 }
 
 long CALLBACK GPUdmaChain(uint32_t * baseAddrL, uint32_t addr)
 {
- uint32_t dmaMem;
  unsigned char * baseAddrB;
- short count;unsigned int DMACommandCounter = 0;
-
- GPUIsBusy;
+ uint32_t addrMask, bit, * v;
+ int count, iRun = 0, iTouched = 0;
 
- lUsedAddr[0]=lUsedAddr[1]=lUsedAddr[2]=0xffffff;
+ if(!iUseGPUThread) GPUIsBusy;                         // threaded: status belongs to the worker
 
  baseAddrB = (unsigned char*) baseAddrL;
+ addrMask = (iGPUHeight==512) ? 0x1FFFFC : 0xFFFFFF;
 
- do
+ while(addr != 0xffffff)
   {
-   if(iGPUHeight==512) addr&=0x1FFFFC;
-   if(DMACommandCounter++ > 2000000) break;
-   if(CheckForEndlessLoop(addr)) break;
-
-   count = baseAddrB[addr+3];
+   addr &= addrMask;
 
-   dmaMem=addr+4;
+   v = &ulChainVisited[addr>>7];                       // seen it before? endless loop, done
+   bit = 1u << ((addr>>2)&31);
+   if(*v & bit) break;
+   if(!*v) ulChainTouched[iTouched++] = addr>>7;
+   *v |= bit;
 
-   if(count>0) GPUwriteDataMem(&baseAddrL[dmaMem>>2],count);
+   count = baseAddrB[addr+3];
+   if(count)                                           // most ot entries are empty links
+    {
+     if(iRun+count > CHAINRUN) {ChainSend(iRun);iRun=0;}
+     memcpy(&ulChainRun[iRun],&baseAddrL[(addr+4)>>2],count*4);
+     iRun += count;
+    }
 
    addr = GETLE32(&baseAddrL[addr>>2])&0xffffff;
   }
- while (addr != 0xffffff);
 
- GPUIsIdle;
+ if(iRun) ChainSend(iRun);
+
+ while(iTouched) ulChainVisited[ulChainTouched[--iTouched]] = 0;
+
+ if(!iUseGPUThread) {TileFlush();GPUIsIdle;}
 
  return 0;
 }
@@ -1547,6 +1654,8 @@ long CALLBACK GPUfreeze(uint32_t ulGetFreezeData,GPUFreeze_t * pF)
  if(!pF)                    return 0;                  // some checks
  if(pF->ulFreezeVersion!=1) return 0;
 
+ GPUThreadSync();
+
  if(ulGetFreezeData==1)                                // 1: get data
   {
    pF->ulStatus=lGPUstatusRet;
@@ -1561,6 +1670,7 @@ long CALLBACK GPUfreeze(uint32_t ulGetFreezeData,GPUFreeze_t * pF)
  lGPUstatusRet=pF->ulStatus;
  memcpy(ulStatusControl,pF->ulControl,256*sizeof(uint32_t));
  memcpy(psxVub,         pF->psxVRam,  1024*iGPUHeight*2);
+ DirtyAll();
 
 // RESET TEXTURE STORE HERE, IF YOU USE SOMETHING LIKE THAT
 
@@ -1574,6 +1684,8 @@ long CALLBACK GPUfreeze(uint32_t ulGetFreezeData,GPUFreeze_t * pF)
  GPUwriteStatus(ulStatusControl[5]);
  GPUwriteStatus(ulStatusControl[4]);
 
+ if(bCapturing) CaptureState();                        // vram changed behind the data port
+
  return 1;
 }
 
@@ -1844,6 +1956,7 @@ extern char * Xpixels;
 
 void GPUgetScreenPic(unsigned char * pMem)
 {
+ GPUThreadSync();
 /*
  unsigned short c;unsigned char * pf;int x,y;
 
@@ -54,6 +54,7 @@
 void           updateDisplay(void);
 void           SetAutoFrameCap(void);
 void           SetFixes(void);
+void           DoWriteDataMem(uint32_t * pMem, int iSize);
 
 /////////////////////////////////////////////////////////////////////////////
 
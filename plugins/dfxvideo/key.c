@@ -22,6 +22,7 @@
 #include "gpu.h"
 #include "draw.h"
 #include "key.h"
+#include "capture.h"
 
 #define VK_INSERT      65379
 #define VK_HOME        65360
@@ -30,6 +31,7 @@
 #define VK_END         65367
 #define VK_DEL         65535
 #define VK_F5          65474
+#define VK_F11         65480
 
 void GPUmakeSnapshot(void);
 
@@ -47,6 +49,10 @@ void GPUkeypressed(int keycode)
        GPUmakeSnapshot();
       break;
 
+   case VK_F11:
+       CaptureToggle();
+      break;
+
    case VK_INSERT:
        if(iUseFixes) {iUseFixes=0;dwActFixes=0;}
        else          {iUseFixes=1;dwActFixes=dwCfgFixes;}
@@ -0,0 +1,255 @@
+/***************************************************************************
+                          pace.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// frame pacing: fps.c calls PaceFrame at every frame boundary (each
+// vsync without skipping, each shown or skipped frame with it). The
+// boundaries follow a deadline that moves on by the psx frame time,
+// they are waited for with an absolute clock_nanosleep plus a short
+// spin, so a late frame doesn't push all later ones back. The time
+// between two boundaries is split into emulation and present
+// (DoBufferSwap), and all three go into histograms for the p50/p99.
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_PACE
+
+#include <time.h>
+#include <errno.h>
+
+#include "externals.h"
+#include "pace.h"
+
+#define PACEBUCKET   50000                             // ns per histogram bucket
+#define PACEBUCKETS  2000                              // up to 100 ms, longer ones go into the last
+#define PACEWINDOW   32                                // shown frames the skip decision looks at
+#define PACEPERCENT  75                                // and the percentile of their cost it plans with
+#define PACEMAXSKIP  8                                 // skipped in a row, then one is shown anyway
+#define PACEMAXLATE  4                                 // frames behind, then we stop catching up
+#define PACESPINMIN  50000                             // ns the sleep ends early, for the spin
+#define PACESPINMAX  2000000
+
+typedef long long PACETIME;                            // ns
+
+int iFramePacing = 1;
+
+static PACETIME      llLast = 0;                       // last boundary, 0 = none yet
+static PACETIME      llDeadline;                       // when the last boundary was due
+static PACETIME      llPresent = 0;                    // present time since llLast
+static PACETIME      llPresentStart;
+static PACETIME      llSpin = 1000000;
+static PACETIME      llCost[PACEWINDOW];               // shown frames, per lace
+static int           iCosts = 0, iNextCost = 0;
+static int           iSkips = 0;                       // skipped in a row
+static BOOL          bPaceSkip = FALSE;
+static unsigned long ulHist[PACE_HISTS][PACEBUCKETS];
+static unsigned long ulFrames = 0, ulSkipped = 0;
+
+static PACETIME PaceNow(void)
+{
+ struct timespec ts;
+
+ clock_gettime(CLOCK_MONOTONIC, &ts);
+ return (PACETIME)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void PaceHist(int iHist, PACETIME t)
+{
+ PACETIME b = t / PACEBUCKET;
+
+ if(b < 0) b = 0;
+ if(b >= PACEBUCKETS) b = PACEBUCKETS - 1;
+ ulHist[iHist][b]++;
+}
+
+static float PacePercentile(int iHist, int iPercent)   // ms, middle of the bucket
+{
+ unsigned long n = 0, want;
+ int b;
+
+ for(b = 0; b < PACEBUCKETS; b++) n += ulHist[iHist][b];
+ if(!n) return 0.0f;
+
+ want = (n * iPercent + 99) / 100;
+ for(b = 0, n = 0; b < PACEBUCKETS - 1; b++)
+  {
+   n += ulHist[iHist][b];
+   if(n >= want) break;
+  }
+ return ((float)b + 0.5f) * PACEBUCKET / 1000000.0f;
+}
+
+// PACEPERCENT of the shown frames of the window cost at most this much,
+// per lace
+static PACETIME PaceCost(void)
+{
+ PACETIME c[PACEWINDOW], t;
+ int i, j;
+
+ if(!iCosts) return 0;
+
+ for(i = 0; i < iCosts; i++)                           // insertion sort, it's 32 at most
+  {
+   t = llCost[i];
+   for(j = i; j > 0 && c[j - 1] > t; j--) c[j] = c[j - 1];
+   c[j] = t;
+  }
+ return c[(iCosts - 1) * PACEPERCENT / 100];
+}
+
+// clock_nanosleep wakes up late by about a scheduler tick, so it sleeps
+// until a bit before t and the rest is spun. That bit follows twice the
+// oversleep of the last sleeps.
+static void PaceWait(PACETIME t)
+{
+ struct timespec ts;
+ PACETIME wake, now;
+
+ if(!(dwActFixes&16))                                  // 'no sleep' fix: spin all of it
+  {
+   wake = t - llSpin;
+   if(wake > PaceNow())
+    {
+     ts.tv_sec = wake / 1000000000;
+     ts.tv_nsec = wake % 1000000000;
+     while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) ;
+
+     now = PaceNow();
+     llSpin += ((now - wake) * 2 - llSpin) / 8;
+     if(llSpin < PACESPINMIN) llSpin = PACESPINMIN;
+     if(llSpin > PACESPINMAX) llSpin = PACESPINMAX;
+    }
+  }
+
+ while(PaceNow() < t) ;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void PaceInit(void)
+{
+ memset(ulHist, 0, sizeof(ulHist));
+ ulFrames = ulSkipped = 0;
+ iCosts = iNextCost = 0;
+ llSpin = 1000000;
+ PaceResync();
+}
+
+void PaceResync(void)                                  // next boundary starts a new timeline
+{
+ llLast = 0;
+ llPresent = 0;
+ iSkips = 0;
+ bPaceSkip = FALSE;
+}
+
+// a frame of iLaces vsyncs ended (bSkipNextFrame tells if it was
+// skipped): count it, wait for its deadline if bLimit, and decide about
+// the next one
+void PaceFrame(int iLaces, BOOL bLimit)
+{
+ PACETIME now = PaceNow(), period, busy, late;
+
+ if(iLaces < 1) iLaces = 1;
+ period = (PACETIME)(1000000000.0 / (fFrameRateHz > 0 ? fFrameRateHz : 60.0f));
+
+ if(!llLast)                                           // first one, the timeline starts here
+  {
+   llLast = llDeadline = now;
+   llPresent = 0;
+   return;
+  }
+
+ busy = now - llLast;
+ PaceHist(PACE_EMU, busy - llPresent);
+ if(llPresent) PaceHist(PACE_PRESENT, llPresent);
+ ulFrames++;
+ if(bSkipNextFrame) ulSkipped++;
+ else                                                  // shown: that's what the skip decision plans with
+  {
+   llCost[iNextCost] = busy / iLaces;
+   iNextCost = (iNextCost + 1) % PACEWINDOW;
+   if(iCosts < PACEWINDOW) iCosts++;
+  }
+
+ llDeadline += iLaces * period;
+ late = now - llDeadline;
+ if(late > PACEMAXLATE * period)                       // way behind (loading, debugger...): don't rush to catch up
+  llDeadline = now;
+ else if(late < 0)
+  {
+   if(bLimit) PaceWait(llDeadline);
+   else       llDeadline = now;                        // no limit, being early is nothing to bank on
+  }
+
+ now = PaceNow();
+ PaceHist(PACE_FRAME, now - llLast);
+ llLast = now;
+ llPresent = 0;
+
+ // skip the next frame only if we are behind, and showing it would
+ // still end past its deadline; the skipped ones then catch up
+ late = now - llDeadline;
+ bPaceSkip = late > period / 8 &&
+             late + PaceCost() * iLaces > iLaces * period &&
+             iSkips < PACEMAXSKIP;
+ if(bPaceSkip) iSkips++;
+ else          iSkips = 0;
+}
+
+BOOL PaceSkipNext(void)
+{
+ return bPaceSkip;
+}
+
+void PacePresentStart(void)
+{
+ llPresentStart = PaceNow();
+}
+
+void PacePresentEnd(void)
+{
+ llPresent += PaceNow() - llPresentStart;
+}
+
+////////////////////////////////////////////////////////////////////////
+// stats
+////////////////////////////////////////////////////////////////////////
+
+void PaceStats(PACESTATS * pS)
+{
+ int i;
+
+ pS->ulFrames = ulFrames;
+ pS->ulSkipped = ulSkipped;
+ for(i = 0; i < PACE_HISTS; i++)
+  {
+   pS->fP50[i] = PacePercentile(i, 50);
+   pS->fP99[i] = PacePercentile(i, 99);
+  }
+}
+
+void PaceReport(void)
+{
+ PACESTATS s;
+
+ if(!iFramePacing || !ulFrames) return;
+
+ PaceStats(&s);
+ printf("dfxvideo: %lu frames, %lu skipped, p50/p99 ms: frame %.2f/%.2f, emulation %.2f/%.2f, present %.2f/%.2f\n",
+        s.ulFrames, s.ulSkipped,
+        s.fP50[PACE_FRAME], s.fP99[PACE_FRAME],
+        s.fP50[PACE_EMU], s.fP99[PACE_EMU],
+        s.fP50[PACE_PRESENT], s.fP99[PACE_PRESENT]);
+}
@@ -0,0 +1,44 @@
+/***************************************************************************
+                          pace.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _PACE_INTERNALS_H
+#define _PACE_INTERNALS_H
+
+enum
+{
+ PACE_FRAME,                                           // frame boundary to frame boundary, the jitter
+ PACE_EMU,                                             // emulation between two boundaries, present not counted
+ PACE_PRESENT,                                         // DoBufferSwap
+ PACE_HISTS
+};
+
+typedef struct
+{
+ unsigned long ulFrames;                               // boundaries counted
+ unsigned long ulSkipped;                              // of these, frames that were skipped
+ float         fP50[PACE_HISTS];                       // ms
+ float         fP99[PACE_HISTS];
+} PACESTATS;
+
+void PaceInit(void);
+void PaceResync(void);
+void PaceFrame(int iLaces, BOOL bLimit);
+void PacePresentStart(void);
+void PacePresentEnd(void);
+BOOL PaceSkipNext(void);
+void PaceStats(PACESTATS * pS);
+void PaceReport(void);
+
+#endif // _PACE_INTERNALS_H
@@ -22,20 +22,21 @@
 #include "draw.h"
 #include "soft.h"
 #include "swap.h"
+#include "dirty.h"
 
 ////////////////////////////////////////////////////////////////////////
 // globals
 ////////////////////////////////////////////////////////////////////////
 
-BOOL           bUsingTWin=FALSE;
-TWin_t         TWin;
+TLS BOOL       bUsingTWin=FALSE;
+TLS TWin_t     TWin;
 //unsigned long  clutid;                                 // global clut
-unsigned short usMirror=0;                             // sprite mirror
-int            iDither=0;
-int32_t           drawX;
-int32_t           drawY;
-int32_t           drawW;
-int32_t           drawH;
+TLS unsigned short usMirror=0;                         // sprite mirror
+TLS int        iDither=0;
+TLS int32_t       drawX;
+TLS int32_t       drawY;
+TLS int32_t       drawW;
+TLS int32_t       drawH;
 uint32_t  dwCfgFixes;
 uint32_t  dwActFixes=0;
 int            iUseFixes;
@@ -78,7 +79,8 @@ __inline void UpdateGlobalTP(unsigned short gdata)
      GlobalTextTP = (gdata >> 9) & 0x3;
      if(GlobalTextTP==3) GlobalTextTP=2;
      usMirror =0;
-     lGPUstatusRet = (lGPUstatusRet & 0xffffe000 ) | (gdata & 0x1fff );
+     if(!bTileBand)                                    // (tile bands: the serial pass does it)
+      GPUStatusSet((GPUStatusGet() & 0xffffe000 ) | (gdata & 0x1fff ));
 
      // tekken dithering? right now only if dithering is forced by user
      if(iUseDither==2) iDither=2; else iDither=0;
@@ -109,8 +111,15 @@ __inline void UpdateGlobalTP(unsigned short gdata)
 
  GlobalTextABR = (gdata >> 5) & 0x3;                   // blend mode
 
- lGPUstatusRet&=~0x07ff;                               // Clear the necessary bits
- lGPUstatusRet|=(gdata & 0x07ff);                      // set the necessary bits
+ if(!bTileBand)                                        // (tile bands: the serial pass does it)
+  GPUStatusSet((GPUStatusGet()&~0x07ff)|(gdata & 0x07ff)); // one store: no half done status
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void primTexPage(unsigned short gdata)                 // tile.c: tpage of a poly outside the band
+{
+ UpdateGlobalTP(gdata);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -363,8 +372,8 @@ void cmdSTP(unsigned char * baseAddr)
 {
  uint32_t gdata = GETLE32(&((uint32_t*)baseAddr)[0]);
 
- lGPUstatusRet&=~0x1800;                                   // Clear the necessary bits
- lGPUstatusRet|=((gdata & 0x03) << 11);                    // Set the necessary bits
+ if(!bTileBand)                                            // (tile bands: the serial pass does it)
+  GPUStatusSet((GPUStatusGet()&~0x1800)|((gdata & 0x03) << 11)); // one store: no half done status
 
  if(gdata&1) {sSetMask=0x8000;lSetMask=0x80008000;}
  else        {sSetMask=0;     lSetMask=0;         }
@@ -395,7 +404,7 @@ void cmdTextureWindow(unsigned char *baseAddr)
 
  uint32_t YAlign,XAlign;
 
- lGPUInfoVals[INFO_TW]=gdata&0xFFFFF;
+ if(!bTileBand) lGPUInfoVals[INFO_TW]=gdata&0xFFFFF;
 
  if(gdata & 0x020)
   TWin.Position.y1 = 8;    // xxxx1
@@ -539,6 +548,10 @@ void primLoadImage(unsigned char * baseAddr)
  VRAMWrite.Width  = GETLEs16(&sgpuData[4]);
  VRAMWrite.Height = GETLEs16(&sgpuData[5]);
 
+ DirtyRect(VRAMWrite.x, VRAMWrite.y,                   // rows running past x 1023 spill
+           VRAMWrite.x + VRAMWrite.Width - 1,          // into the next line
+           VRAMWrite.y + VRAMWrite.Height - ((VRAMWrite.x + VRAMWrite.Width > 1024) ? 0 : 1));
+
  DataWriteMode = DR_VRAMTRANSFER;
 
  VRAMWrite.ImagePtr = psxVuw + (VRAMWrite.y<<10) + VRAMWrite.x;
@@ -565,7 +578,7 @@ void primStoreImage(unsigned char * baseAddr)
 
  DataReadMode = DR_VRAMTRANSFER;
 
- lGPUstatusRet |= GPUSTATUS_READYFORVRAM;
+ __atomic_or_fetch(&lGPUstatusRet, GPUSTATUS_READYFORVRAM, __ATOMIC_RELEASE);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -592,9 +605,11 @@ void primBlkFill(unsigned char * baseAddr)
  sW+=sX;
  sH+=sY;
 
+ DirtyRect(sX, sY, sW - 1, sH - 1);
+
  FillSoftwareArea(sX, sY, sW, sH, BGR24to16(GETLE32(&gpuData[0])));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
  
 ////////////////////////////////////////////////////////////////////////
@@ -632,6 +647,23 @@ void primMoveImage(unsigned char * baseAddr)
 
  if(iGPUHeight==1024 && GETLEs16(&sgpuData[7])>1024) return;
 
+ DirtyRect(imageX1, imageY1, imageX1 + imageSX - 1, imageY1 + imageSY - 1);
+
+ // rows that don't wrap at x 1024 are copied whole, y may wrap. Not
+ // when a row moves right onto itself: the old forward copy smears it,
+ // and that stays with the loops below.
+ if((imageX0+imageSX)<=1024 && (imageX1+imageSX)<=1024 &&
+    !(imageY0==imageY1 && imageX1>imageX0 && imageX1<imageX0+imageSX))
+  {
+   for(j=0;j<imageSY;j++)
+    memmove(psxVuw+(1024*((imageY1+j)&iGPUHeightMask))+imageX1,
+            psxVuw+(1024*((imageY0+j)&iGPUHeightMask))+imageX0,imageSX*2);
+
+   if(!bTileBand) bDoVSyncUpdate=TRUE;
+
+   return;
+  }
+
  if((imageY0+imageSY)>iGPUHeight ||
     (imageX0+imageSX)>1024       ||
     (imageY1+imageSY)>iGPUHeight ||
@@ -643,7 +675,7 @@ void primMoveImage(unsigned char * baseAddr)
      psxVuw [(1024*((imageY1+j)&iGPUHeightMask))+((imageX1+i)&0x3ff)]=
       psxVuw[(1024*((imageY0+j)&iGPUHeightMask))+((imageX0+i)&0x3ff)];
 
-   bDoVSyncUpdate=TRUE;
+   if(!bTileBand) bDoVSyncUpdate=TRUE;
  
    return;
   }
@@ -699,7 +731,7 @@ void primMoveImage(unsigned char * baseAddr)
   }
 */
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -733,7 +765,7 @@ void primTileS(unsigned char * baseAddr)
   FillSoftwareAreaTrans(lx0,ly0,lx2,ly2,
                         BGR24to16(GETLE32(&gpuData[0])));          
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -763,7 +795,7 @@ void primTile1(unsigned char * baseAddr)
  FillSoftwareAreaTrans(lx0,ly0,lx2,ly2,
                        BGR24to16(GETLE32(&gpuData[0])));          // Takes Start and Offset
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -793,7 +825,7 @@ void primTile8(unsigned char * baseAddr)
  FillSoftwareAreaTrans(lx0,ly0,lx2,ly2,
                        BGR24to16(GETLE32(&gpuData[0])));          // Takes Start and Offset
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -823,7 +855,7 @@ void primTile16(unsigned char * baseAddr)
  FillSoftwareAreaTrans(lx0,ly0,lx2,ly2,
                        BGR24to16(GETLE32(&gpuData[0])));          // Takes Start and Offset
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -849,7 +881,7 @@ void primSprt8(unsigned char * baseAddr)
                                    baseAddr[8],
                                    baseAddr[9]);
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -875,7 +907,7 @@ void primSprt16(unsigned char * baseAddr)
                                    baseAddr[8],
                                    baseAddr[9]);
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1007,7 +1039,7 @@ void primSprtS(unsigned char * baseAddr)
 
   }
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1039,7 +1071,7 @@ void primPolyF4(unsigned char *baseAddr)
 
  drawPoly4F(GETLE32(&gpuData[0]));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1072,7 +1104,7 @@ void primPolyG4(unsigned char * baseAddr)
  drawPoly4G(GETLE32(&gpuData[0]), GETLE32(&gpuData[2]), 
             GETLE32(&gpuData[4]), GETLE32(&gpuData[6]));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1105,7 +1137,7 @@ void primPolyFT3(unsigned char * baseAddr)
 
  drawPoly3FT(baseAddr);
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1141,7 +1173,7 @@ void primPolyFT4(unsigned char * baseAddr)
 
  drawPoly4FT(baseAddr);
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1181,7 +1213,7 @@ void primPolyGT3(unsigned char *baseAddr)
 
  drawPoly3GT(baseAddr);
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1211,7 +1243,7 @@ void primPolyG3(unsigned char *baseAddr)
 
  drawPoly3G(GETLE32(&gpuData[0]), GETLE32(&gpuData[2]), GETLE32(&gpuData[4]));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1254,7 +1286,7 @@ void primPolyGT4(unsigned char *baseAddr)
 
  drawPoly4GT(baseAddr);
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1284,7 +1316,7 @@ void primPolyF3(unsigned char *baseAddr)
 
  drawPoly3F(GETLE32(&gpuData[0]));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1367,7 +1399,7 @@ void primLineGEx(unsigned char *baseAddr)
    if(i>iMax) break;
   }
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1396,7 +1428,7 @@ void primLineG2(unsigned char *baseAddr)
  offsetPSX2();
  DrawSoftwareLineShade(GETLE32(&gpuData[0]),GETLE32(&gpuData[2]));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1465,7 +1497,7 @@ void primLineFEx(unsigned char *baseAddr)
    i++;if(i>iMax) break;
   }
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1495,7 +1527,7 @@ void primLineF2(unsigned char *baseAddr)
 
  DrawSoftwareLineFlat(GETLE32(&gpuData[0]));
 
- bDoVSyncUpdate=TRUE;
+ if(!bTileBand) bDoVSyncUpdate=TRUE;
 }
 
 ////////////////////////////////////////////////////////////////////////
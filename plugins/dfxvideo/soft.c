@@ -25,6 +25,7 @@
 #include "prim.h"
 #include "menu.h"
 #include "swap.h"
+#include "span.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -83,14 +84,14 @@
 // soft globals
 ////////////////////////////////////////////////////////////////////////////////////
 
-short g_m1=255,g_m2=255,g_m3=255;
-short DrawSemiTrans=FALSE;
-short Ymin;
-short Ymax;
+TLS short g_m1=255,g_m2=255,g_m3=255;
+TLS short DrawSemiTrans=FALSE;
+TLS short Ymin;
+TLS short Ymax;
 
-short          ly0,lx0,ly1,lx1,ly2,lx2,ly3,lx3;        // global psx vertex coords
-int32_t           GlobalTextAddrX,GlobalTextAddrY,GlobalTextTP;
-int32_t           GlobalTextREST,GlobalTextABR,GlobalTextPAGE;
+TLS short      ly0,lx0,ly1,lx1,ly2,lx2,ly3,lx3;        // global psx vertex coords
+TLS int32_t       GlobalTextAddrX,GlobalTextAddrY,GlobalTextTP;
+TLS int32_t       GlobalTextREST,GlobalTextABR,GlobalTextPAGE;
 
 ////////////////////////////////////////////////////////////////////////
 // POLYGON OFFSET FUNCS
@@ -1037,6 +1038,7 @@ void FillSoftwareAreaTrans(short x0,short y0,short x1, // FILL AREA TRANS
                       short y1,unsigned short col)
 {
  short j,i,dx,dy;
+ int iSpan;
 
  if(y0>y1) return;
  if(x0>x1) return;
@@ -1074,11 +1076,18 @@ v->m 1020 511 1 1
 readdatamem 0x00008000 1
 */
 
-   static int iCheat=0;
+   static TLS int iCheat=0;
    col+=iCheat;
    if(iCheat==1) iCheat=0; else iCheat=1;
   }
 
+ if((iSpan=SpanMode())>=0)                             // one kernel call per line
+  {
+   for(i=0;i<dy;i++)
+    SpanFill[iSpan](psxVuw+(1024*(y0+i))+x0,dx,col);
+   return;
+  }
+
 
  if(dx&1)                                              // slow fill
   {
@@ -1185,16 +1194,16 @@ typedef struct SOFTVTAG
  int32_t R,G,B;
 } soft_vertex;
 
-static soft_vertex vtx[4];
-static soft_vertex * left_array[4], * right_array[4];
-static int left_section, right_section;
-static int left_section_height, right_section_height;
-static int left_x, delta_left_x, right_x, delta_right_x;
-static int left_u, delta_left_u, left_v, delta_left_v;
-static int right_u, delta_right_u, right_v, delta_right_v;
-static int left_R, delta_left_R, right_R, delta_right_R;
-static int left_G, delta_left_G, right_G, delta_right_G;
-static int left_B, delta_left_B, right_B, delta_right_B;
+static TLS soft_vertex vtx[4];
+static TLS soft_vertex * left_array[4], * right_array[4];
+static TLS int left_section, right_section;
+static TLS int left_section_height, right_section_height;
+static TLS int left_x, delta_left_x, right_x, delta_right_x;
+static TLS int left_u, delta_left_u, left_v, delta_left_v;
+static TLS int right_u, delta_right_u, right_v, delta_right_v;
+static TLS int left_R, delta_left_R, right_R, delta_right_R;
+static TLS int left_G, delta_left_G, right_G, delta_right_G;
+static TLS int left_B, delta_left_B, right_B, delta_right_B;
 
 #ifdef USE_NASM
 
@@ -2547,7 +2556,7 @@ __inline BOOL SetupSections_GT4(short x1, short y1, short x2, short y2, short x3
 
 __inline void drawPoly3Fi(short x1,short y1,short x2,short y2,short x3,short y3,int32_t rgb)
 {
- int i,j,xmin,xmax,ymin,ymax;
+ int i,j,xmin,xmax,ymin,ymax,iSpan;
  unsigned short color;uint32_t lcolor;
 
  if(x1>drawW && x2>drawW && x3>drawW) return;
@@ -2590,17 +2599,26 @@ __inline void drawPoly3Fi(short x1,short y1,short x2,short y2,short x3,short y3,
 
 #endif
 
+ iSpan=SpanMode();
+
  for (i=ymin;i<=ymax;i++)
   {
    xmin=left_x >> 16;      if(drawX>xmin) xmin=drawX;
    xmax=(right_x >> 16)-1; if(drawW<xmax) xmax=drawW;
 
-   for(j=xmin;j<xmax;j+=2) 
+   if(iSpan>=0)
     {
-     GetShadeTransCol32((uint32_t *)&psxVuw[(i<<10)+j],lcolor);
+     if(xmax>=xmin) SpanFill[iSpan](&psxVuw[(i<<10)+xmin],xmax-xmin+1,color);
+    }
+   else
+    {
+     for(j=xmin;j<xmax;j+=2) 
+      {
+       GetShadeTransCol32((uint32_t *)&psxVuw[(i<<10)+j],lcolor);
+      }
+     if(j==xmax)
+      GetShadeTransCol(&psxVuw[(i<<10)+j],color);
     }
-   if(j==xmax)
-    GetShadeTransCol(&psxVuw[(i<<10)+j],color);
 
    if(NextRow_F()) return;
   }
@@ -2627,7 +2645,7 @@ void drawPoly4F_TRI(int32_t rgb)
 
 void drawPoly4F(int32_t rgb)
 {
- int i,j,xmin,xmax,ymin,ymax;
+ int i,j,xmin,xmax,ymin,ymax,iSpan;
  unsigned short color;uint32_t lcolor;
  
  if(lx0>drawW && lx1>drawW && lx2>drawW && lx3>drawW) return;
@@ -2670,21 +2688,43 @@ void drawPoly4F(int32_t rgb)
 
 #endif
 
+ iSpan=SpanMode();
+
  for (i=ymin;i<=ymax;i++)
   {
    xmin=left_x >> 16;      if(drawX>xmin) xmin=drawX;
    xmax=(right_x >> 16)-1; if(drawW<xmax) xmax=drawW;
 
-   for(j=xmin;j<xmax;j+=2) 
+   if(iSpan>=0)
+    {
+     if(xmax>=xmin) SpanFill[iSpan](&psxVuw[(i<<10)+xmin],xmax-xmin+1,color);
+    }
+   else
     {
-     GetShadeTransCol32((uint32_t *)&psxVuw[(i<<10)+j],lcolor);
+     for(j=xmin;j<xmax;j+=2) 
+      {
+       GetShadeTransCol32((uint32_t *)&psxVuw[(i<<10)+j],lcolor);
+      }
+     if(j==xmax) GetShadeTransCol(&psxVuw[(i<<10)+j],color);
     }
-   if(j==xmax) GetShadeTransCol(&psxVuw[(i<<10)+j],color);
 
    if(NextRow_F4()) return;
   }
 }
 
+////////////////////////////////////////////////////////////////////////
+// texel span -> kernel. The kernels work like the pair funcs, so an odd
+// last pixel goes through the single pixel func, as in the old loops
+////////////////////////////////////////////////////////////////////////
+
+static __inline void DrawTexSpan(int iSpan,unsigned short * pdest,unsigned short * ptex,int n)
+{
+ if(n<=0) return;
+
+ SpanTex[iSpan](pdest,ptex,n&~1);
+ if(n&1) GetTextureTransColG(pdest+n-1,ptex[n-1]);
+}
+
 ////////////////////////////////////////////////////////////////////////
 // POLY 3/4 F-SHADED TEX PAL 4
 ////////////////////////////////////////////////////////////////////////
@@ -2694,6 +2734,7 @@ void drawPoly3TEx4(short x1, short y1, short x2, short y2, short x3, short y3, s
  int i,j,xmin,xmax,ymin,ymax;
  int32_t difX, difY,difX2, difY2;
  int32_t posX,posY,YAdjust,XAdjust;
+ int iSpan;unsigned short usSpan[1024];
  int32_t clutP;
  short tC1,tC2;
  
@@ -2718,6 +2759,38 @@ void drawPoly3TEx4(short x1, short y1, short x2, short y2, short x3, short y3, s
  difX=delta_right_u;difX2=difX<<1;
  difY=delta_right_v;difY2=difY<<1;
 
+ if((iSpan=SpanMode())>=0 && SpanTexSafe(clX,clY))     // fetch the texels, then one kernel call
+  {
+   for (i=ymin;i<=ymax;i++)
+    {
+     xmin=(left_x >> 16);
+     xmax=(right_x >> 16)-1;
+     if(drawW<xmax) xmax=drawW;
+
+     if(xmax>=xmin)
+      {
+       posX=left_u;
+       posY=left_v;
+
+       if(xmin<drawX)
+        {j=drawX-xmin;xmin=drawX;posX+=j*difX;posY+=j*difY;}
+
+       for(j=xmin;j<=xmax;j++)
+        {
+         XAdjust=(posX>>16);
+         tC1 = psxVub[((posY>>5)&(int32_t)0xFFFFF800)+YAdjust+(XAdjust>>1)];
+         tC1=(tC1>>((XAdjust&1)<<2))&0xf;
+         usSpan[j-xmin]=GETLE16(&psxVuw[clutP+tC1]);
+         posX+=difX;
+         posY+=difY;
+        }
+       DrawTexSpan(iSpan,&psxVuw[(i<<10)+xmin],usSpan,xmax-xmin+1);
+      }
+     if(NextRow_FT()) return;
+    }
+   return;
+  }
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans)
@@ -3136,6 +3209,7 @@ void drawPoly4TEx4(short x1, short y1, short x2, short y2, short x3, short y3, s
  int32_t i,j,xmin,xmax,ymin,ymax;
  int32_t difX, difY, difX2, difY2;
  int32_t posX,posY,YAdjust,clutP,XAdjust;
+ int iSpan;unsigned short usSpan[1024];
  short tC1,tC2;
 
  if(x1>drawW && x2>drawW && x3>drawW && x4>drawW) return;
@@ -3156,6 +3230,43 @@ void drawPoly4TEx4(short x1, short y1, short x2, short y2, short x3, short y3, s
 
  YAdjust=((GlobalTextAddrY)<<11)+(GlobalTextAddrX<<1);
 
+ if((iSpan=SpanMode())>=0 && SpanTexSafe(clX,clY))     // fetch the texels, then one kernel call
+  {
+   for (i=ymin;i<=ymax;i++)
+    {
+     xmin=(left_x >> 16);
+     xmax=(right_x >> 16);
+
+     if(xmax>=xmin)
+      {
+       posX=left_u;
+       posY=left_v;
+
+       num=(xmax-xmin);
+       if(num==0) num=1;
+       difX=(right_u-posX)/num;
+       difY=(right_v-posY)/num;
+
+       if(xmin<drawX)
+        {j=drawX-xmin;xmin=drawX;posX+=j*difX;posY+=j*difY;}
+       xmax--;if(drawW<xmax) xmax=drawW;
+
+       for(j=xmin;j<=xmax;j++)
+        {
+         XAdjust=(posX>>16);
+         tC1 = psxVub[((posY>>5)&(int32_t)0xFFFFF800)+YAdjust+(XAdjust>>1)];
+         tC1=(tC1>>((XAdjust&1)<<2))&0xf;
+         usSpan[j-xmin]=GETLE16(&psxVuw[clutP+tC1]);
+         posX+=difX;
+         posY+=difY;
+        }
+       DrawTexSpan(iSpan,&psxVuw[(i<<10)+xmin],usSpan,xmax-xmin+1);
+      }
+     if(NextRow_FT4()) return;
+    }
+   return;
+  }
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans)
@@ -3707,6 +3818,7 @@ void drawPoly3TEx8(short x1, short y1, short x2, short y2, short x3, short y3, s
  int i,j,xmin,xmax,ymin,ymax;
  int32_t difX, difY,difX2, difY2;
  int32_t posX,posY,YAdjust,clutP;
+ int iSpan;unsigned short usSpan[1024];
  short tC1,tC2;
 
  if(x1>drawW && x2>drawW && x3>drawW) return;
@@ -3730,6 +3842,36 @@ void drawPoly3TEx8(short x1, short y1, short x2, short y2, short x3, short y3, s
  difX=delta_right_u;difX2=difX<<1;
  difY=delta_right_v;difY2=difY<<1;
 
+ if((iSpan=SpanMode())>=0 && SpanTexSafe(clX,clY))     // fetch the texels, then one kernel call
+  {
+   for (i=ymin;i<=ymax;i++)
+    {
+     xmin=(left_x >> 16);
+     xmax=(right_x >> 16)-1;
+     if(drawW<xmax) xmax=drawW;
+
+     if(xmax>=xmin)
+      {
+       posX=left_u;
+       posY=left_v;
+
+       if(xmin<drawX)
+        {j=drawX-xmin;xmin=drawX;posX+=j*difX;posY+=j*difY;}
+
+       for(j=xmin;j<=xmax;j++)
+        {
+         tC1 = psxVub[((posY>>5)&(int32_t)0xFFFFF800)+YAdjust+(posX>>16)];
+         usSpan[j-xmin]=GETLE16(&psxVuw[clutP+tC1]);
+         posX+=difX;
+         posY+=difY;
+        }
+       DrawTexSpan(iSpan,&psxVuw[(i<<10)+xmin],usSpan,xmax-xmin+1);
+      }
+     if(NextRow_FT()) return;
+    }
+   return;
+  }
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans)
@@ -4114,6 +4256,7 @@ void drawPoly4TEx8(short x1, short y1, short x2, short y2, short x3, short y3, s
  int32_t i,j,xmin,xmax,ymin,ymax;
  int32_t difX, difY, difX2, difY2;
  int32_t posX,posY,YAdjust,clutP;
+ int iSpan;unsigned short usSpan[1024];
  short tC1,tC2;
 
  if(x1>drawW && x2>drawW && x3>drawW && x4>drawW) return;
@@ -4134,6 +4277,41 @@ void drawPoly4TEx8(short x1, short y1, short x2, short y2, short x3, short y3, s
 
  YAdjust=((GlobalTextAddrY)<<11)+(GlobalTextAddrX<<1);
 
+ if((iSpan=SpanMode())>=0 && SpanTexSafe(clX,clY))     // fetch the texels, then one kernel call
+  {
+   for (i=ymin;i<=ymax;i++)
+    {
+     xmin=(left_x >> 16);
+     xmax=(right_x >> 16);
+
+     if(xmax>=xmin)
+      {
+       posX=left_u;
+       posY=left_v;
+
+       num=(xmax-xmin);
+       if(num==0) num=1;
+       difX=(right_u-posX)/num;
+       difY=(right_v-posY)/num;
+
+       if(xmin<drawX)
+        {j=drawX-xmin;xmin=drawX;posX+=j*difX;posY+=j*difY;}
+       xmax--;if(drawW<xmax) xmax=drawW;
+
+       for(j=xmin;j<=xmax;j++)
+        {
+         tC1 = psxVub[((posY>>5)&(int32_t)0xFFFFF800)+YAdjust+(posX>>16)];
+         usSpan[j-xmin]=GETLE16(&psxVuw[clutP+tC1]);
+         posX+=difX;
+         posY+=difY;
+        }
+       DrawTexSpan(iSpan,&psxVuw[(i<<10)+xmin],usSpan,xmax-xmin+1);
+      }
+     if(NextRow_FT4()) return;
+    }
+   return;
+  }
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans)
@@ -4635,6 +4813,7 @@ void drawPoly3TD(short x1, short y1, short x2, short y2, short x3, short y3, sho
  int i,j,xmin,xmax,ymin,ymax;
  int32_t difX, difY,difX2, difY2;
  int32_t posX,posY;
+ int iSpan;unsigned short usSpan[1024];
 
  if(x1>drawW && x2>drawW && x3>drawW) return;
  if(y1>drawH && y2>drawH && y3>drawH) return;
@@ -4653,6 +4832,35 @@ void drawPoly3TD(short x1, short y1, short x2, short y2, short x3, short y3, sho
  difX=delta_right_u;difX2=difX<<1;
  difY=delta_right_v;difY2=difY<<1;
 
+ if((iSpan=SpanMode())>=0 && SpanTexSafe(0,0))         // fetch the texels, then one kernel call
+  {
+   for (i=ymin;i<=ymax;i++)
+    {
+     xmin=(left_x >> 16);
+     xmax=(right_x >> 16)-1;
+     if(drawW<xmax) xmax=drawW;
+
+     if(xmax>=xmin)
+      {
+       posX=left_u;
+       posY=left_v;
+
+       if(xmin<drawX)
+        {j=drawX-xmin;xmin=drawX;posX+=j*difX;posY+=j*difY;}
+
+       for(j=xmin;j<=xmax;j++)
+        {
+         usSpan[j-xmin]=GETLE16(&psxVuw[(((posY>>16)+GlobalTextAddrY)<<10)+(posX>>16)+GlobalTextAddrX]);
+         posX+=difX;
+         posY+=difY;
+        }
+       DrawTexSpan(iSpan,&psxVuw[(i<<10)+xmin],usSpan,xmax-xmin+1);
+      }
+     if(NextRow_FT()) return;
+    }
+   return;
+  }
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans)
@@ -4857,6 +5065,7 @@ void drawPoly4TD(short x1, short y1, short x2, short y2, short x3, short y3, sho
  int32_t i,j,xmin,xmax,ymin,ymax;
  int32_t difX, difY, difX2, difY2;
  int32_t posX,posY;
+ int iSpan;unsigned short usSpan[1024];
 
  if(x1>drawW && x2>drawW && x3>drawW && x4>drawW) return;
  if(y1>drawH && y2>drawH && y3>drawH && y4>drawH) return;
@@ -4872,6 +5081,40 @@ void drawPoly4TD(short x1, short y1, short x2, short y2, short x3, short y3, sho
  for(ymin=Ymin;ymin<drawY;ymin++)
   if(NextRow_FT4()) return;
 
+ if((iSpan=SpanMode())>=0 && SpanTexSafe(0,0))         // fetch the texels, then one kernel call
+  {
+   for (i=ymin;i<=ymax;i++)
+    {
+     xmin=(left_x >> 16);
+     xmax=(right_x >> 16);
+
+     if(xmax>=xmin)
+      {
+       posX=left_u;
+       posY=left_v;
+
+       num=(xmax-xmin);
+       if(num==0) num=1;
+       difX=(right_u-posX)/num;
+       difY=(right_v-posY)/num;
+
+       if(xmin<drawX)
+        {j=drawX-xmin;xmin=drawX;posX+=j*difX;posY+=j*difY;}
+       xmax--;if(drawW<xmax) xmax=drawW;
+
+       for(j=xmin;j<=xmax;j++)
+        {
+         usSpan[j-xmin]=GETLE16(&psxVuw[(((posY>>16)+GlobalTextAddrY)<<10)+(posX>>16)+GlobalTextAddrX]);
+         posX+=difX;
+         posY+=difY;
+        }
+       DrawTexSpan(iSpan,&psxVuw[(i<<10)+xmin],usSpan,xmax-xmin+1);
+      }
+     if(NextRow_FT4()) return;
+    }
+   return;
+  }
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans)
@@ -5185,7 +5428,7 @@ void drawPoly4TD_TW_S(short x1, short y1, short x2, short y2, short x3, short y3
  
 __inline void drawPoly3Gi(short x1,short y1,short x2,short y2,short x3,short y3,int32_t rgb1, int32_t rgb2, int32_t rgb3)
 {
- int i,j,xmin,xmax,ymin,ymax;
+ int i,j,xmin,xmax,ymin,ymax,iSpan;
  int32_t cR1,cG1,cB1;
  int32_t difR,difB,difG,difR2,difB2,difG2;
 
@@ -5210,6 +5453,8 @@ __inline void drawPoly3Gi(short x1,short y1,short x2,short y2,short x3,short y3,
  difG2=difG<<1;
  difB2=difB<<1;
 
+ iSpan=SpanMode();
+
 #ifdef FASTSOLID
 
  if(!bCheckMask && !DrawSemiTrans && iDither!=2)
@@ -5228,18 +5473,23 @@ __inline void drawPoly3Gi(short x1,short y1,short x2,short y2,short x3,short y3,
        if(xmin<drawX)
         {j=drawX-xmin;xmin=drawX;cR1+=j*difR;cG1+=j*difG;cB1+=j*difB;}
 
-       for(j=xmin;j<xmax;j+=2) 
+       if(iSpan>=0)
+        SpanGouraud[iSpan](&psxVuw[(i<<10)+xmin],xmax-xmin+1,cR1,cG1,cB1,difR,difG,difB);
+       else
         {
-         PUTLE32(((uint32_t *)&psxVuw[(i<<10)+j]), 
-            ((((cR1+difR) <<7)&0x7c000000)|(((cG1+difG) << 2)&0x03e00000)|(((cB1+difB)>>3)&0x001f0000)|
-             (((cR1) >> 9)&0x7c00)|(((cG1) >> 14)&0x03e0)|(((cB1) >> 19)&0x001f))|lSetMask);
+         for(j=xmin;j<xmax;j+=2) 
+          {
+           PUTLE32(((uint32_t *)&psxVuw[(i<<10)+j]), 
+              ((((cR1+difR) <<7)&0x7c000000)|(((cG1+difG) << 2)&0x03e00000)|(((cB1+difB)>>3)&0x001f0000)|
+               (((cR1) >> 9)&0x7c00)|(((cG1) >> 14)&0x03e0)|(((cB1) >> 19)&0x001f))|lSetMask);
    
-         cR1+=difR2;
-         cG1+=difG2;
-         cB1+=difB2;
+           cR1+=difR2;
+           cG1+=difG2;
+           cB1+=difB2;
+          }
+         if(j==xmax)
+          PUTLE16(&psxVuw[(i<<10)+j], (((cR1 >> 9)&0x7c00)|((cG1 >> 14)&0x03e0)|((cB1 >> 19)&0x001f))|sSetMask);
         }
-       if(j==xmax)
-        PUTLE16(&psxVuw[(i<<10)+j], (((cR1 >> 9)&0x7c00)|((cG1 >> 14)&0x03e0)|((cB1 >> 19)&0x001f))|sSetMask);
       }
      if(NextRow_G()) return;
     }
@@ -5289,6 +5539,9 @@ __inline void drawPoly3Gi(short x1,short y1,short x2,short y2,short x3,short y3,
      if(xmin<drawX)
       {j=drawX-xmin;xmin=drawX;cR1+=j*difR;cG1+=j*difG;cB1+=j*difB;}
 
+     if(iSpan>=0)
+      SpanGouraud[iSpan](&psxVuw[(i<<10)+xmin],xmax-xmin+1,cR1,cG1,cB1,difR,difG,difB);
+     else
      for(j=xmin;j<=xmax;j++) 
       {
        GetShadeTransCol(&psxVuw[(i<<10)+j],((cR1 >> 9)&0x7c00)|((cG1 >> 14)&0x03e0)|((cB1 >> 19)&0x001f));
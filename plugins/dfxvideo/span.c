@@ -0,0 +1,380 @@
+/***************************************************************************
+                          span.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// span kernels for soft.c. Every kernel exists once per blend mode
+// (opaque, abr 0..3) and mask check, generated from one generic inline
+// func with the mode as constant, and is picked once per prim. With
+// SSE2 eight pixels are done per step, the rest (and non x86 builds)
+// go through the scalar lane funcs.
+//
+// The results have to be bit exact with the per pixel funcs in soft.c,
+// including their quirks: the texture kernel follows the pair funcs
+// (GetTextureTransColG32), abr 3 is the 25% mode soft.c is built with
+// (HALFBRIGHTMODE3).
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_SPAN
+
+#include "externals.h"
+#include "swap.h"
+#include "span.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __GNUC__
+#define SPANINLINE static __inline __attribute__((always_inline))
+#else
+#define SPANINLINE static __inline
+#endif
+
+int iUseSpanKernels = 1;
+
+////////////////////////////////////////////////////////////////////////
+// lane funcs (one pixel)
+////////////////////////////////////////////////////////////////////////
+
+SPANINLINE unsigned short ShadeLane(unsigned short d, unsigned short c, const int abr, const int mask)
+{
+ int32_t r,g,b;
+
+ if(mask && (d&0x8000)) return d;
+
+ switch(abr)
+  {
+   case -1:
+    return c|sSetMask;
+   case 0:
+    return (((d&0x7bde)>>1)+((c&0x7bde)>>1))|sSetMask;
+   case 1:
+    r=(d&0x1f)+(c&0x1f);b=(d&0x3e0)+(c&0x3e0);g=(d&0x7c00)+(c&0x7c00);
+    break;
+   case 2:
+    r=(d&0x1f)-(c&0x1f);b=(d&0x3e0)-(c&0x3e0);g=(d&0x7c00)-(c&0x7c00);
+    if(r<0) r=0;
+    if(b<0) b=0;
+    if(g<0) g=0;
+    break;
+   default:
+    r=(d&0x1f)+((c&0x1f)>>2);b=(d&0x3e0)+((c&0x3e0)>>2);g=(d&0x7c00)+((c&0x7c00)>>2);
+    break;
+  }
+
+ if(r>0x1f)   r=0x1f;
+ if(b>0x3ff)  b=0x3e0;
+ if(g>0x7fff) g=0x7c00;
+
+ return (g&0x7c00)|(b&0x3e0)|(r&0x1f)|sSetMask;
+}
+
+SPANINLINE unsigned short TexLane(unsigned short d, unsigned short t, const int abr, const int mask)
+{
+ int32_t r,g,b,tr,tg,tb;
+
+ if(t==0) return d;
+ if(mask && (d&0x8000)) return d;
+
+ tr=t&0x1f;tb=(t>>5)&0x1f;tg=(t>>10)&0x1f;
+
+ if(abr<0 || !(t&0x8000))
+  {
+   r=(tr*g_m1)>>7;b=(tb*g_m2)>>7;g=(tg*g_m3)>>7;
+  }
+ else
+  {
+   int32_t dr=d&0x1f,db=(d>>5)&0x1f,dg=(d>>10)&0x1f;
+
+   switch(abr)
+    {
+     case 0:
+      r=((dr<<7)+tr*g_m1)>>8;b=((db<<7)+tb*g_m2)>>8;g=((dg<<7)+tg*g_m3)>>8;
+      break;
+     case 1:
+      r=dr+((tr*g_m1)>>7);b=db+((tb*g_m2)>>7);g=dg+((tg*g_m3)>>7);
+      break;
+     case 2:
+      r=dr-((tr*g_m1)>>7);b=db-((tb*g_m2)>>7);g=dg-((tg*g_m3)>>7);
+      if(r<0) r=0;
+      if(b<0) b=0;
+      if(g<0) g=0;
+      break;
+     default:
+      r=dr+(((tr>>2)*g_m1)>>7);b=db+(((tb>>2)*g_m2)>>7);g=dg+(((tg>>2)*g_m3)>>7);
+      break;
+    }
+  }
+
+ if(r>0x1f) r=0x1f;
+ if(b>0x1f) b=0x1f;
+ if(g>0x1f) g=0x1f;
+
+ return (g<<10)|(b<<5)|r|sSetMask|(t&0x8000);
+}
+
+#define GOURCOL(r,g,b) ((((r)>>9)&0x7c00)|(((g)>>14)&0x03e0)|(((b)>>19)&0x001f))
+
+////////////////////////////////////////////////////////////////////////
+// vector funcs (eight pixels)
+////////////////////////////////////////////////////////////////////////
+
+#ifdef __SSE2__
+
+#define V16(x) _mm_set1_epi16((short)(x))
+#define VSEL(m,a,b) _mm_or_si128(_mm_and_si128(m,a),_mm_andnot_si128(m,b))
+
+SPANINLINE __m128i ShadeVec(__m128i d, __m128i c, __m128i sm, const int abr, const int mask)
+{
+ __m128i o,r,g,b,cr,cg,cb;
+
+ switch(abr)
+  {
+   case -1:
+    o=_mm_or_si128(c,sm);
+    break;
+   case 0:
+    o=_mm_add_epi16(_mm_srli_epi16(_mm_and_si128(d,V16(0x7bde)),1),
+                    _mm_srli_epi16(_mm_and_si128(c,V16(0x7bde)),1));
+    o=_mm_or_si128(o,sm);
+    break;
+   default:
+    r=_mm_and_si128(d,V16(0x1f));  cr=_mm_and_si128(c,V16(0x1f));
+    b=_mm_and_si128(d,V16(0x3e0)); cb=_mm_and_si128(c,V16(0x3e0));
+    g=_mm_and_si128(d,V16(0x7c00));cg=_mm_and_si128(c,V16(0x7c00));
+    if(abr==2)
+     {
+      r=_mm_max_epi16(_mm_sub_epi16(r,cr),_mm_setzero_si128());
+      b=_mm_max_epi16(_mm_sub_epi16(b,cb),_mm_setzero_si128());
+      g=_mm_max_epi16(_mm_sub_epi16(g,cg),_mm_setzero_si128());
+     }
+    else
+     {
+      if(abr==3)
+       {cr=_mm_srli_epi16(cr,2);cb=_mm_srli_epi16(cb,2);cg=_mm_srli_epi16(cg,2);}
+      r=_mm_add_epi16(r,cr);
+      b=_mm_add_epi16(b,cb);
+      g=_mm_add_epi16(g,cg);
+     }
+    r=_mm_min_epi16(r,V16(0x1f));                      // r, b: small enough for signed min
+    b=_mm_and_si128(_mm_min_epi16(b,V16(0x3e0)),V16(0x3e0));
+    g=_mm_and_si128(_mm_or_si128(g,_mm_srai_epi16(g,15)),V16(0x7c00)); // >=0x8000 -> 0x7c00
+    o=_mm_or_si128(_mm_or_si128(r,b),_mm_or_si128(g,sm));
+    break;
+  }
+
+ if(mask)
+  {
+   __m128i dm=_mm_srai_epi16(d,15);
+   o=VSEL(dm,d,o);
+  }
+ return o;
+}
+
+SPANINLINE __m128i TexVec(__m128i d, __m128i t, __m128i sm, __m128i m1, __m128i m2, __m128i m3,
+                          const int abr, const int mask)
+{
+ __m128i keep,tr,tg,tb,r,g,b,o;
+
+ keep=_mm_cmpeq_epi16(t,_mm_setzero_si128());
+ if(mask) keep=_mm_or_si128(keep,_mm_srai_epi16(d,15));
+
+ tr=_mm_and_si128(t,V16(0x1f));
+ tb=_mm_and_si128(_mm_srli_epi16(t,5),V16(0x1f));
+ tg=_mm_and_si128(_mm_srli_epi16(t,10),V16(0x1f));
+
+ r=_mm_srli_epi16(_mm_mullo_epi16(tr,m1),7);
+ b=_mm_srli_epi16(_mm_mullo_epi16(tb,m2),7);
+ g=_mm_srli_epi16(_mm_mullo_epi16(tg,m3),7);
+
+ if(abr>=0)
+  {
+   __m128i semi=_mm_srai_epi16(t,15),br,bb,bg;
+   __m128i dr=_mm_and_si128(d,V16(0x1f));
+   __m128i db=_mm_and_si128(_mm_srli_epi16(d,5),V16(0x1f));
+   __m128i dg=_mm_and_si128(_mm_srli_epi16(d,10),V16(0x1f));
+
+   switch(abr)
+    {
+     case 0:
+      br=_mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(dr,7),_mm_mullo_epi16(tr,m1)),8);
+      bb=_mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(db,7),_mm_mullo_epi16(tb,m2)),8);
+      bg=_mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(dg,7),_mm_mullo_epi16(tg,m3)),8);
+      break;
+     case 1:
+      br=_mm_add_epi16(dr,r);bb=_mm_add_epi16(db,b);bg=_mm_add_epi16(dg,g);
+      break;
+     case 2:
+      br=_mm_max_epi16(_mm_sub_epi16(dr,r),_mm_setzero_si128());
+      bb=_mm_max_epi16(_mm_sub_epi16(db,b),_mm_setzero_si128());
+      bg=_mm_max_epi16(_mm_sub_epi16(dg,g),_mm_setzero_si128());
+      break;
+     default:
+      br=_mm_add_epi16(dr,_mm_srli_epi16(_mm_mullo_epi16(_mm_srli_epi16(tr,2),m1),7));
+      bb=_mm_add_epi16(db,_mm_srli_epi16(_mm_mullo_epi16(_mm_srli_epi16(tb,2),m2),7));
+      bg=_mm_add_epi16(dg,_mm_srli_epi16(_mm_mullo_epi16(_mm_srli_epi16(tg,2),m3),7));
+      break;
+    }
+   r=VSEL(semi,br,r);b=VSEL(semi,bb,b);g=VSEL(semi,bg,g);
+  }
+
+ r=_mm_min_epi16(r,V16(0x1f));
+ b=_mm_min_epi16(b,V16(0x1f));
+ g=_mm_min_epi16(g,V16(0x1f));
+
+ o=_mm_or_si128(_mm_or_si128(r,_mm_slli_epi16(b,5)),_mm_slli_epi16(g,10));
+ o=_mm_or_si128(_mm_or_si128(o,sm),_mm_and_si128(t,V16(0x8000)));
+
+ return VSEL(keep,d,o);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////
+// generic kernels
+////////////////////////////////////////////////////////////////////////
+
+SPANINLINE void DoSpanFill(unsigned short * p, int n, unsigned short color, const int abr, const int mask)
+{
+#ifdef __SSE2__
+ __m128i c=V16(color),sm=V16(sSetMask);
+
+ for(;n>=8;n-=8,p+=8)
+  _mm_storeu_si128((__m128i *)p,ShadeVec(_mm_loadu_si128((__m128i *)p),c,sm,abr,mask));
+#endif
+
+ for(;n>0;n--,p++)
+  PUTLE16(p, ShadeLane(GETLE16(p),color,abr,mask));
+}
+
+SPANINLINE void DoSpanGouraud(unsigned short * p, int n,
+                              int32_t cR, int32_t cG, int32_t cB,
+                              int32_t dR, int32_t dG, int32_t dB,
+                              const int abr, const int mask)
+{
+#ifdef __SSE2__
+ if(n>=8)
+  {
+   __m128i sm=V16(sSetMask);
+   __m128i vR=_mm_setr_epi32(cR,cR+dR,cR+2*dR,cR+3*dR);
+   __m128i vG=_mm_setr_epi32(cG,cG+dG,cG+2*dG,cG+3*dG);
+   __m128i vB=_mm_setr_epi32(cB,cB+dB,cB+2*dB,cB+3*dB);
+   __m128i sR=_mm_set1_epi32(4*dR),sG=_mm_set1_epi32(4*dG),sB=_mm_set1_epi32(4*dB);
+   __m128i lo,hi;
+
+   for(;n>=8;n-=8,p+=8)
+    {
+     lo=_mm_or_si128(_mm_or_si128(
+         _mm_and_si128(_mm_srai_epi32(vR,9), _mm_set1_epi32(0x7c00)),
+         _mm_and_si128(_mm_srai_epi32(vG,14),_mm_set1_epi32(0x03e0))),
+         _mm_and_si128(_mm_srai_epi32(vB,19),_mm_set1_epi32(0x001f)));
+     vR=_mm_add_epi32(vR,sR);vG=_mm_add_epi32(vG,sG);vB=_mm_add_epi32(vB,sB);
+     hi=_mm_or_si128(_mm_or_si128(
+         _mm_and_si128(_mm_srai_epi32(vR,9), _mm_set1_epi32(0x7c00)),
+         _mm_and_si128(_mm_srai_epi32(vG,14),_mm_set1_epi32(0x03e0))),
+         _mm_and_si128(_mm_srai_epi32(vB,19),_mm_set1_epi32(0x001f)));
+     vR=_mm_add_epi32(vR,sR);vG=_mm_add_epi32(vG,sG);vB=_mm_add_epi32(vB,sB);
+
+     _mm_storeu_si128((__m128i *)p,ShadeVec(_mm_loadu_si128((__m128i *)p),
+                                            _mm_packs_epi32(lo,hi),sm,abr,mask));
+    }
+
+   cR=_mm_cvtsi128_si32(vR);cG=_mm_cvtsi128_si32(vG);cB=_mm_cvtsi128_si32(vB);
+  }
+#endif
+
+ for(;n>0;n--,p++)
+  {
+   PUTLE16(p, ShadeLane(GETLE16(p),GOURCOL(cR,cG,cB),abr,mask));
+   cR+=dR;cG+=dG;cB+=dB;
+  }
+}
+
+SPANINLINE void DoSpanTex(unsigned short * p, unsigned short * t, int n, const int abr, const int mask)
+{
+#ifdef __SSE2__
+ __m128i sm=V16(sSetMask),m1=V16(g_m1),m2=V16(g_m2),m3=V16(g_m3);
+
+ for(;n>=8;n-=8,p+=8,t+=8)
+  _mm_storeu_si128((__m128i *)p,TexVec(_mm_loadu_si128((__m128i *)p),
+                                       _mm_loadu_si128((__m128i *)t),sm,m1,m2,m3,abr,mask));
+#endif
+
+ for(;n>0;n--,p++,t++)
+  PUTLE16(p, TexLane(GETLE16(p),*t,abr,mask));
+}
+
+////////////////////////////////////////////////////////////////////////
+// the variants
+////////////////////////////////////////////////////////////////////////
+
+#define MAKESPAN(n,abr,mask)                                                   \
+static void SpanFill##n(unsigned short * p, int c, unsigned short color)       \
+{DoSpanFill(p,c,color,abr,mask);}                                              \
+static void SpanGouraud##n(unsigned short * p, int c,                          \
+                           int32_t cR, int32_t cG, int32_t cB,                 \
+                           int32_t dR, int32_t dG, int32_t dB)                 \
+{DoSpanGouraud(p,c,cR,cG,cB,dR,dG,dB,abr,mask);}                               \
+static void SpanTex##n(unsigned short * p, unsigned short * t, int c)          \
+{DoSpanTex(p,t,c,abr,mask);}
+
+MAKESPAN(0,-1,0) MAKESPAN(1,0,0) MAKESPAN(2,1,0) MAKESPAN(3,2,0) MAKESPAN(4,3,0)
+MAKESPAN(5,-1,1) MAKESPAN(6,0,1) MAKESPAN(7,1,1) MAKESPAN(8,2,1) MAKESPAN(9,3,1)
+
+SPANFILL SpanFill[SPANMODES] =
+ {SpanFill0,SpanFill1,SpanFill2,SpanFill3,SpanFill4,
+  SpanFill5,SpanFill6,SpanFill7,SpanFill8,SpanFill9};
+
+SPANGOUR SpanGouraud[SPANMODES] =
+ {SpanGouraud0,SpanGouraud1,SpanGouraud2,SpanGouraud3,SpanGouraud4,
+  SpanGouraud5,SpanGouraud6,SpanGouraud7,SpanGouraud8,SpanGouraud9};
+
+SPANTEX SpanTex[SPANMODES] =
+ {SpanTex0,SpanTex1,SpanTex2,SpanTex3,SpanTex4,
+  SpanTex5,SpanTex6,SpanTex7,SpanTex8,SpanTex9};
+
+////////////////////////////////////////////////////////////////////////
+// kernel index for the current render mode, -1: use the old loops
+////////////////////////////////////////////////////////////////////////
+
+int SpanMode(void)
+{
+ if(!iUseSpanKernels) return -1;
+
+ return (bCheckMask?5:0)+(DrawSemiTrans?GlobalTextABR+1:0);
+}
+
+////////////////////////////////////////////////////////////////////////
+// the textured prims fetch a whole span of texels before writing it.
+// Only allowed if neither the texture page nor the clut can be inside
+// the drawing area, else a prim may read pixels it just wrote itself.
+////////////////////////////////////////////////////////////////////////
+
+BOOL SpanTexSafe(int32_t clX, int32_t clY)
+{
+ int32_t w=(GlobalTextTP==0)?64:((GlobalTextTP==1)?128:256);
+ int32_t cw=(GlobalTextTP==0)?16:256;
+
+ if(GlobalTextAddrX+w>1024) return FALSE;             // wraps into the next line
+
+ if(GlobalTextAddrX+w-1>=drawX && GlobalTextAddrX<=drawW &&
+    GlobalTextAddrY+255>=drawY && GlobalTextAddrY<=drawH) return FALSE;
+
+ if(GlobalTextTP==2) return TRUE;                      // no clut
+
+ if(clX+cw>1024) return FALSE;
+
+ return !(clX+cw-1>=drawX && clX<=drawW && clY>=drawY && clY<=drawH);
+}
@@ -0,0 +1,38 @@
+/***************************************************************************
+                          span.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _SPAN_INTERNALS_H
+#define _SPAN_INTERNALS_H
+
+// span kernels: one horizontal run of pixels, specialised for the
+// blend mode and mask check of the prim, so the pixel loop has no
+// branches left. Index with SpanMode(), which is -1 if they are off.
+
+typedef void (*SPANFILL)(unsigned short * pdest, int n, unsigned short color);
+typedef void (*SPANGOUR)(unsigned short * pdest, int n,
+                         int32_t cR, int32_t cG, int32_t cB,
+                         int32_t dR, int32_t dG, int32_t dB);
+typedef void (*SPANTEX) (unsigned short * pdest, unsigned short * ptex, int n);
+
+#define SPANMODES 10                                   // (opaque, abr 0..3) x (mask check)
+
+extern SPANFILL SpanFill[SPANMODES];                   // flat color, like GetShadeTransCol
+extern SPANGOUR SpanGouraud[SPANMODES];                // 8.16 rgb stepped per pixel
+extern SPANTEX  SpanTex[SPANMODES];                    // texel pairs, like GetTextureTransColG32
+
+int  SpanMode(void);
+BOOL SpanTexSafe(int32_t clX, int32_t clY);
+
+#endif // _SPAN_INTERNALS_H
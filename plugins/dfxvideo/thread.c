@@ -0,0 +1,203 @@
+/***************************************************************************
+                          thread.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// threaded gpu: the emu thread only copies GP0 words into a ring,
+// a worker thread feeds them to the rasterizer. Single producer,
+// single consumer, so the ring itself needs no lock - the mutex is
+// only there to put an idle worker to sleep.
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_THREAD
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "externals.h"
+#include "gpu.h"
+#include "thread.h"
+#include "tile.h"
+
+#define FIFOSIZE  (1<<18)                              // in words (1 MB)
+#define FIFOMASK  (FIFOSIZE-1)
+#define FIFOCHUNK (FIFOSIZE/4)                         // max words per put
+
+int iUseGPUThread = 0;
+
+static uint32_t ulFifo[FIFOSIZE];
+static volatile uint32_t ulFifoHead = 0;               // written by emu thread only
+static volatile uint32_t ulFifoTail = 0;               // written by worker only
+static volatile int iWorkerSleeping = 0;
+static volatile int iWorkerRunning = 0;
+
+static pthread_t       thWorker;
+static pthread_mutex_t mtxWorker = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cndWorker = PTHREAD_COND_INITIALIZER;
+
+static DrawState_t     dsHandoff;                      // rasterizer state is per thread
+
+////////////////////////////////////////////////////////////////////////
+
+static void *GPUWorker(void *arg)
+{
+ uint32_t head, tail, n;
+
+ LoadDrawState(&dsHandoff);                            // take over from the emu thread
+
+ while(iWorkerRunning)
+  {
+   tail = ulFifoTail;
+   head = ulFifoHead;
+
+   if(head == tail)
+    {
+     pthread_mutex_lock(&mtxWorker);
+     iWorkerSleeping = 1;
+     __sync_synchronize();                             // pairs with the one in GPUThreadPush
+     if(ulFifoHead == ulFifoTail && iWorkerRunning)
+      pthread_cond_wait(&cndWorker, &mtxWorker);
+     iWorkerSleeping = 0;
+     pthread_mutex_unlock(&mtxWorker);
+     continue;
+    }
+
+   __sync_synchronize();                               // see the words before the head
+
+   n = head - tail;                                    // -> feed contiguous runs, the
+   if(n > FIFOSIZE - (tail & FIFOMASK))                //    data port state machine
+    n = FIFOSIZE - (tail & FIFOMASK);                  //    doesn't care where we split
+
+   DoWriteDataMem(&ulFifo[tail & FIFOMASK], n);
+   if(tail + n == ulFifoHead) TileFlush();             // caught up: draw binned prims
+
+   __sync_synchronize();                               // vram/status done before the tail moves
+   ulFifoTail = tail + n;
+  }
+
+ TileFlush();
+ SaveDrawState(&dsHandoff);                            // and hand it back
+
+ return NULL;
+}
+
+static void WakeWorker(void)
+{
+ __sync_synchronize();
+ if(iWorkerSleeping)
+  {
+   pthread_mutex_lock(&mtxWorker);
+   pthread_cond_signal(&cndWorker);
+   pthread_mutex_unlock(&mtxWorker);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void GPUThreadStart(void)
+{
+ if(iWorkerRunning) return;
+
+ ulFifoHead = ulFifoTail = 0;
+ iWorkerSleeping = 0;
+ iWorkerRunning = 1;
+
+ SaveDrawState(&dsHandoff);
+
+ if(pthread_create(&thWorker, NULL, GPUWorker, NULL) != 0)
+  {
+   iWorkerRunning = 0;                                 // -> stay synchronous
+   iUseGPUThread = 0;
+   printf("dfxvideo: can't create gpu thread, using single thread mode\n");
+  }
+}
+
+void GPUThreadStop(void)
+{
+ if(!iWorkerRunning) return;
+
+ GPUThreadSync();
+
+ pthread_mutex_lock(&mtxWorker);
+ iWorkerRunning = 0;
+ pthread_cond_signal(&cndWorker);
+ pthread_mutex_unlock(&mtxWorker);
+
+ pthread_join(thWorker, NULL);
+
+ LoadDrawState(&dsHandoff);
+}
+
+////////////////////////////////////////////////////////////////////////
+// wait until the worker has executed everything queued so far. Must be
+// called before the emu thread touches vram or any drawing state.
+////////////////////////////////////////////////////////////////////////
+
+void GPUThreadSync(void)
+{
+ if(!iWorkerRunning) return;
+
+ while(ulFifoTail != ulFifoHead)
+  {
+   WakeWorker();
+   sched_yield();
+  }
+
+ __sync_synchronize();                                 // see everything the worker wrote
+}
+
+BOOL GPUThreadBusy(void)
+{
+ return iWorkerRunning && ulFifoTail != ulFifoHead;
+}
+
+////////////////////////////////////////////////////////////////////////
+// queue GP0 words. The caller's buffer may be psx ram, which the cpu is
+// free to change as soon as we return, so the words are copied.
+////////////////////////////////////////////////////////////////////////
+
+void GPUThreadPush(uint32_t * pMem, int iSize)
+{
+ uint32_t head, n, first;
+
+ if(!iWorkerRunning)
+  {
+   DoWriteDataMem(pMem, iSize);
+   return;
+  }
+
+ while(iSize > 0)
+  {
+   n = iSize > FIFOCHUNK ? FIFOCHUNK : iSize;
+
+   head = ulFifoHead;
+   while(FIFOSIZE - (head - ulFifoTail) < n)           // full -> let the worker catch up
+    {
+     WakeWorker();
+     sched_yield();
+    }
+
+   first = FIFOSIZE - (head & FIFOMASK);
+   if(first > n) first = n;
+   memcpy(&ulFifo[head & FIFOMASK], pMem, first * 4);
+   if(n > first) memcpy(ulFifo, pMem + first, (n - first) * 4);
+
+   __sync_synchronize();                               // words visible before the head
+   ulFifoHead = head + n;
+
+   pMem += n; iSize -= n;
+  }
+
+ WakeWorker();
+}
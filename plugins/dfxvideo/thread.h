@@ -0,0 +1,25 @@
+/***************************************************************************
+                          thread.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _THREAD_INTERNALS_H
+#define _THREAD_INTERNALS_H
+
+void GPUThreadStart(void);
+void GPUThreadStop(void);
+void GPUThreadSync(void);
+BOOL GPUThreadBusy(void);
+void GPUThreadPush(uint32_t * pMem, int iSize);
+
+#endif // _THREAD_INTERNALS_H
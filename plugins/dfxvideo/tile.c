@@ -0,0 +1,403 @@
+/***************************************************************************
+                          tile.c  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+////////////////////////////////////////////////////////////////////////
+// binned soft rendering: prims are collected into a batch instead of
+// being drawn right away. On flush the drawing area is cut into bands
+// of rows, and a pool of threads replays the batch, one band at a time,
+// with drawY/drawH narrowed to the band. Every band sees the prims in
+// submission order and bands never share a pixel, so mask bit checks
+// and semi transparency give the same result as drawing in one go.
+//
+// A batch ends at anything that isn't clipped by the drawing area or
+// that changes it: draw area/offset cmds, fills, vram transfers, lines
+// (they clip differently at the bottom edge) and textured prims which
+// read from inside the drawing area (render to texture).
+////////////////////////////////////////////////////////////////////////
+
+#define _IN_TILE
+
+#include <pthread.h>
+
+#include "externals.h"
+#include "gpu.h"
+#include "swap.h"
+#include "tile.h"
+
+#define MAXTILETHREADS 16
+#define MAXBANDS       32                              // one bit per band in the mask
+#define MINBANDHEIGHT  16
+#define BATCHSIZE      (64*1024)                       // in words
+#define SMALLBATCH     256                             // not worth waking the pool
+
+#define TF_STATE       0x10000                         // record runs in every band
+
+#define SIGNSHIFT      21
+
+extern const unsigned char primTableCX[256];
+
+int iTileThreads = 0;
+TLS BOOL bTileBand = FALSE;                            // this thread draws a band: only draw state
+
+static uint32_t     ulBatch[BATCHSIZE];
+static int          iBatchPos = 0;
+static DrawState_t  dsBatch;                           // state when the batch started
+static int          iBands;
+static int32_t      lBandY[MAXBANDS+1];                // band b: rows lBandY[b]...lBandY[b+1]-1
+static int32_t      lTexX,lTexY,lTexTP;                // texture page at the end of the batch
+static BOOL         bTexWin;                           // texture window at the end of the batch
+
+static pthread_t       thTile[MAXTILETHREADS];
+static int             iTileWorkers = 0;
+static pthread_mutex_t mtxTile = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cndTileGo = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  cndTileDone = PTHREAD_COND_INITIALIZER;
+static int             iTileGen = 0;
+static int             iTileBusy = 0;
+static int             bTileQuit = FALSE;
+static volatile int    iNextBand;
+
+void primTexPage(unsigned short gdata);
+
+////////////////////////////////////////////////////////////////////////
+// state copy
+////////////////////////////////////////////////////////////////////////
+
+void SaveDrawState(DrawState_t * ds)
+{
+ ds->g_m1=g_m1;ds->g_m2=g_m2;ds->g_m3=g_m3;
+ ds->DrawSemiTrans=DrawSemiTrans;
+ ds->GlobalTextAddrX=GlobalTextAddrX;ds->GlobalTextAddrY=GlobalTextAddrY;
+ ds->GlobalTextTP=GlobalTextTP;ds->GlobalTextREST=GlobalTextREST;
+ ds->GlobalTextABR=GlobalTextABR;ds->GlobalTextPAGE=GlobalTextPAGE;
+ ds->GlobalTextIL=GlobalTextIL;
+ ds->lLowerpart=lLowerpart;
+ ds->bUsingTWin=bUsingTWin;ds->TWin=TWin;
+ ds->usMirror=usMirror;ds->iDither=iDither;
+ ds->drawX=drawX;ds->drawY=drawY;ds->drawW=drawW;ds->drawH=drawH;
+ ds->bCheckMask=bCheckMask;ds->sSetMask=sSetMask;ds->lSetMask=lSetMask;
+}
+
+void LoadDrawState(DrawState_t * ds)
+{
+ g_m1=ds->g_m1;g_m2=ds->g_m2;g_m3=ds->g_m3;
+ DrawSemiTrans=ds->DrawSemiTrans;
+ GlobalTextAddrX=ds->GlobalTextAddrX;GlobalTextAddrY=ds->GlobalTextAddrY;
+ GlobalTextTP=ds->GlobalTextTP;GlobalTextREST=ds->GlobalTextREST;
+ GlobalTextABR=ds->GlobalTextABR;GlobalTextPAGE=ds->GlobalTextPAGE;
+ GlobalTextIL=ds->GlobalTextIL;
+ lLowerpart=ds->lLowerpart;
+ bUsingTWin=ds->bUsingTWin;TWin=ds->TWin;
+ usMirror=ds->usMirror;iDither=ds->iDither;
+ drawX=ds->drawX;drawY=ds->drawY;drawW=ds->drawW;drawH=ds->drawH;
+ bCheckMask=ds->bCheckMask;sSetMask=ds->sSetMask;lSetMask=ds->lSetMask;
+}
+
+////////////////////////////////////////////////////////////////////////
+// replay
+////////////////////////////////////////////////////////////////////////
+
+static int TexPageWord(unsigned char command)          // word holding a poly's tpage
+{
+ switch(command&0xfc)
+  {
+   case 0x24: case 0x2c: return 4;
+   case 0x34: case 0x3c: return 5;
+  }
+ return 0;
+}
+
+static void ReplayBatch(uint32_t bit)
+{
+ uint32_t * p = ulBatch, * pe = ulBatch + iBatchPos;
+ unsigned char command;
+ int i;
+
+ while(p<pe)
+  {
+   command=(unsigned char)(p[0]&0xff);
+
+   if((p[0]&TF_STATE) || (p[1]&bit))
+    primTableJ[command]((unsigned char *)(p+2));
+   else if((i=TexPageWord(command)))                   // binned away: keep its tpage anyway,
+    primTexPage((unsigned short)(GETLE32(&p[2+i])>>16)); // later sprites draw with it
+
+   p+=((p[0]>>8)&0xff)+2;
+  }
+}
+
+// the bands only touch their thread's draw state: the gpu status and
+// info words, and the vsync update flag, are left to the serial pass of
+// TileFlush (several bands would write them at the same time)
+
+static void TileWork(void)
+{
+ int b;
+
+ bTileBand=TRUE;
+ while((b=__sync_fetch_and_add(&iNextBand,1))<iBands)
+  {
+   LoadDrawState(&dsBatch);
+   drawY=lBandY[b];
+   drawH=lBandY[b+1]-1;
+   ReplayBatch(1u<<b);
+  }
+ bTileBand=FALSE;
+}
+
+static void *TileWorker(void *arg)
+{
+ int gen=0;                                            // TileStart reset iTileGen
+
+ pthread_mutex_lock(&mtxTile);
+ for(;;)
+  {
+   while(gen==iTileGen && !bTileQuit)
+    pthread_cond_wait(&cndTileGo,&mtxTile);
+   if(bTileQuit) break;
+   gen=iTileGen;
+   pthread_mutex_unlock(&mtxTile);
+
+   TileWork();
+
+   pthread_mutex_lock(&mtxTile);
+   if(--iTileBusy==0) pthread_cond_signal(&cndTileDone);
+  }
+ pthread_mutex_unlock(&mtxTile);
+
+ return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+void TileFlush(void)
+{
+ if(!iBatchPos) return;
+
+ if(iBatchPos<SMALLBATCH)                              // few prims: draw them here, unbanded
+  {
+   LoadDrawState(&dsBatch);
+   ReplayBatch(0xffffffff);
+   iBatchPos=0;
+   return;
+  }
+
+ pthread_mutex_lock(&mtxTile);
+ iNextBand=0;
+ iTileBusy=iTileWorkers;
+ iTileGen++;
+ pthread_cond_broadcast(&cndTileGo);
+ pthread_mutex_unlock(&mtxTile);
+
+ TileWork();                                           // this thread takes bands too
+
+ pthread_mutex_lock(&mtxTile);
+ while(iTileBusy) pthread_cond_wait(&cndTileDone,&mtxTile);
+ pthread_mutex_unlock(&mtxTile);
+
+ LoadDrawState(&dsBatch);                              // state cmds only, so we end up with
+ ReplayBatch(0);                                       // the state after the batch (status and info too)
+ bDoVSyncUpdate=TRUE;                                  // what the bands drew
+
+ iBatchPos=0;
+}
+
+////////////////////////////////////////////////////////////////////////
+// binning
+////////////////////////////////////////////////////////////////////////
+
+static BOOL StartBatch(void)
+{
+ int32_t h=drawH-drawY+1;
+ int i,n;
+
+ if(drawX>drawW || h<2*MINBANDHEIGHT) return FALSE;
+
+ n=(iTileWorkers+1)*2;                                 // some spare bands for balancing
+ if(n>MAXBANDS) n=MAXBANDS;
+ if(n>h/MINBANDHEIGHT) n=h/MINBANDHEIGHT;
+
+ iBands=n;
+ for(i=0;i<=n;i++) lBandY[i]=drawY+(h*i)/n;
+
+ SaveDrawState(&dsBatch);
+ lTexX=GlobalTextAddrX;lTexY=GlobalTextAddrY;lTexTP=GlobalTextTP;
+ bTexWin=bUsingTWin;
+ return TRUE;
+}
+
+static void SetTexPage(uint32_t gdata)                 // same decoding as UpdateGlobalTP
+{
+ lTexX=(gdata<<6)&0x3c0;
+ lTexY=(gdata<<4)&0x100;
+ lTexTP=(gdata>>7)&0x3;
+ if(lTexTP==3) lTexTP=2;
+}
+
+static BOOL InDrawArea(int32_t x0,int32_t y0,int32_t x1,int32_t y1)
+{
+ return x1>=dsBatch.drawX && x0<=dsBatch.drawW &&
+        y1>=dsBatch.drawY && y0<=dsBatch.drawH;
+}
+
+static BOOL TexHazard(uint32_t clut)                   // texels or clut inside the draw area?
+{
+ int32_t w=(lTexTP==0)?64:((lTexTP==1)?128:256);
+ int32_t cx,cy;
+
+ if(bTexWin) return TRUE;                              // tw reads can land almost anywhere
+ if(lTexX+w>1024) return TRUE;                         // wraps into the next line
+ if(InDrawArea(lTexX,lTexY,lTexX+w-1,lTexY+255)) return TRUE;
+ if(lTexTP==2) return FALSE;
+
+ cx=(clut<<4)&0x3f0;
+ cy=(clut>>6)&iGPUHeightMask;
+ return InDrawArea(cx,cy,cx+((lTexTP==0)?15:255),cy);
+}
+
+static int32_t VertexY(uint32_t gdata)                 // y as the prim funcs see it, w/o offset
+{
+ int32_t y=(short)(gdata>>16);
+ if(!(dwActFixes&8)) y=(short)((y<<SIGNSHIFT)>>SIGNSHIFT);
+ return y;
+}
+
+static uint32_t BandMask(int32_t y0,int32_t y1)
+{
+ uint32_t mask=0;
+ int i;
+
+ y0+=PSXDisplay.DrawOffset.y-1;                        // a row of slack on both ends
+ y1+=PSXDisplay.DrawOffset.y+1;
+
+ for(i=0;i<iBands;i++)
+  if(y1>=lBandY[i] && y0<lBandY[i+1]) mask|=1u<<i;
+ return mask;
+}
+
+////////////////////////////////////////////////////////////////////////
+// called for each complete GP0 packet. Returns FALSE if the caller has
+// to run the prim itself (anything pending is flushed before).
+////////////////////////////////////////////////////////////////////////
+
+BOOL TileQueue(unsigned char command, uint32_t * pMem, void (* *primFunc)(unsigned char *))
+{
+ static const unsigned char polyVtx[8][4] =            // vertex words of the poly types
+  {{1,2,3,0},{1,3,5,0},{1,2,3,4},{1,3,5,7},
+   {1,3,5,0},{1,4,7,0},{1,3,5,7},{1,4,7,10}};
+ int len=primTableCX[command];
+ uint32_t flags=0,mask=0xffffffff;
+ int32_t y0,y1,y;
+ int i;
+
+ if(!iTileWorkers || primFunc!=primTableJ) goto SERIAL;
+
+ if(iBatchPos+len+2>BATCHSIZE) TileFlush();
+ if(!iBatchPos && !StartBatch()) return FALSE;
+
+ if(command==0xe1 || command==0xe2 || command==0xe6)  // tpage, tex window, mask bits
+  {
+   if(command==0xe1) SetTexPage(GETLE32(&pMem[0]));
+   if(command==0xe2) bTexWin=(GETLE32(&pMem[0])&0xfffff)!=0;
+   flags=TF_STATE;
+  }
+ else if(command>=0x20 && command<0x40)                // polys
+  {
+   const unsigned char * v=polyVtx[(command>>2)&7];
+
+   if(command&4)                                       // textured
+    {
+     SetTexPage(GETLE32(&pMem[TexPageWord(command)])>>16);
+     if(TexHazard(GETLE32(&pMem[2])>>16)) goto SERIAL;
+    }
+
+   y0=y1=VertexY(GETLE32(&pMem[v[0]]));
+   for(i=1;i<((command&8)?4:3);i++)
+    {
+     y=VertexY(GETLE32(&pMem[v[i]]));
+     if(y<y0) y0=y;
+     if(y>y1) y1=y;
+    }
+   mask=BandMask(y0,y1);
+  }
+ else if(command>=0x60 && command<0x80)                // tiles and sprites
+  {
+   if(PSXDisplay.DrawOffset.y<=-512) goto SERIAL;      // AdjustCoord1 may wrap y
+
+   if((command&4) && TexHazard(GETLE32(&pMem[2])>>16)) goto SERIAL;
+
+   switch(command&0xfc)
+    {
+     case 0x60: y=(GETLE32(&pMem[2])>>16)&iGPUHeightMask; break;
+     case 0x64: y=(GETLE32(&pMem[3])>>16)&0x1ff;         break;
+     case 0x68: y=1;                                      break;
+     case 0x70: case 0x74: y=8;                           break;
+     default:   y=16;                                     break;
+    }
+   y0=VertexY(GETLE32(&pMem[1]));
+   mask=BandMask(y0,y0+y);
+  }
+ else goto SERIAL;
+
+ ulBatch[iBatchPos]=command|(len<<8)|flags;
+ ulBatch[iBatchPos+1]=mask;
+ memcpy(&ulBatch[iBatchPos+2],pMem,len*4);
+ iBatchPos+=len+2;
+
+ if(!flags) bDoVSyncUpdate=TRUE;                       // even if binned away completely
+ return TRUE;
+
+SERIAL:
+ TileFlush();
+ return FALSE;
+}
+
+////////////////////////////////////////////////////////////////////////
+// pool
+////////////////////////////////////////////////////////////////////////
+
+void TileStart(void)
+{
+ int i,n=iTileThreads-1;                               // the drawing thread is one of them
+
+ if(iTileWorkers) return;
+ if(iGPUHeight==1024) return;                          // zinc: other tpage layout, keep it simple
+ if(n>MAXTILETHREADS) n=MAXTILETHREADS;
+
+ bTileQuit=FALSE;
+ iTileGen=0;
+ for(i=0;i<n;i++)
+  {
+   if(pthread_create(&thTile[i],NULL,TileWorker,NULL)!=0) break;
+   iTileWorkers++;
+  }
+}
+
+void TileStop(void)
+{
+ int i;
+
+ if(!iTileWorkers) return;
+
+ TileFlush();
+
+ pthread_mutex_lock(&mtxTile);
+ bTileQuit=TRUE;
+ pthread_cond_broadcast(&cndTileGo);
+ pthread_mutex_unlock(&mtxTile);
+
+ for(i=0;i<iTileWorkers;i++) pthread_join(thTile[i],NULL);
+ iTileWorkers=0;
+}
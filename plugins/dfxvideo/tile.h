@@ -0,0 +1,47 @@
+/***************************************************************************
+                          tile.h  -  description
+                             -------------------
+    begin                : Sun Oct 19 2026
+ ***************************************************************************/
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version. See also the license.txt file for *
+ *   additional informations.                                              *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef _TILE_INTERNALS_H
+#define _TILE_INTERNALS_H
+
+// copy of the per thread rasterizer state (the TLS vars)
+
+typedef struct DRAWSTATETAG
+{
+ short          g_m1,g_m2,g_m3;
+ short          DrawSemiTrans;
+ int32_t        GlobalTextAddrX,GlobalTextAddrY,GlobalTextTP;
+ int32_t        GlobalTextREST,GlobalTextABR,GlobalTextPAGE;
+ int            GlobalTextIL;
+ long           lLowerpart;
+ BOOL           bUsingTWin;
+ TWin_t         TWin;
+ unsigned short usMirror;
+ int            iDither;
+ int32_t        drawX,drawY,drawW,drawH;
+ BOOL           bCheckMask;
+ unsigned short sSetMask;
+ unsigned long  lSetMask;
+} DrawState_t;
+
+void SaveDrawState(DrawState_t * ds);
+void LoadDrawState(DrawState_t * ds);
+
+void TileStart(void);
+void TileStop(void);
+void TileFlush(void);
+BOOL TileQueue(unsigned char command, uint32_t * pMem, void (* *primFunc)(unsigned char *));
+
+#endif // _TILE_INTERNALS_H
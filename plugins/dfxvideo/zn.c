@@ -59,7 +59,7 @@ void CALLBACK GPUkeypressed(int keycode);
 uint32_t      dwGPUVersion=0;
 int           iGPUHeight=512;
 int           iGPUHeightMask=511;
-int           GlobalTextIL=0;
+TLS int       GlobalTextIL=0;                 // per thread, tile bands replay it
 int           iTileCheat=0;
 
 // --------------------------------------------------- //
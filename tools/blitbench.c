@@ -0,0 +1,217 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation, either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+* Check and time the display line converters of dfxvideo (blit.c).
+*
+* Every converter the cpu can run is compared with the scalar one: all
+* 15 bit colors, random 24 bit and xrgb lines of every length up to 64
+* at every start offset, source lines that end right before a
+* PROT_NONE page (so reading past 3*n+1 bytes faults), then a 640x480
+* frame is timed per level.
+*
+*   blitbench [-l loops] [-s seed]
+*/
+
+#include "externals.h"
+#include "blit.h"
+
+#include <time.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define W 640
+#define H 480
+#define MAXN 64
+
+enum { F_15, F_24, F_YUV15, F_YUV24, F_RGBYUV, F_MAX };
+
+static const char *funcname[F_MAX] = {
+	"15->xrgb", "24->xrgb", "15->yuy2", "24->yuy2", "xrgb->yuy2"
+};
+
+static uint32_t rnd_s = 1;
+
+static uint32_t rnd() {
+	rnd_s = rnd_s * 1103515245 + 12345;
+	return rnd_s >> 8;
+}
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* size bytes that end right at a page nobody may read */
+static unsigned char *guarded(size_t size) {
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t len = (size + page - 1) / page * page;
+	unsigned char *p;
+
+	p = (unsigned char *)mmap(NULL, len + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+	mprotect(p + len, page, PROT_NONE);
+	return p + len - size;
+}
+
+/* one call of converter f of b */
+static void run(BLITFUNCS *b, int f, uint32_t *dst, void *src, int n) {
+	switch (f) {
+		case F_15:     b->To32(dst, (unsigned short *)src, n); break;
+		case F_24:     b->To32_24(dst, (unsigned char *)src, n); break;
+		case F_YUV15:  b->ToYUV(dst, (unsigned short *)src, n); break;
+		case F_YUV24:  b->ToYUV_24(dst, (unsigned char *)src, n); break;
+		case F_RGBYUV: b->RGBToYUV(dst, (uint32_t *)src, n); break;
+	}
+}
+
+static int srcsize(int f, int n) {
+	switch (f) {
+		case F_15: case F_YUV15: return n * 2;
+		case F_24: case F_YUV24: return n * 3 + 1;
+		default:                 return n * 4;
+	}
+}
+
+static int dstcount(int f, int n) {
+	return f == F_RGBYUV ? n / 2 : n;
+}
+
+/* compare level k with scalar on n source pixels, returns mismatches */
+static int compare(int k, int f, unsigned char *src, int n) {
+	uint32_t want[MAXN + 1], got[MAXN + 1];
+	int i, bad = 0;
+
+	memset(want, 0xcd, sizeof(want));
+	memset(got, 0xcd, sizeof(got));
+	run(&BlitFuncs[BLIT_SCALAR], f, want, src, n);
+	run(&BlitFuncs[k], f, got, src, n);
+
+	for (i = 0; i <= dstcount(f, n); i++)              /* one past, nobody writes there */
+		if (want[i] != got[i]) bad++;
+	return bad;
+}
+
+static int check(int k, int f) {
+	static unsigned char buf[MAXN * 4 + 64];
+	unsigned char *g;
+	int n, ofs, i, bad = 0;
+	uint32_t c;
+
+	/* every 15 bit color once */
+	if (f == F_15 || f == F_YUV15) {
+		unsigned short col[MAXN];
+
+		for (c = 0; c < 65536; c += MAXN) {
+			for (i = 0; i < MAXN; i++) col[i] = c + i;
+			bad += compare(k, f, (unsigned char *)col, MAXN);
+		}
+	}
+
+	/* random lines, every length and start offset */
+	for (n = 0; n <= MAXN; n++) {
+		if (f == F_RGBYUV && (n & 1)) continue;
+		for (ofs = 0; ofs < 16; ofs++) {
+			for (i = 0; i < (int)sizeof(buf); i++) buf[i] = rnd();
+			bad += compare(k, f, buf + (f == F_24 || f == F_YUV24 ? ofs : ofs & ~1), n);
+		}
+
+		/* and right at the end of readable memory */
+		g = guarded(srcsize(f, n));
+		for (i = 0; i < srcsize(f, n); i++) g[i] = rnd();
+		bad += compare(k, f, g, n);
+	}
+
+	return bad;
+}
+
+/* best of loops for a full frame, in ms */
+static double timeframe(int k, int f, int loops, unsigned char *src, uint32_t *dst) {
+	double t, best = 1e30;
+	int l, y;
+
+	for (l = 0; l < loops; l++) {
+		t = now();
+		for (y = 0; y < H; y++)
+			run(&BlitFuncs[k], f, dst + y * W, src + y * 2048, W);
+		t = now() - t;
+		if (t < best) best = t;
+	}
+	return best / 1e6;
+}
+
+static void usage() {
+	fprintf(stderr, "usage: blitbench [-l loops] [-s seed]\n"
+		"\t-l loops\ttime the frame this often, best counts (default 50)\n"
+		"\t-s seed\t\tseed of the random lines (default 1)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	unsigned char *src;
+	uint32_t *dst;
+	double ms[BLIT_LEVELS][F_MAX];
+	int levels, loops = 50, bad = 0, b;
+	int i, k, f;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-l") && i + 1 < argc) loops = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc) rnd_s = atoi(argv[++i]);
+		else usage();
+	}
+	if (i != argc || loops < 1) usage();
+
+	levels = BlitCpuLevel() + 1;
+	while (levels > 1 && !BlitFuncs[levels - 1].name) levels--;
+
+	src = (unsigned char *)malloc(H * 2048 + W * 4);       /* vram pitch, xrgb lines overlap */
+	dst = (uint32_t *)malloc(W * H * 4);
+	for (i = 0; i < H * 2048 + W * 4; i++) src[i] = rnd();
+
+	for (k = 1; k < levels; k++) {
+		for (f = 0; f < F_MAX; f++) {
+			b = check(k, f);
+			if (b) printf("%s %s: %d pixels differ from scalar\n", BlitFuncs[k].name, funcname[f], b);
+			bad += b;
+		}
+	}
+
+	for (k = 0; k < levels; k++)
+		for (f = 0; f < F_MAX; f++)
+			ms[k][f] = timeframe(k, f, loops, src, dst);
+
+	printf("%dx%d frame, ms", W, H);
+	for (k = 0; k < levels; k++) printf("  %10s", BlitFuncs[k].name);
+	printf("\n");
+	for (f = 0; f < F_MAX; f++) {
+		printf("%-14s", funcname[f]);
+		for (k = 0; k < levels; k++) printf("  %10.3f", ms[k][f]);
+		printf("\n");
+	}
+	printf("bit exact with scalar: %s\n", levels == 1 ? "nothing to check" : bad ? "MISMATCH" : "ok");
+
+	free(src);
+	free(dst);
+
+	return bad ? 2 : 0;
+}
@@ -0,0 +1,311 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation, either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+* Offline replay of a CD-ROM access trace (pcsx -cdtrace FILE).
+*
+* The sector reads of the trace are played against a raw .bin image with
+* three access methods: stdio seek+read (what cdriso does), a memory map
+* of the whole image, and stdio behind an LRU cache of read-ahead blocks.
+* Prints the read latency distribution of each and the cache hit rate,
+* plus the emulated command latencies recorded in the trace.
+*
+*   cdrreplay [-s] [-c blocks] [-b sectors] trace image.bin
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "../libpcsxcore/cdrtrace.h"
+
+#define CD_FRAMESIZE_RAW	2352
+#define SUB_FRAMESIZE		96
+
+typedef struct {
+	unsigned int cycle;
+	unsigned int lba;
+	unsigned int latency;
+	unsigned char type, cmd, mode;
+} record_t;
+
+static record_t *recs;
+static int nrecs;
+
+static unsigned int *lbas;
+static int nreads;
+
+static long framesize = CD_FRAMESIZE_RAW;
+static int cacheblocks = 64;
+static int blocksectors = 16;
+
+static unsigned char sector[CD_FRAMESIZE_RAW + SUB_FRAMESIZE];
+
+static unsigned int get32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmpdouble(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static int cmpuint(const void *a, const void *b) {
+	unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+	return (x > y) - (x < y);
+}
+
+static void report(const char *name, double *ns, int n) {
+	double total = 0;
+	int i;
+
+	if (n == 0) return;
+
+	for (i = 0; i < n; i++) total += ns[i];
+	qsort(ns, n, sizeof(double), cmpdouble);
+
+	printf("%-8s reads %7d  total %9.2f ms  p50 %8.0f ns  p90 %8.0f ns  p99 %8.0f ns  max %9.0f ns\n",
+		name, n, total / 1e6, ns[n / 2], ns[n * 90 / 100], ns[n * 99 / 100], ns[n - 1]);
+}
+
+static int loadtrace(const char *filename) {
+	FILE *f;
+	unsigned char buf[CDRTRACE_RECSIZE];
+	int size = 0;
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+
+	if (fread(buf, 1, 12, f) != 12 || memcmp(buf, CDRTRACE_MAGIC, 8) || get32(buf + 8) != CDRTRACE_VERSION) {
+		fprintf(stderr, "%s: not a version %d CD-ROM trace\n", filename, CDRTRACE_VERSION);
+		fclose(f);
+		return -1;
+	}
+
+	while (fread(buf, 1, CDRTRACE_RECSIZE, f) == CDRTRACE_RECSIZE) {
+		if (nrecs == size) {
+			size = size ? size * 2 : 4096;
+			recs = (record_t *)realloc(recs, size * sizeof(record_t));
+		}
+		recs[nrecs].cycle = get32(buf + 0);
+		recs[nrecs].lba = get32(buf + 4);
+		recs[nrecs].latency = get32(buf + 8);
+		recs[nrecs].type = buf[12];
+		recs[nrecs].cmd = buf[13];
+		recs[nrecs].mode = buf[14];
+		nrecs++;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+// what the emulator saw while recording
+static void tracesummary() {
+	unsigned int count[256], maxlat[256], *host;
+	double sumlat[256];
+	int i, n = 0;
+
+	memset(count, 0, sizeof(count));
+	memset(maxlat, 0, sizeof(maxlat));
+	memset(sumlat, 0, sizeof(sumlat));
+
+	host = (unsigned int *)malloc((nreads + 1) * sizeof(unsigned int));
+
+	for (i = 0; i < nrecs; i++) {
+		if (recs[i].type == CDRTRACE_CMD) {
+			count[recs[i].cmd]++;
+			sumlat[recs[i].cmd] += recs[i].latency;
+			if (recs[i].latency > maxlat[recs[i].cmd]) maxlat[recs[i].cmd] = recs[i].latency;
+		}
+		else if (recs[i].type == CDRTRACE_READ) {
+			host[n++] = recs[i].latency;
+		}
+	}
+
+	printf("trace: %d records, %d sector reads, %u psx cycles\n", nrecs, nreads,
+		nrecs ? recs[nrecs - 1].cycle - recs[0].cycle : 0);
+
+	printf("command/irq   count   avg cycles   max cycles\n");
+	for (i = 0; i < 256; i++) {
+		if (count[i])
+			printf("  0x%02x     %8u   %10.0f   %10u\n", i, count[i], sumlat[i] / count[i], maxlat[i]);
+	}
+
+	if (n) {
+		qsort(host, n, sizeof(unsigned int), cmpuint);
+		printf("recorded CDR_readTrack: p50 %u us  p99 %u us  max %u us\n", host[n / 2], host[n * 99 / 100], host[n - 1]);
+	}
+
+	free(host);
+}
+
+static void replayraw(FILE *f, double *ns) {
+	double t;
+	int i;
+
+	for (i = 0; i < nreads; i++) {
+		t = now();
+		fseek(f, (long)lbas[i] * framesize, SEEK_SET);
+		fread(sector, 1, framesize, f);
+		ns[i] = now() - t;
+	}
+}
+
+static void replaymmap(const unsigned char *map, long size, double *ns) {
+	double t;
+	long offset;
+	int i;
+
+	for (i = 0; i < nreads; i++) {
+		t = now();
+		offset = (long)lbas[i] * framesize;
+		if (offset + framesize <= size)
+			memcpy(sector, map + offset, framesize);
+		ns[i] = now() - t;
+	}
+}
+
+static void replaycached(FILE *f, double *ns) {
+	unsigned char *data;
+	unsigned int *tag, *used, block;
+	unsigned int clock = 0;
+	int i, j, slot, hits = 0;
+	double t;
+
+	data = (unsigned char *)malloc((size_t)cacheblocks * blocksectors * framesize);
+	tag = (unsigned int *)malloc(cacheblocks * sizeof(unsigned int));
+	used = (unsigned int *)calloc(cacheblocks, sizeof(unsigned int));
+	for (j = 0; j < cacheblocks; j++) tag[j] = ~0U;
+
+	for (i = 0; i < nreads; i++) {
+		t = now();
+		block = lbas[i] / blocksectors;
+
+		slot = -1;
+		for (j = 0; j < cacheblocks; j++) {
+			if (tag[j] == block) {
+				slot = j;
+				hits++;
+				break;
+			}
+		}
+
+		if (slot < 0) {
+			// evict the least recently used block
+			slot = 0;
+			for (j = 1; j < cacheblocks; j++) {
+				if (used[j] < used[slot]) slot = j;
+			}
+			tag[slot] = block;
+			fseek(f, (long)block * blocksectors * framesize, SEEK_SET);
+			fread(data + (size_t)slot * blocksectors * framesize, 1, blocksectors * framesize, f);
+		}
+
+		used[slot] = ++clock;
+		memcpy(sector, data + ((size_t)slot * blocksectors + lbas[i] % blocksectors) * framesize, framesize);
+		ns[i] = now() - t;
+	}
+
+	report("cached", ns, nreads);
+	printf("cached   %d blocks of %d sectors, hit rate %.1f%%\n", cacheblocks, blocksectors,
+		nreads ? hits * 100.0 / nreads : 0.0);
+
+	free(data);
+	free(tag);
+	free(used);
+}
+
+static void usage() {
+	fprintf(stderr, "usage: cdrreplay [-s] [-c blocks] [-b sectors] trace image.bin\n"
+		"\t-s\t\timage has interleaved subchannel data\n"
+		"\t-c blocks\tcache size in blocks (default 64)\n"
+		"\t-b sectors\tread-ahead block size in sectors (default 16)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	struct stat st;
+	unsigned char *map;
+	double *ns;
+	FILE *f;
+	int i, j, fd;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-s")) framesize = CD_FRAMESIZE_RAW + SUB_FRAMESIZE;
+		else if (!strcmp(argv[i], "-c") && i + 1 < argc) cacheblocks = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc) blocksectors = atoi(argv[++i]);
+		else usage();
+	}
+	if (argc - i != 2 || cacheblocks < 1 || blocksectors < 1) usage();
+
+	if (loadtrace(argv[i]) == -1) return 1;
+
+	lbas = (unsigned int *)malloc((nrecs + 1) * sizeof(unsigned int));
+	for (nreads = 0, j = 0; j < nrecs; j++) {
+		if (recs[j].type == CDRTRACE_READ) lbas[nreads++] = recs[j].lba;
+	}
+
+	tracesummary();
+
+	f = fopen(argv[i + 1], "rb");
+	fd = open(argv[i + 1], O_RDONLY);
+	if (f == NULL || fd < 0 || fstat(fd, &st) == -1) {
+		perror(argv[i + 1]);
+		return 1;
+	}
+
+	ns = (double *)malloc((nreads + 1) * sizeof(double));
+
+	// the first pass also warms the host page cache for the others
+	replayraw(f, ns);
+	replayraw(f, ns);
+	report("raw", ns, nreads);
+
+	map = (unsigned char *)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map != MAP_FAILED) {
+		replaymmap(map, st.st_size, ns);
+		report("mmap", ns, nreads);
+		munmap(map, st.st_size);
+	}
+
+	replaycached(f, ns);
+
+	free(ns);
+	free(lbas);
+	free(recs);
+	fclose(f);
+	close(fd);
+
+	return 0;
+}
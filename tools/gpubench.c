@@ -0,0 +1,309 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation, either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+* Rasterizer microbenchmark for the dfxvideo soft renderer.
+*
+* Replays a primitive list (raw little endian GP0 words, as sent by GPU
+* DMA) straight into the prim funcs of prim.c/soft.c, once with the old
+* per pixel loops and once with the span kernels. Prints the cost per
+* primitive class and checks both leave the same VRAM behind. Without a
+* list file a random one is generated.
+*
+*   gpubench [-l loops] [-s seed] [-n prims] [list.gp0]
+*/
+
+#include "externals.h"
+#include "prim.h"
+#include "swap.h"
+
+#include <time.h>
+
+// what gpu.c/draw.c would provide
+
+TLS BOOL bCheckMask = FALSE;
+TLS unsigned short sSetMask = 0;
+TLS unsigned long lSetMask = 0;
+TLS long lLowerpart;
+
+VRAMLoad_t VRAMWrite, VRAMRead;
+DATAREGISTERMODES DataWriteMode, DataReadMode;
+PSXDisplay_t PSXDisplay;
+long lGPUstatusRet;
+unsigned char *psxVSecure, *psxVub;
+unsigned short *psxVuw;
+uint32_t lGPUInfoVals[16];
+uint32_t dwGPUVersion = 0;
+int iGPUHeight = 512, iGPUHeightMask = 511;
+TLS int GlobalTextIL = 0;
+int iTileCheat = 0;
+TLS BOOL bTileBand = FALSE;
+
+enum { C_FLAT, C_GOURAUD, C_TEX, C_GTEX, C_LINE, C_TILE, C_SPRITE, C_FILL, C_STATE, C_MAX };
+
+static const char *classname[C_MAX] = {
+	"flat", "gouraud", "textured", "gtextured", "line", "tile", "sprite", "fill", "state"
+};
+
+static uint32_t *list;
+static int nwords;
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* words in the packet at p, 0 for the ones that can't be replayed here
+   (poly lines and vram transfers need the gpu.c data port state machine) */
+static int packetsize(uint32_t *p, int left, int *cls) {
+	uint32_t cmd = GETLE32(p) >> 24;
+	int n;
+
+	*cls = C_STATE;
+
+	if (cmd >= 0x20 && cmd < 0x40) {
+		int v = (cmd & 8) ? 4 : 3;
+		n = 1 + v * ((cmd & 4) ? 2 : 1) + ((cmd & 0x10) ? v - 1 : 0);
+		*cls = (cmd & 0x10) ? ((cmd & 4) ? C_GTEX : C_GOURAUD) : ((cmd & 4) ? C_TEX : C_FLAT);
+	} else if (cmd >= 0x40 && cmd < 0x60) {
+		if (cmd & 8) {
+			for (n = 3; n < left; n++)
+				if ((GETLE32(&p[n]) & 0xf000f000) == 0x50005000) break;
+			return -(n + 1);
+		}
+		n = (cmd & 0x10) ? 4 : 3;
+		*cls = C_LINE;
+	} else if (cmd >= 0x60 && cmd < 0x80) {
+		n = 2 + ((cmd & 4) ? 1 : 0) + (((cmd & 0x18) == 0) ? 1 : 0);
+		*cls = (cmd & 4) ? C_SPRITE : C_TILE;
+	} else if (cmd == 0x02) {
+		n = 3;
+		*cls = C_FILL;
+	} else if (cmd == 0x80) {
+		return -4;
+	} else if (cmd == 0xa0) {
+		uint32_t wh = left > 2 ? GETLE32(&p[2]) : 0;
+		return -(3 + (int)(((wh & 0xffff) * (wh >> 16) + 1) >> 1));
+	} else if (cmd == 0xc0) {
+		return -3;
+	} else n = 1;
+
+	return n;
+}
+
+static uint32_t rnd_s;
+
+static uint32_t rnd() {
+	rnd_s = rnd_s * 1103515245 + 12345;
+	return rnd_s >> 8;
+}
+
+static uint32_t xy(int x, int y) {
+	return ((uint32_t)(y & 0xffff) << 16) | (x & 0xffff);
+}
+
+// a mix of everything, textures and cluts outside the 640x480 draw area
+static void generate(int prims) {
+	int i, k;
+
+	list = (uint32_t *)malloc((prims * 16 + 16) * sizeof(uint32_t));
+	nwords = 0;
+	list[nwords++] = 0xe3000000;
+	list[nwords++] = 0xe4000000 | (479 << 10) | 639;
+	list[nwords++] = 0xe5000000;
+
+	for (i = 0; i < prims; i++) {
+		int r = rnd() % 100;
+		uint32_t c = rnd() & 0x03ffffff;
+		uint32_t tpage = (10 + rnd() % 4) | ((rnd() % 3) << 7) | ((rnd() & 3) << 5);
+		uint32_t clut = ((480 + rnd() % 30) << 6) | (rnd() % 40);
+
+		if (r < 2) list[nwords++] = 0xe6000000 | (rnd() & 3);
+		else if (r < 6) {
+			list[nwords++] = (0x02 << 24) | (rnd() & 0xffffff);
+			list[nwords++] = xy(rnd() % 600, rnd() % 440);
+			list[nwords++] = xy(16 + rnd() % 64, 1 + rnd() % 64);
+		} else if (r < 10) {
+			list[nwords++] = ((0x40 | ((rnd() & 1) << 4) | (rnd() & 2)) << 24) | c;
+			if (list[nwords - 1] & 0x10000000) {
+				list[nwords++] = xy(rnd() % 640, rnd() % 480);
+				list[nwords++] = rnd() & 0xffffff;
+			} else list[nwords++] = xy(rnd() % 640, rnd() % 480);
+			list[nwords++] = xy(rnd() % 640, rnd() % 480);
+		} else if (r < 70) {
+			int cmd = 0x20 + ((rnd() % 8) << 2) + (rnd() & 2);
+			int v = (cmd & 8) ? 4 : 3;
+			int cx = rnd() % 640, cy = rnd() % 480, sz = 8 + rnd() % ((rnd() % 8) ? 64 : 256);
+
+			list[nwords++] = (cmd << 24) | c;
+			for (k = 0; k < v; k++) {
+				if ((cmd & 0x10) && k) list[nwords++] = rnd() & 0xffffff;
+				list[nwords++] = xy(cx + ((k & 1) ? sz : 0), cy + ((k & 2) ? sz : 0));
+				if (cmd & 4) list[nwords++] = ((k == 0 ? clut : k == 1 ? tpage : 0) << 16) |
+					(((k & 1) ? 255 : 0) | (((k & 2) ? 255 : 0) << 8));
+			}
+		} else {
+			static const int cmds[7] = { 0x60, 0x64, 0x68, 0x70, 0x74, 0x78, 0x7c };
+			int cmd = cmds[rnd() % 7] | (rnd() & 2);
+
+			list[nwords++] = (cmd << 24) | c;
+			list[nwords++] = xy(rnd() % 600, rnd() % 440);
+			if (cmd & 4) list[nwords++] = (clut << 16) | (rnd() & 0xffff);
+			if ((cmd & 0x18) == 0) list[nwords++] = xy(1 + rnd() % 64, 1 + rnd() % 64);
+		}
+	}
+}
+
+static int loadlist(const char *filename) {
+	FILE *f;
+	long size;
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	list = (uint32_t *)malloc(size + 4);
+	nwords = fread(list, 1, size, f) / 4;
+	fclose(f);
+
+	return 0;
+}
+
+// same vram and drawing state for both runs, like a gp1 reset would leave it
+static void reset() {
+	int i;
+
+	for (i = 0; i < 1024 * 512; i++) psxVuw[i] = (unsigned short)(i * 2654435761u >> 13);
+
+	memset(&PSXDisplay, 0, sizeof(PSXDisplay));
+	lGPUstatusRet = 0x14802000;
+
+	drawX = drawY = 0; drawW = drawH = 0;
+	sSetMask = 0; lSetMask = 0; bCheckMask = FALSE;
+	usMirror = 0; iDither = 0;
+	GlobalTextAddrX = 0; GlobalTextAddrY = 0;
+	GlobalTextTP = 0; GlobalTextABR = 0; GlobalTextREST = 0;
+	DrawSemiTrans = FALSE;
+	bUsingTWin = FALSE;
+}
+
+static uint32_t vramhash() {
+	uint32_t h = 2166136261u;
+	int i;
+
+	for (i = 0; i < 1024 * 512; i++) {
+		h ^= psxVuw[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static uint32_t replay(int loops, double *ns, int *count, int *skipped) {
+	uint32_t buf[256], hash = 0;
+	double t;
+	int i, n, cls, l;
+
+	memset(ns, 0, C_MAX * sizeof(double));
+	memset(count, 0, C_MAX * sizeof(int));
+	*skipped = 0;
+
+	reset();
+
+	for (l = 0; l < loops; l++) {
+		for (i = 0; i < nwords; i += n) {
+			n = packetsize(&list[i], nwords - i, &cls);
+			if (n < 0) {
+				n = -n;
+				if (l == 0) (*skipped)++;
+				continue;
+			}
+			if (i + n > nwords || n > 256) break;
+
+			memcpy(buf, &list[i], n * 4);                 // the prim funcs may scribble on it
+
+			t = now();
+			primTableJ[GETLE32(buf) >> 24]((unsigned char *)buf);
+			ns[cls] += now() - t;
+			count[cls]++;
+		}
+		if (l == 0) hash = vramhash();
+	}
+
+	return hash;
+}
+
+static void usage() {
+	fprintf(stderr, "usage: gpubench [-l loops] [-s seed] [-n prims] [list.gp0]\n"
+		"\t-l loops\treplay the list this often (default 20)\n"
+		"\t-s seed\t\tseed of the generated list (default 1)\n"
+		"\t-n prims\tprims in the generated list (default 20000)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	double ns[2][C_MAX];
+	int count[2][C_MAX], skipped, loops = 20, prims = 20000;
+	uint32_t hash[2];
+	int i, k;
+
+	rnd_s = 1;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-l") && i + 1 < argc) loops = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc) rnd_s = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc) prims = atoi(argv[++i]);
+		else usage();
+	}
+	if (argc - i > 1 || loops < 1 || prims < 1) usage();
+
+	if (argc - i == 1) {
+		if (loadlist(argv[i]) == -1) return 1;
+	} else generate(prims);
+
+	psxVSecure = (unsigned char *)calloc(1, (iGPUHeight * 2) * 1024 + (1024 * 1024));
+	psxVub = psxVSecure + 512 * 1024;
+	psxVuw = (unsigned short *)psxVub;
+
+	for (k = 0; k < 2; k++) {
+		iUseSpanKernels = k;
+		hash[k] = replay(loops, ns[k], count[k], &skipped);
+	}
+
+	printf("list: %d words, %d packets skipped (poly lines, vram transfers)\n", nwords, skipped);
+	printf("class        count    loops ns/prim   kernels ns/prim   speedup\n");
+	for (i = 0; i < C_MAX; i++) {
+		if (count[0][i] == 0) continue;
+		printf("%-10s %8d   %14.1f   %15.1f   %6.2fx\n", classname[i], count[0][i] / loops,
+			ns[0][i] / count[0][i], ns[1][i] / count[1][i],
+			ns[1][i] > 0 ? ns[0][i] / ns[1][i] : 0.0);
+	}
+	printf("vram hash: loops %08x  kernels %08x  %s\n", hash[0], hash[1],
+		hash[0] == hash[1] ? "ok" : "MISMATCH");
+
+	free(psxVSecure);
+	free(list);
+
+	return hash[0] == hash[1] ? 0 : 2;
+}
@@ -0,0 +1,443 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation, either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+* Offline replay of a dfxvideo gpu capture (F11 in the plugin, see
+* plugins/dfxvideo/capture.h).
+*
+* The capture is fed through the plugin's own gpu.c entry points, as fast
+* as possible. Only gpu.c and the rasterizer (prim, soft, span, tile,
+* thread, dirty, capture) are linked: the display, pacing and zn side is
+* stubbed out below, so no X server or X11 lib is needed. Prints the frame time
+* distribution (best of all loops) and, from an extra pass with every
+* prim func wrapped in a timer, the cost per primitive type. The vram
+* hash after each frame can be saved with -w and checked against an
+* earlier run with -c, to catch rendering regressions.
+*
+*   gpureplay [-l loops] [-t threads] [-k] [-v] [-w hashes] [-c hashes] capture.gcap
+*/
+
+#include "externals.h"
+#include "prim.h"
+#include "swap.h"
+#include "tile.h"
+#include "capture.h"
+
+#include <time.h>
+
+// what draw.c, fps.c, menu.c, key.c and cfg.c would provide
+
+int iResX, iResY;
+TLS long lLowerpart;
+BOOL bIsFirstFrame = TRUE;
+TLS BOOL bCheckMask = FALSE;
+TLS unsigned short sSetMask = 0;
+TLS unsigned long lSetMask = 0;
+int iDesktopCol = 16, iMaintainAspect = 0, iUseNoStretchBlt = 0, iFastFwd = 0;
+PSXPoint_t ptCursorPoint[8];
+unsigned short usCursorActive = 0;
+Display *display;
+Window window;
+int root_window_id = 0;
+char *pCaptionText;
+
+float fFrameRateHz = 0, fFrameRate, fps_skip = 0, fps_cur = 0;
+int iFrameLimit, UseFrameLimit = 0, UseFrameSkip = 0;
+uint32_t dwCoreFlags = 0;
+unsigned long ulKeybits = 0;
+
+void DoBufferSwap(void) {}
+void DoClearScreenBuffer(void) {}
+void DoClearFrontBuffer(void) {}
+unsigned long ulInitDisplay(void) { return 0; }
+void CloseDisplay(void) {}
+void CreatePic(unsigned char *pMem) {}
+void DestroyPic(void) {}
+void FrameSkip(void) {}
+void PCFrameCap(void) {}
+void PCcalcfps(void) {}
+void SetAutoFrameCap(void) {}
+void SetFPSHandler(void) {}
+void InitFPS(void) {}
+void CheckFrameRate(void) {}
+void BuildDispMenu(int iInc) {}
+void ReleaseKeyHandler(void) {}
+void GPUkeypressed(int keycode) {}
+void ReadConfig(void) {}
+void SoftDlgProc(void) {}
+void AboutDlgProc(void) {}
+
+// what zn.c and pace.c would provide
+
+uint32_t dwGPUVersion = 0;
+int iGPUHeight = 512, iGPUHeightMask = 511;
+TLS int GlobalTextIL = 0;
+int iTileCheat = 0;
+
+void PaceInit(void) {}
+void PacePresentStart(void) {}
+void PacePresentEnd(void) {}
+void PaceReport(void) {}
+
+// the Xlib calls of ChangeWindowMode in gpu.c, never made here
+
+Atom XInternAtom(Display *d, _Xconst char *name, Bool exists) { return None; }
+int XChangeProperty(Display *d, Window w, Atom p, Atom t, int f, int m, _Xconst unsigned char *data, int n) { return 0; }
+int XResizeWindow(Display *d, Window w, unsigned int width, unsigned int height) { return 0; }
+Status XSendEvent(Display *d, Window w, Bool prop, long mask, XEvent *ev) { return 0; }
+void XSetWMNormalHints(Display *d, Window w, XSizeHints *hints) {}
+
+// gpu.c entry points, same layout as GPUFreeze_t in there
+
+typedef struct {
+	uint32_t ulFreezeVersion;
+	uint32_t ulStatus;
+	uint32_t ulControl[256];
+	unsigned char psxVRam[1024 * 1024 * 2];
+} freeze_t;
+
+long GPUinit(void);
+long GPUshutdown(void);
+void GPUwriteDataMem(uint32_t *pMem, int iSize);
+void GPUwriteStatus(uint32_t gdata);
+void GPUreadDataMem(uint32_t *pMem, int iSize);
+void GPUupdateLace(void);
+long GPUfreeze(uint32_t ulGetFreezeData, freeze_t *pF);
+
+static uint32_t *cap;			/* the capture, header stripped */
+static int capwords;
+static int nframes;
+
+static freeze_t freeze;
+static uint32_t readbuf[CAP_MAXCOUNT + 1];
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmpdouble(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static uint32_t vramhash() {
+	uint32_t h = 2166136261u;
+	int i;
+
+	for (i = 0; i < 1024 * iGPUHeight; i++) {
+		h ^= psxVuw[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static int loadcapture(const char *filename) {
+	FILE *f;
+	uint32_t hdr[5];
+	long size;
+	int i;
+
+	f = fopen(filename, "rb");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+
+	if (fread(hdr, 4, 5, f) != 5 || memcmp(hdr, CAP_MAGIC, 8) || GETLE32(&hdr[2]) != CAP_VERSION) {
+		fprintf(stderr, "%s: not a version %d gpu capture\n", filename, CAP_VERSION);
+		fclose(f);
+		return -1;
+	}
+	iGPUHeight = GETLE32(&hdr[3]) == 1024 ? 1024 : 512;
+	iGPUHeightMask = iGPUHeight - 1;
+	dwGPUVersion = GETLE32(&hdr[4]);
+
+	fseek(f, 0, SEEK_END);
+	size = ftell(f) - 20;
+	fseek(f, 20, SEEK_SET);
+
+	cap = (uint32_t *)malloc(size + 4);
+	capwords = fread(cap, 1, size, f) / 4;
+	fclose(f);
+
+	/* check the record chain once, so the replay loop can trust it */
+	for (i = 0; i < capwords; ) {
+		uint32_t tag = GETLE32(&cap[i++]);
+		int n = CAP_COUNT(tag);
+
+		switch (CAP_TYPE(tag)) {
+			case CAP_STATE: n = CAP_STATEWORDS + 512 * iGPUHeight; break;
+			case CAP_STATUS: n = 1; break;
+			case CAP_READ: n = 0; break;
+			case CAP_VSYNC: n = 0; nframes++; break;
+			case CAP_DATA: case CAP_DMA: break;
+			default: n = -1; break;
+		}
+		if (n < 0 || i + n > capwords) {
+			fprintf(stderr, "%s: damaged at word %d, using %d frames\n", filename, i - 1, nframes);
+			break;
+		}
+		i += n;
+	}
+	capwords = i;
+
+	if (nframes == 0 || GETLE32(&cap[0]) != CAP_TAG(CAP_STATE, 0)) {
+		fprintf(stderr, "%s: no complete frame\n", filename);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void loadstate(uint32_t *p) {
+	int i;
+
+	freeze.ulFreezeVersion = 1;
+	freeze.ulStatus = GETLE32(&p[0]);
+	for (i = 0; i < 256; i++) freeze.ulControl[i] = GETLE32(&p[1 + i]);
+	memcpy(freeze.psxVRam, &p[CAP_STATEWORDS], 1024 * iGPUHeight * 2);
+
+	GPUfreeze(0, &freeze);
+	GPUwriteDataMem(&p[257], 6);		/* e1..e6 */
+}
+
+/* one pass over the capture, fills frame times and (if wanted) hashes */
+static void replay(double *frame, uint32_t *hash) {
+	double t;
+	int i, f = 0;
+
+	t = now();
+	for (i = 0; i < capwords; ) {
+		uint32_t tag = GETLE32(&cap[i++]);
+		int n = CAP_COUNT(tag);
+
+		switch (CAP_TYPE(tag)) {
+			case CAP_STATE:
+				loadstate(&cap[i]);
+				i += CAP_STATEWORDS + 512 * iGPUHeight;
+				break;
+			case CAP_DATA:
+			case CAP_DMA:
+				GPUwriteDataMem(&cap[i], n);
+				i += n;
+				break;
+			case CAP_STATUS:
+				GPUwriteStatus(GETLE32(&cap[i]));
+				i++;
+				break;
+			case CAP_READ:
+				GPUreadDataMem(readbuf, n);
+				break;
+			case CAP_VSYNC:
+				GPUupdateLace();
+				frame[f] = now() - t;
+				if (hash) hash[f] = vramhash();
+				f++;
+				t = now();
+				break;
+		}
+	}
+}
+
+// per prim cost: every prim func goes through a timer
+
+static void (*realprim[256])(unsigned char *);
+static double primns[256];
+static int primcount[256];
+static char primname[256][16];
+
+static void timedprim(unsigned char *baseAddr) {
+	int cmd = baseAddr[3];
+	double t = now();
+
+	realprim[cmd](baseAddr);
+	primns[cmd] += now() - t;
+	primcount[cmd]++;
+}
+
+static void nameprims() {
+	int c;
+
+	for (c = 0; c < 256; c++) {
+		if (c >= 0x20 && c < 0x40)
+			sprintf(primname[c], "poly %s%s%d", (c & 0x10) ? "g" : "f", (c & 4) ? "t" : "", (c & 8) ? 4 : 3);
+		else if (c >= 0x40 && c < 0x60)
+			sprintf(primname[c], "line %s%s", (c & 0x10) ? "g" : "f", (c & 8) ? " poly" : "");
+		else if (c >= 0x60 && c < 0x80) {
+			static const char *size[4] = { "", " 1", " 8", " 16" };
+			sprintf(primname[c], "%s%s", (c & 4) ? "sprite" : "tile", size[(c >> 3) & 3]);
+		}
+		else if (c == 0x02) strcpy(primname[c], "fill");
+		else if (c >= 0x80 && c < 0xa0) strcpy(primname[c], "vram copy");
+		else if (c >= 0xa0 && c < 0xc0) strcpy(primname[c], "vram write");
+		else if (c >= 0xc0 && c < 0xe0) strcpy(primname[c], "vram read");
+		else if (c >= 0xe1 && c <= 0xe6) strcpy(primname[c], "state");
+		else strcpy(primname[c], "other");
+	}
+}
+
+static void profile() {
+	double *fr;
+	double total = 0;
+	int c, d, count;
+
+	nameprims();
+	for (c = 0; c < 256; c++) {
+		realprim[c] = primTableJ[c];
+		primTableJ[c] = timedprim;
+	}
+
+	fr = (double *)malloc(nframes * sizeof(double));
+	replay(fr, NULL);
+	free(fr);
+
+	for (c = 0; c < 256; c++) {
+		primTableJ[c] = realprim[c];
+		total += primns[c];
+	}
+
+	printf("\nprim          count    ns/prim   total ms   share\n");
+	for (c = 0; c < 256; c++) {
+		double ns = 0;
+
+		if (primcount[c] == 0) continue;
+		for (d = 0; d < c; d++)
+			if (primcount[d] && !strcmp(primname[d], primname[c])) break;
+		if (d < c) continue;		/* already printed */
+
+		count = 0;
+		for (d = c; d < 256; d++) {
+			if (primcount[d] && !strcmp(primname[d], primname[c])) {
+				ns += primns[d];
+				count += primcount[d];
+			}
+		}
+		printf("%-12s %6d  %9.1f  %9.2f  %5.1f%%\n", primname[c], count, ns / count, ns / 1e6,
+			total > 0 ? ns * 100 / total : 0.0);
+	}
+}
+
+static int checkhashes(const char *filename, uint32_t *hash) {
+	FILE *f;
+	unsigned int h;
+	int frame, bad = 0, first = -1;
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+	while (fscanf(f, "%d %x", &frame, &h) == 2) {
+		if (frame < 0 || frame >= nframes) continue;
+		if (hash[frame] != h) {
+			if (first < 0) first = frame;
+			bad++;
+		}
+	}
+	fclose(f);
+
+	if (bad) printf("vram hash: %d frames differ from %s, first is frame %d\n", bad, filename, first);
+	else printf("vram hash: all frames match %s\n", filename);
+
+	return bad;
+}
+
+static void usage() {
+	fprintf(stderr, "usage: gpureplay [-l loops] [-t threads] [-k] [-v] [-w hashes] [-c hashes] capture.gcap\n"
+		"\t-l loops\treplay the capture this often, frame times are the best of all (default 5)\n"
+		"\t-t threads\tdraw with this many band threads (default 0)\n"
+		"\t-k\t\tno span kernels\n"
+		"\t-v\t\tprint every frame\n"
+		"\t-w file\t\twrite the vram hash of each frame to file\n"
+		"\t-c file\t\tcompare the vram hashes with file\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	const char *writefile = NULL, *checkfile = NULL;
+	double *best, *frame, *sorted, total = 0;
+	uint32_t *hash;
+	int loops = 5, verbose = 0, bad = 0;
+	int i, l;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-l") && i + 1 < argc) loops = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc) iTileThreads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-k")) iUseSpanKernels = 0;
+		else if (!strcmp(argv[i], "-v")) verbose = 1;
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc) writefile = argv[++i];
+		else if (!strcmp(argv[i], "-c") && i + 1 < argc) checkfile = argv[++i];
+		else usage();
+	}
+	if (argc - i != 1 || loops < 1) usage();
+
+	if (loadcapture(argv[i]) == -1) return 1;
+	if (GPUinit() != 0) return 1;
+
+	best = (double *)malloc(nframes * sizeof(double));
+	frame = (double *)malloc(nframes * sizeof(double));
+	sorted = (double *)malloc(nframes * sizeof(double));
+	hash = (uint32_t *)malloc(nframes * sizeof(uint32_t));
+
+	TileStart();
+	for (l = 0; l < loops; l++) {
+		replay(frame, l == 0 ? hash : NULL);
+		for (i = 0; i < nframes; i++)
+			if (l == 0 || frame[i] < best[i]) best[i] = frame[i];
+	}
+	TileStop();
+
+	for (i = 0; i < nframes; i++) {
+		total += best[i];
+		if (verbose) printf("frame %6d  %8.3f ms  %08x\n", i, best[i] / 1e6, hash[i]);
+	}
+	memcpy(sorted, best, nframes * sizeof(double));
+	qsort(sorted, nframes, sizeof(double), cmpdouble);
+
+	printf("%s: %d frames, %d words, %d band threads, span kernels %s\n", argv[argc - 1],
+		nframes, capwords, iTileThreads, iUseSpanKernels ? "on" : "off");
+	printf("frame time: total %.2f ms  mean %.3f ms  p50 %.3f ms  p90 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+		total / 1e6, total / nframes / 1e6, sorted[nframes / 2] / 1e6, sorted[nframes * 90 / 100] / 1e6,
+		sorted[nframes * 99 / 100] / 1e6, sorted[nframes - 1] / 1e6);
+
+	profile();
+	printf("\n");
+
+	if (writefile) {
+		FILE *f = fopen(writefile, "w");
+
+		if (f == NULL) perror(writefile);
+		else {
+			for (i = 0; i < nframes; i++) fprintf(f, "%d %08x\n", i, hash[i]);
+			fclose(f);
+		}
+	}
+	if (checkfile) bad = checkhashes(checkfile, hash);
+
+	GPUshutdown();
+	free(best);
+	free(frame);
+	free(sorted);
+	free(hash);
+	free(cap);
+
+	return bad ? 2 : 0;
+}
@@ -0,0 +1,460 @@
+/*  PCSX-Revolution - PS Emulator for Nintendo Wii
+ *  Copyright (C) 2009-2010  PCSX-Revolution Dev Team
+ *
+ *  PCSX-Revolution is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation, either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  PCSX-Revolution is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with PCSX-Revolution.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+* Offline run of the dfsound mixer on a synthetic workload.
+*
+* The plugin's own spu.c runs in cycle mixing mode, with the config and
+* the output ring stubbed out: random adpcm data in spu ram, 24 voices
+* keyed on and off, their registers, the reverb and cd audio poked with
+* random values between the SPUasync calls, and the irq callback
+* writing registers as well. All of it comes from a fixed seed, so two
+* builds of the mixer can be compared: the hash of the output after
+* each checkpoint (every 64 calls) can be saved with -w and checked
+* against an earlier run with -c. Prints the mixing throughput (best of
+* all loops). -a keeps all but the first voices at volume 0, the way
+* most games leave most of them. With -o the output of the first loop
+* also goes through the plugin's filesnd.c into a .wav (or raw) file.
+* -f checks the save states: the first loop saves a full one at 1/4
+* and a delta (mode 3) at 1/2, then both get loaded and the rest of the
+* workload runs again from there, its output has to be the same.
+* A hash file starts with a line "@ <options>" (interpolation, reverb,
+* x, m, audible voices, b), -c only looks at the sections of the options
+* it runs with, so one file holds several runs: spubench.golden has them
+* from before the slice at a time Neill reverb ("make check").
+* -b batches the random writes of each call the way the emu does
+* (SPUwriteRegisters before SPUasync, spread over the call's cycles),
+* so they land on their sample; the output differs from the unbatched
+* run then, the workload is the same.
+*
+*   spubench [-n calls] [-l loops] [-i interpolation] [-r reverb] [-m] [-x] [-a voices] [-w hashes] [-c hashes] [-o file] [-f] [-b]
+*/
+
+#include "stdafx.h"
+#include "externals.h"
+#include "filesnd.h"
+
+#include <time.h>
+
+#define CHECKPOINT 64
+
+// what cfg.c and ring.c would provide
+
+static int cfginterp = 2, cfgreverb = 2, cfgmono = 0;
+
+void ReadConfig(void) {
+	iVolume = 3;
+	iXAPitch = 0;
+	iSPUIRQWait = 1;
+	iUseTimer = 2;
+	iUseReverb = cfgreverb;
+	iUseInterpolation = cfginterp;
+	iDisStereo = cfgmono;
+	iCycleMixing = 1;
+}
+
+void StartCfgTool(char *pCmdLine) {}
+
+static uint32_t outhash;
+static long outsamples;
+static int outfile;
+
+void RingStart(void) {}
+void RingStop(void) {}
+
+int RingWrite(short *pSound, int iSamples) {
+	unsigned char *b = (unsigned char *)pSound;
+	int i;
+
+	for (i = 0; i < iSamples * 2; i++) {
+		outhash ^= b[i];
+		outhash *= 16777619;
+	}
+	outsamples += iSamples;
+	if (outfile) FileSndWrite(pSound, iSamples);
+	return iSamples;
+}
+
+int RingFull(void) { return 0; }
+
+// spu.c entry points
+
+long CALLBACK SPUinit(void);
+long CALLBACK SPUshutdown(void);
+long CALLBACK SPUopen(void);
+long CALLBACK SPUclose(void);
+void CALLBACK SPUasync(unsigned long cycle);
+void CALLBACK SPUwriteRegister(unsigned long reg, unsigned short val);
+void CALLBACK SPUwriteRegisters(SPUWrite_t *pW, int iCount);
+void CALLBACK SPUwriteDMAMem(unsigned short *pusPSXMem, int iSize);
+void CALLBACK SPUregisterCallback(void (CALLBACK *callback)(void));
+void CALLBACK SPUplayCDDAchannel(short *pcm, int nbytes);
+long CALLBACK SPUfreeze(uint32_t ulFreezeMode, void *pF);
+
+// the "room" preset, 1DC0...1DFE
+static const unsigned short room[32] = {
+	0x007D, 0x005B, 0x6D80, 0x54B8, 0xBED0, 0x0000, 0x0000, 0xBA80,
+	0x5800, 0x5300, 0x04D6, 0x0333, 0x03F0, 0x0227, 0x0374, 0x01EF,
+	0x0334, 0x01B5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x01B4, 0x0136, 0x00B8, 0x005C, 0x8000, 0x8000
+};
+
+static unsigned short psxram[256 * 1024];
+static short cdda[588 * 2];
+static uint32_t seed;
+static int irqs;
+static int audible = 24;
+static int freezecheck;
+static int batch;
+static SPUWrite_t queue[32];
+static int queued = -1;		/* -1: writes go straight to the plugin */
+
+static uint32_t rnd() {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) & 0xffffff;
+}
+
+static void reg(unsigned int r, unsigned short v) {
+	if (queued < 0) SPUwriteRegister(0x1f801000 | r, v);
+	else {
+		queue[queued].reg = 0x1000 | r;
+		queue[queued].val = v;
+		queued++;
+	}
+}
+
+// volume register value for voice ch: 0 for the muted ones
+static unsigned short voicevol(int ch, unsigned short v) {
+	return ch < audible ? v : 0;
+}
+
+static void CALLBACK irq(void) {
+	irqs++;
+	outhash ^= (uint32_t)outsamples;
+	outhash *= 16777619;
+	reg(0xc00 + (irqs % 24) * 16, voicevol(irqs % 24, rnd() & 0x3fff));
+}
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// random adpcm blocks with some loop start/end/repeat flags, the last
+// ones end the voice so it doesn't play past spu ram
+static void setupram() {
+	unsigned char *m = (unsigned char *)psxram, *blk;
+	int b, i, fl;
+
+	for (b = 0; b < 512 * 1024 / 16; b++) {
+		blk = m + b * 16;
+		blk[0] = ((rnd() % 4) << 4) | (rnd() % 11 + 1);
+		fl = rnd() % 16;
+		blk[1] = fl == 0 ? 1 : fl == 1 ? 3 : fl == 2 ? 4 : 0;
+		for (i = 2; i < 16; i++) blk[i] = rnd();
+	}
+	m[512 * 1024 - 16 + 1] = 1;
+	m[512 * 1024 - 32 + 1] = 1;
+
+	reg(0xda6, 0);
+	SPUwriteDMAMem(psxram, 256 * 1024);
+}
+
+static void setupregs(int randomreverb) {
+	int i;
+
+	reg(0xdaa, 0xc0c0);
+	reg(0xd84, 0x3000);
+	reg(0xd86, 0x3000);
+	if (randomreverb) {
+		reg(0xda2, 0xc000);
+		for (i = 0; i < 32; i++) reg(0xdc0 + i * 2, rnd() & 0xffff);
+	} else {
+		reg(0xda2, 0xf000);
+		for (i = 0; i < 32; i++) reg(0xdc0 + i * 2, room[i]);
+	}
+
+	reg(0xda4, 0x100);
+	for (i = 0; i < 24; i++) {
+		reg(0xc04 + i * 16, 0x400 + rnd() % 0x2000);	/* pitch */
+		reg(0xc06 + i * 16, (rnd() % 0x8000) & ~1);	/* start */
+	}
+}
+
+// a few random register writes, then the mixing of about 32 lines
+static void step() {
+	int n = rnd() % 6, k, i, ch;
+	unsigned short a;
+	unsigned long cycles;
+
+	if (batch) queued = 0;
+	for (k = 0; k < n; k++) {
+		ch = rnd() % 24;
+		switch (rnd() % 12) {
+		case 0: reg(0xc00 + ch * 16, voicevol(ch, rnd() & 0xffff)); break;
+		case 1: reg(0xc02 + ch * 16, voicevol(ch, rnd() & 0x7fff)); break;
+		case 2: reg(0xc04 + ch * 16, rnd() & 0x3fff); break;
+		case 3:
+			a = rnd() & 0xffff;
+			reg(0xc06 + ch * 16, a > 0xfffc ? 0xfffc : a);
+			if (rnd() % 2) reg(0xda4, a + 1 + rnd() % 4);
+			break;
+		case 4: reg(0xc08 + ch * 16, rnd() & 0xffff); break;
+		case 5: reg(0xc0a + ch * 16, rnd() & 0xffff); break;
+		case 6: reg(0xd88, rnd() & 0xffff); reg(0xd8a, rnd() & 0xff); break;	/* key on */
+		case 7: reg(0xd8c, rnd() & 0xffff); break;				/* key off */
+		case 8:
+			if (rnd() % 8 == 0) reg(0xd90, rnd() & 0xfffe);		/* fmod */
+			if (rnd() % 8 == 0) reg(0xd94, rnd() & 0x3);		/* noise */
+			break;
+		case 9: reg(0xd98, rnd() & 0xffff); break;				/* reverb on */
+		case 10: reg(0xda4, rnd() & 0xffff); break;				/* irq addr */
+		case 11:
+			for (i = 0; i < 588 * 2; i++) cdda[i] = rnd();
+			reg(0xdb0, 0x3fff);
+			reg(0xdb2, 0x3fff);
+			SPUplayCDDAchannel(cdda, sizeof(cdda));
+			break;
+		}
+	}
+
+	cycles = 768 * 32 + rnd() % 100;
+	if (batch) {
+		for (k = 0; k < queued; k++) queue[k].cycle = (k + 1) * cycles / (queued + 1);
+		n = queued;
+		queued = -1;					/* the irq writes again directly */
+		SPUwriteRegisters(queue, n);
+	}
+	SPUasync(cycles);
+}
+
+// a save state, and the bench's own state at that point
+typedef struct {
+	unsigned char *buf;
+	uint32_t size;
+	int call;
+	uint32_t seed, outhash;
+	int irqs;
+	long outsamples;
+} snapshot;
+
+static void save(snapshot *s, int mode, int call) {
+	double t;
+
+	t = now();
+	SPUfreeze(mode, s->buf);
+	s->size = ((uint32_t *)s->buf)[3];
+	s->call = call;
+	s->seed = seed;
+	s->outhash = outhash;
+	s->irqs = irqs;
+	s->outsamples = outsamples;
+	printf("freeze: %s save at call %d, %u bytes, %.0f us\n", mode == 3 ? "delta" : "full", call, s->size, (now() - t) / 1e3);
+}
+
+// load s and run the rest again: returns the checkpoints that differ
+static int resume(snapshot *s, int calls, uint32_t *hash) {
+	int c, bad = 0;
+
+	if (!SPUfreeze(0, s->buf)) {
+		printf("freeze: load of the state from call %d failed\n", s->call);
+		return 1;
+	}
+	seed = s->seed;
+	outhash = s->outhash;
+	irqs = s->irqs;
+	outsamples = s->outsamples;
+
+	for (c = s->call; c < calls; c++) {
+		step();
+		if ((c + 1) % CHECKPOINT == 0 && hash[c / CHECKPOINT] != outhash) bad++;
+	}
+	printf("freeze: resumed from call %d: %s\n", s->call, bad ? "output differs" : "same output");
+
+	return bad;
+}
+
+// one pass over the workload: returns the mixing time in ns, hash gets
+// the output hash of each checkpoint
+static double run(int calls, int randomreverb, uint32_t *hash, const char *wavfile) {
+	snapshot full, delta;
+	uint32_t info[4];
+	double t, total = 0;
+	int c, freeze = freezecheck && hash;
+
+	seed = 12345;
+	irqs = 0;
+	outhash = 2166136261u;
+	outsamples = 0;
+
+	SPUinit();
+	SPUopen();
+	if (wavfile) outfile = FileSndOpen(wavfile);
+	SPUregisterCallback(irq);
+	setupram();
+	setupregs(randomreverb);
+
+	if (freeze) {
+		SPUfreeze(2, info);			/* the most a save takes */
+		full.buf = (unsigned char *)malloc(info[3]);
+		delta.buf = (unsigned char *)malloc(info[3]);
+	}
+
+	for (c = 0; c < calls; c++) {
+		if (freeze && c == calls / 4) save(&full, 1, c);
+		if (freeze && c == calls / 2) save(&delta, 3, c);
+		t = now();
+		step();
+		total += now() - t;
+		if (hash && (c + 1) % CHECKPOINT == 0) hash[c / CHECKPOINT] = outhash;
+	}
+
+	if (outfile) FileSndClose();
+	outfile = 0;
+
+	if (freeze) {
+		freezecheck = resume(&delta, calls, hash) + resume(&full, calls, hash) ? -1 : 1;
+		free(full.buf);
+		free(delta.buf);
+	}
+	SPUclose();
+	SPUshutdown();
+
+	return total;
+}
+
+// the options that change the output, as in the "@" line of a hash file
+static void optionkey(char *key, int randomreverb) {
+	sprintf(key, "i%d r%d%s%s a%d%s", cfginterp, cfgreverb, randomreverb ? " x" : "",
+		cfgmono ? " m" : "", audible, batch ? " b" : "");
+}
+
+static int checkhashes(const char *filename, uint32_t *hash, int n, const char *key) {
+	FILE *f;
+	char line[128];
+	unsigned int h;
+	int point, bad = 0, first = -1, checked = 0, insection = 1;
+
+	f = fopen(filename, "r");
+	if (f == NULL) {
+		perror(filename);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '@') {
+			line[strcspn(line, "\r\n")] = 0;
+			insection = !strcmp(line + 2, key);
+			continue;
+		}
+		if (!insection || sscanf(line, "%d %x", &point, &h) != 2) continue;
+		if (point < 0 || point >= n) continue;
+		checked++;
+		if (hash[point] != h) {
+			if (first < 0) first = point;
+			bad++;
+		}
+	}
+	fclose(f);
+
+	if (!checked) {
+		printf("output hash: nothing for \"%s\" in %s\n", key, filename);
+		return 1;
+	}
+	if (bad) printf("output hash: %d of %d checkpoints differ from %s, first is %d\n", bad, checked, filename, first);
+	else printf("output hash: all %d checkpoints match %s\n", checked, filename);
+
+	return bad;
+}
+
+static void usage() {
+	fprintf(stderr, "usage: spubench [-n calls] [-l loops] [-i interpolation] [-r reverb] [-m] [-x] [-a voices] [-w hashes] [-c hashes] [-o file] [-f] [-b]\n"
+		"\t-n calls\tSPUasync calls of about 32 lines each (default 20000)\n"
+		"\t-l loops\trun the workload this often, the time is the best of all (default 3)\n"
+		"\t-i mode\t\tinterpolation, 0 none ... 3 cubic (default 2)\n"
+		"\t-r mode\t\treverb, 0 off, 1 simple, 2 Neill's (default 2)\n"
+		"\t-m\t\tmono output\n"
+		"\t-x\t\trandom reverb registers instead of the room preset\n"
+		"\t-a voices\tonly the first voices get a volume, the others stay at 0 (default 24)\n"
+		"\t-w file\t\twrite the output hash of each checkpoint to file\n"
+		"\t-c file\t\tcompare the output hashes with file\n"
+		"\t-o file\t\twrite the output of the first loop to file, .wav or raw\n"
+		"\t-f\t\tcheck that loading a full and a delta save state goes on exactly\n"
+		"\t-b\t\tbatch the register writes of each call, with their cycles (SPUwriteRegisters)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	const char *writefile = NULL, *checkfile = NULL, *wavfile = NULL;
+	double t, best = 0;
+	uint32_t *hash;
+	char key[64];
+	long frames;
+	int calls = 20000, loops = 3, randomreverb = 0, bad = 0;
+	int i, n;
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) calls = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc) loops = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-i") && i + 1 < argc) cfginterp = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc) cfgreverb = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-m")) cfgmono = 1;
+		else if (!strcmp(argv[i], "-x")) randomreverb = 1;
+		else if (!strcmp(argv[i], "-a") && i + 1 < argc) audible = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc) writefile = argv[++i];
+		else if (!strcmp(argv[i], "-c") && i + 1 < argc) checkfile = argv[++i];
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc) wavfile = argv[++i];
+		else if (!strcmp(argv[i], "-f")) freezecheck = 1;
+		else if (!strcmp(argv[i], "-b")) batch = 1;
+		else usage();
+	}
+	if (i != argc || calls < CHECKPOINT || loops < 1) usage();
+
+	n = calls / CHECKPOINT;
+	optionkey(key, randomreverb);
+	hash = (uint32_t *)malloc(n * sizeof(uint32_t));
+
+	for (i = 0; i < loops; i++) {
+		t = run(calls, randomreverb, i == 0 ? hash : NULL, i == 0 ? wavfile : NULL);
+		if (i == 0 || t < best) best = t;
+	}
+
+	frames = outsamples / (cfgmono ? 1 : 2);
+	printf("%d calls, interpolation %d, reverb %d%s, %s, %d voices audible%s: %ld samples\n", calls, cfginterp, cfgreverb,
+		randomreverb ? " (random)" : "", cfgmono ? "mono" : "stereo", audible, batch ? ", batched writes" : "", frames);
+	printf("mixing: %.2f ms, %.0f samples/s, %.1fx real time\n", best / 1e6,
+		frames * 1e9 / best, frames * 1e9 / best / 44100);
+
+	if (writefile) {
+		FILE *f = fopen(writefile, "w");
+
+		if (f == NULL) perror(writefile);
+		else {
+			fprintf(f, "@ %s\n", key);
+			for (i = 0; i < n; i++) fprintf(f, "%d %08x\n", i, hash[i]);
+			fclose(f);
+		}
+	}
+	if (checkfile) bad = checkhashes(checkfile, hash, n, key);
+	if (freezecheck < 0) bad++;
+
+	free(hash);
+
+	return bad ? 2 : 0;
+}